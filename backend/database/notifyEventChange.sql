@@ -0,0 +1,23 @@
+-- Raises the cct_<schema>_event notification that the CCT review service's
+-- change listener (listen_for_changes) waits on whenever a schema's events
+-- are inserted or updated.  Run this once per schema, e.g.,
+--
+--   psql -v schema=production -f notifyEventChange.sql
+--
+-- The payload is empty because the service fetches the changed events by
+-- their last update time rather than by identifier.  Postgres delivers
+-- identical notifications raised in one transaction once, so a bulk load
+-- wakes the service once rather than once per row.
+
+CREATE OR REPLACE FUNCTION :"schema".notify_event_change()
+RETURNS trigger AS $$
+BEGIN
+    PERFORM pg_notify('cct_' || TG_TABLE_SCHEMA || '_event', '');
+    RETURN NULL;
+END;
+$$ LANGUAGE plpgsql;
+
+DROP TRIGGER IF EXISTS event_change ON :"schema".event;
+CREATE TRIGGER event_change AFTER INSERT OR UPDATE
+    ON :"schema".event
+    FOR EACH STATEMENT EXECUTE FUNCTION :"schema".notify_event_change();
@@ -3,6 +3,7 @@
 #include "aqmsPostgresClient.hpp"
 #include "postgresql.hpp"
 #include "aqms.hpp"
+#include "events.hpp"
 
 using namespace CCTService;
 
@@ -40,43 +41,6 @@ int64_t getNextSequenceValue(soci::session &session,
     return sequenceValue;
 }
 
-int64_t convertEventIdentifier(const std::string &eventIdentifier)
-{
-    if (eventIdentifier.empty())
-    {   
-        throw std::invalid_argument("Event identifier is empty");
-    }   
-    int64_t identifier{-1};
-    try 
-    {   
-        identifier = std::stol(eventIdentifier);    
-    }   
-    catch (...)
-    {   
-        try
-        {
-            // Might be in form of uu8238239 so pop uu
-            auto temporaryIdentifier = eventIdentifier;
-            if (temporaryIdentifier.size() > 2)
-            {
-                temporaryIdentifier.erase(0, 2); 
-            }
-            identifier = std::stol(temporaryIdentifier);
-        }
-        catch (const std::exception &e) 
-        {
-            throw std::invalid_argument("Could not convert "
-                                      + eventIdentifier + " to an integer");
-        }
-    }   
-    if (identifier < 0)
-    {   
-        throw std::invalid_argument("Could not convert "
-                                  + eventIdentifier + " to an integer");
-    }   
-    return identifier;
-}
-
 std::pair<int, soci::indicator>
     getNumberOfStations(const NetMag &networkMagnitude)
 {
@@ -201,7 +165,7 @@ void AQMSPostgresClient::insertNetworkMagnitude(
     const NetMag &networkMagnitude,
     const bool updatePrefMag)
 {
-    auto identifier = ::convertEventIdentifier(eventIdentifier);
+    auto identifier = CCTService::convertEventIdentifier(eventIdentifier);
     insertNetworkMagnitude(user, identifier, networkMagnitude, updatePrefMag);
 }
 
@@ -510,7 +474,7 @@ void AQMSPostgresClient::updateNetworkMagnitude(
     const NetMag &networkMagnitude,
     const bool updatePrefMag)
 {
-    auto identifier = ::convertEventIdentifier(eventIdentifier);
+    auto identifier = CCTService::convertEventIdentifier(eventIdentifier);
     updateNetworkMagnitude(user, identifier, networkMagnitude,
                            updatePrefMag);
 }
@@ -714,7 +678,7 @@ void AQMSPostgresClient::deleteNetworkMagnitude(
     const std::string &user,
     const std::string &eventIdentifier)
 {
-    auto identifier = ::convertEventIdentifier(eventIdentifier);
+    auto identifier = CCTService::convertEventIdentifier(eventIdentifier);
     deleteNetworkMagnitude(user, identifier);
 }
 
@@ -854,7 +818,7 @@ SELECT epref.bump_version(:evid);
 std::optional<int64_t> AQMSPostgresClient::getMwCodaMagnitudeIdentifier(
     const std::string &eventIdentifier) const
 {
-    auto identifier = ::convertEventIdentifier(eventIdentifier);
+    auto identifier = CCTService::convertEventIdentifier(eventIdentifier);
     return getMwCodaMagnitudeIdentifier(identifier);
 }
 
@@ -900,7 +864,7 @@ WHERE event.evid = :eventIdentifier AND netmag.magtype = :magtype AND netmag.mag
 bool AQMSPostgresClient::mwCodaMagnitudeExists(
     const std::string &eventIdentifier) const
 {
-    auto identifier = ::convertEventIdentifier(eventIdentifier);
+    auto identifier = CCTService::convertEventIdentifier(eventIdentifier);
     return mwCodaMagnitudeExists(identifier);
 }
 
@@ -956,7 +920,7 @@ WHERE event.evid = :eventIdentifier AND netmag.magtype = :magtype AND netmag.mag
 int64_t AQMSPostgresClient::getPreferredOriginIdentifier(
     const std::string &eventIdentifier) const
 {
-    auto identifier = ::convertEventIdentifier(eventIdentifier);
+    auto identifier = CCTService::convertEventIdentifier(eventIdentifier);
     return getPreferredOriginIdentifier(identifier);
   
 }
@@ -0,0 +1,97 @@
+#ifndef CCT_BACKEND_SERVICE_BOUNDED_QUEUE_HPP
+#define CCT_BACKEND_SERVICE_BOUNDED_QUEUE_HPP
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <optional>
+#include <stdexcept>
+namespace CCTService
+{
+/// @name BoundedQueue "boundedQueue.hpp" "boundedQueue.hpp"
+/// @brief A first-in first-out queue connecting pipeline stages.  Producers
+///        block while the queue is full so a fast stage cannot run ahead of a
+///        slow one.  This class is thread-safe.
+/// @copyright Ben Baker (University of Utah) distributed under the MIT license.
+template<typename T>
+class BoundedQueue
+{
+public:
+    /// @brief Creates a queue holding at most capacity items.
+    /// @throws std::invalid_argument if the capacity is 0.
+    explicit BoundedQueue(const size_t capacity) :
+        mCapacity(capacity)
+    {
+        if (capacity == 0)
+        {
+            throw std::invalid_argument("Capacity must be positive");
+        }
+    }
+    /// @brief Adds the item to the back of the queue.  This blocks while the
+    ///        queue is full.
+    /// @result False indicates the queue was closed and the item was not
+    ///         added.
+    bool push(T &&item)
+    {
+        {
+        std::unique_lock lock(mMutex);
+        mNotFull.wait(lock, [this]
+                      {
+                          return mClosed || mItems.size() < mCapacity;
+                      });
+        if (mClosed){return false;}
+        mItems.push_back(std::move(item));
+        }
+        mNotEmpty.notify_one();
+        return true;
+    }
+    /// @result The item at the front of the queue.  This blocks while the
+    ///         queue is empty.  Nothing is returned once the queue is closed
+    ///         and drained.
+    [[nodiscard]] std::optional<T> pop()
+    {
+        std::optional<T> item;
+        {
+        std::unique_lock lock(mMutex);
+        mNotEmpty.wait(lock, [this]
+                       {
+                           return mClosed || !mItems.empty();
+                       });
+        if (mItems.empty()){return std::nullopt;}
+        item = std::move(mItems.front());
+        mItems.pop_front();
+        }
+        mNotFull.notify_one();
+        return item;
+    }
+    /// @brief Wakes the producers and consumers.  Subsequent pushes fail and
+    ///        pops return the remaining items.
+    void close()
+    {
+        {
+        std::scoped_lock lock(mMutex);
+        mClosed = true;
+        }
+        mNotFull.notify_all();
+        mNotEmpty.notify_all();
+    }
+    /// @result The number of queued items.
+    [[nodiscard]] size_t size() const
+    {
+        std::scoped_lock lock(mMutex);
+        return mItems.size();
+    }
+    /// @result The largest number of queued items.
+    [[nodiscard]] size_t capacity() const noexcept
+    {
+        return mCapacity;
+    }
+private:
+    mutable std::mutex mMutex;
+    std::condition_variable mNotFull;
+    std::condition_variable mNotEmpty;
+    std::deque<T> mItems;
+    size_t mCapacity{0};
+    bool mClosed{false};
+};
+}
+#endif
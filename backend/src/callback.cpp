@@ -1,14 +1,15 @@
 #include <string>
 #include <map>
+#include <set>
 #include <cmath>
 #include <iostream>
 #include <functional>
 #include <boost/algorithm/string.hpp>
 #include <nlohmann/json.hpp>
 #include <spdlog/spdlog.h>
-#include <GeographicLib/Geodesic.hpp>
-#include <GeographicLib/Constants.hpp>
 #include "cctPostgresService.hpp"
+#include "statementRegistry.hpp"
+#include "catalogIndex.hpp"
 #include "aqmsPostgresClient.hpp"
 #include "callback.hpp"
 #include "permissions.hpp"
@@ -23,243 +24,197 @@ using namespace CCTService;
 namespace
 {
 
-void distaz(const GeographicLib::Geodesic &geodesic,
-            const std::pair<double, double> &sourceLatitudeAndLongitude,
-            const std::pair<double, double> &stationLatitudeAndLongitude,
-            double &greatCircleDistance,
-            double &distance,
-            double &azimuth,
-            double &backAzimuth)
+/// Parses an origin time given as seconds since the epoch or as an
+/// ISO-8601 string.
+double parseOriginTime(const nlohmann::json &value, const std::string &name)
 {
-    try 
-    {   
-        // These will throw
-        auto sourceLatitude = sourceLatitudeAndLongitude.first;
-        auto sourceLongitude = sourceLatitudeAndLongitude.second;
-        auto stationLatitude = stationLatitudeAndLongitude.first;
-        auto stationLongitude = stationLatitudeAndLongitude.second;
-        // Do calculation
-        //GeographicLib::Geodesic geodesic{GeographicLib::Constants::WGS84_a(),
-        //                                 GeographicLib::Constants::WGS84_f()};
-        greatCircleDistance
-            = geodesic.Inverse(sourceLatitude, sourceLongitude,
-                               stationLatitude, stationLongitude,
-                               distance, azimuth, backAzimuth);
-        // Translate azimuth from [-180,180] to [0,360].
-        if (azimuth < 0){azimuth = azimuth + 360;}
-        // Translate azimuth from [-180,180] to [0,360] then convert to a
-        // back-azimuth by subtracting 180, i.e., +180.
-        backAzimuth = backAzimuth + 180;
-    }   
-    catch (const std::exception &e) 
-    {   
-        throw std::runtime_error("Vincenty failed with: "
-                               + std::string {e.what()});
-    }   
-}
-
-void computeDistanceAndAzimuth(
-    const std::pair<double, double> &sourceLatitudeAndLongitude,
-    const std::map<std::string, std::pair<double, double>> &stationLocations,
-    double &closestDistanceKM,
-    double &gap)
-{
-    // Nothign to do
-    if (stationLocations.empty())
-    {
-        closestDistanceKM =-1;
-        gap =-1;
-        return;
-    }
-    // Compute distance and azimuth for every station
-    GeographicLib::Geodesic geodesic{GeographicLib::Constants::WGS84_a(),
-                                    GeographicLib::Constants::WGS84_f()};
-    closestDistanceKM = std::numeric_limits<double>::max();
-    std::vector<double> backAzimuths;
-    for (const auto &stationLocation : stationLocations)
-    {
-        double greatCircleDistance, distanceMeters, azimuth, backAzimuth;
-        // Throws - if any station fails then the results are shoddy
-        // so this function fails
-        ::distaz(geodesic, 
-                 sourceLatitudeAndLongitude,
-                 stationLocation.second,
-                 greatCircleDistance,
-                 distanceMeters,
-                 azimuth,
-                 backAzimuth);
-        double distanceKM = distanceMeters*1.e-3;
-        closestDistanceKM = std::min(closestDistanceKM, distanceKM);
-        backAzimuths.push_back(backAzimuth);
-    }
-    // Compute the gap
-    gap =-1;
-    if (!backAzimuths.empty())
-    {
-        gap = 360; // One station
-        if (backAzimuths.size() > 1)
-        {
-            gap = 0;
-            std::sort(backAzimuths.begin(), backAzimuths.end());
-            backAzimuths.push_back(backAzimuths[0] + 360);
-            for (int i = 0; i < static_cast<int> (backAzimuths.size() - 1); ++i) 
-            {
-                gap = std::max(gap, backAzimuths.at(i + 1) - backAzimuths.at(i));
-            }
+    if (value.is_number()){return value.template get<double> ();}
+    if (value.is_string())
+    {
+        try
+        {
+            return CCTService::originTimeToEpoch(
+                value.template get<std::string> ());
+        }
+        catch (const std::exception &)
+        {
         }
     }
+    throw BadRequestException("Could not parse " + name);
 }
 
-/*
-std::optional<int> getNumberOfStations(
-    const ::Event &event, const std::string &identifier)
+/// Parses a string or array of strings into a set.
+std::set<std::string> parseStringSet(const nlohmann::json &value,
+                                     const std::string &name)
 {
-    if (event.mFullData.contains("measuredMwDetails"))
+    std::set<std::string> result;
+    if (value.is_string())
+    {
+        result.insert(value.template get<std::string> ());
+    }
+    else if (value.is_array())
     {
-        const auto &measuredMwDetails 
-            = event.mFullData["measuredMwDetails"]; 
-        if (measuredMwDetails.contains(identifier))
+        for (const auto &item : value)
         {
-            const auto &measuredMwDetailsForEvent
-                = measuredMwDetails[identifier];
-            if (measuredMwDetailsForEvent.contains("stationCount"))
+            if (!item.is_string())
             {
-                auto nStations
-                    = measuredMwDetailsForEvent["stationCount"].template
-                      get<int> ();
-                if (nStations > 0){return std::optional<int> (nStations);}
+                throw BadRequestException(name + " must be strings");
             }
+            result.insert(item.template get<std::string> ());
         }
     }
-    return std::nullopt;
+    else
+    {
+        throw BadRequestException(name + " must be a string or array");
+    }
+    return result;
 }
-*/
 
-void getMagnitudeDistanceAzimuthAndNumberOfStations(
-    const ::Event &event, const std::string &identifier,
-    double &magnitude,
-    double &closestDistanceKM,
-    double &azimuthalGap,
-    int &nStations,
-    int &nObservations)
+/// Unpacks the optional filters, sort key, and page cursor of a cctData
+/// request.
+CCTService::CatalogQuery parseCatalogQuery(const nlohmann::json &object)
 {
-    magnitude =-10;
-    closestDistanceKM =-1;
-    azimuthalGap =-1;
-    nStations =-1;
-    nObservations =-1;
-    std::map<std::string, std::pair<double, double>> stationLocations; 
-    std::pair<double, double> eventLocation;
-    bool haveEventLocation{false};
-    if (event.mFullData.contains("measuredMwDetails"))
-    {
-        const auto &measuredMwDetails 
-            = event.mFullData["measuredMwDetails"]; 
-        if (measuredMwDetails.contains(identifier))
-        {
-            const auto &measuredMwDetailsForEvent
-                = measuredMwDetails[identifier];
-            if (!measuredMwDetailsForEvent.contains("mw"))
+    CCTService::CatalogQuery query;
+    if (object.contains("filters"))
+    {
+        const auto &filters = object["filters"];
+        if (!filters.is_object())
+        {
+            throw BadRequestException("filters must be an object");
+        }
+        if (filters.contains("minimumOriginTime"))
+        {
+            query.minimumOriginTime
+                = ::parseOriginTime(filters["minimumOriginTime"],
+                                    "minimumOriginTime");
+        }
+        if (filters.contains("maximumOriginTime"))
+        {
+            query.maximumOriginTime
+                = ::parseOriginTime(filters["maximumOriginTime"],
+                                    "maximumOriginTime");
+        }
+        if (filters.contains("minimumMagnitude"))
+        {
+            if (!filters["minimumMagnitude"].is_number())
             {
-                throw std::runtime_error("mw not set");
+                throw BadRequestException("minimumMagnitude must be a number");
             }
-            magnitude
-                 = measuredMwDetailsForEvent["mw"].template get<double> ();
-            if (measuredMwDetailsForEvent.contains("stationCount"))
+            query.minimumMagnitude
+                = filters["minimumMagnitude"].template get<double> ();
+        }
+        if (filters.contains("maximumMagnitude"))
+        {
+            if (!filters["maximumMagnitude"].is_number())
             {
-                nStations
-                    = measuredMwDetailsForEvent["stationCount"].template
-                      get<int> (); 
+                throw BadRequestException("maximumMagnitude must be a number");
             }
-            if (measuredMwDetailsForEvent.contains("latitude") &&
-                measuredMwDetailsForEvent.contains("longitude"))
+            query.maximumMagnitude
+                = filters["maximumMagnitude"].template get<double> ();
+        }
+        if (filters.contains("reviewStatus"))
+        {
+            query.reviewStatuses
+                = ::parseStringSet(filters["reviewStatus"], "reviewStatus");
+        }
+        if (filters.contains("creationMode"))
+        {
+            query.creationModes
+                = ::parseStringSet(filters["creationMode"], "creationMode");
+        }
+        if (filters.contains("likelyPoorlyConstrained"))
+        {
+            if (!filters["likelyPoorlyConstrained"].is_boolean())
             {
-                auto latitude = measuredMwDetailsForEvent["latitude"].template get<double> ();
-                auto longitude = measuredMwDetailsForEvent["longitude"].template get<double> ();
-                if (latitude >= -90 && latitude <= 90)
-                {
-                    eventLocation = std::pair {latitude, longitude};
-                    //std::cout << latitude << " " << longitude << std::endl;
-                    haveEventLocation = true;
-                }
+                throw BadRequestException(
+                    "likelyPoorlyConstrained must be a boolean");
             }
+            query.likelyPoorlyConstrained
+                = filters["likelyPoorlyConstrained"].template get<bool> ();
         }
     }
-    int observationCounter{0};
-    if (event.mFullData.contains("spectraMeasurements"))
+    if (object.contains("fields"))
+    {
+        query.fields = ::parseStringSet(object["fields"], "fields");
+    }
+    if (object.contains("sortBy"))
     {
-        const auto &spectraMeasurements
-            = event.mFullData["spectraMeasurements"];
-        if (spectraMeasurements.contains(identifier))
+        if (!object["sortBy"].is_string())
         {
-            for (const auto &measurement :
-                 spectraMeasurements[identifier])
-            {
-                if (measurement.contains("pathAndSiteCorrected"))
-                {
-                    if (measurement["pathAndSiteCorrected"].is_number())
-                    {
-                        observationCounter = observationCounter + 1;
-                    }
-                }
-                if (measurement.contains("waveform"))
-                {
-                    const auto &waveform = measurement["waveform"];
-                    if (waveform.contains("stream"))
-                    {
-                        const auto &stream = waveform["stream"];
-                        if (stream.contains("station"))
-                        {
-                            const auto &station = stream["station"];
-                            if (station.contains("latitude") &&
-                                station.contains("longitude") &&
-                                station.contains("networkName") &&
-                                station.contains("stationName"))
-                            {
-                                auto name = station["networkName"].template get<std::string> ()
-                                          + "."
-                                          + station["stationName"].template get<std::string> ();
-                                auto latitude = station["latitude"].template get<double> ();
-                                auto longitude = station["longitude"].template get<double> ();
-                                if (!stationLocations.contains(name) &&
-                                    (latitude >=-90 && latitude <= 90))
-                                {
-                                    stationLocations.insert(std::pair {name, std::pair {latitude, longitude}});
-                                    // std::cout << name <<  " " << latitude << " " << longitude << std::endl;
-                                }
-                            }
-                        }
-                    }
-                }
-            }
+            throw BadRequestException("sortBy must be a string");
+        }
+        auto sortBy = object["sortBy"].template get<std::string> ();
+        if (sortBy == "identifier" || sortBy == "eventIdentifier")
+        {
+            query.sortKey = CCTService::CatalogQuery::SortKey::Identifier;
+        }
+        else if (sortBy == "originTime")
+        {
+            query.sortKey = CCTService::CatalogQuery::SortKey::OriginTime;
+        }
+        else if (sortBy == "authoritativeMagnitude")
+        {
+            query.sortKey
+                = CCTService::CatalogQuery::SortKey::AuthoritativeMagnitude;
+        }
+        else if (sortBy == "cctMagnitude")
+        {
+            query.sortKey = CCTService::CatalogQuery::SortKey::CCTMagnitude;
+        }
+        else if (sortBy == "reviewStatus")
+        {
+            query.sortKey = CCTService::CatalogQuery::SortKey::ReviewStatus;
+        }
+        else
+        {
+            throw BadRequestException("Unhandled sortBy: " + sortBy);
         }
     }
-    if (observationCounter >= 0){nObservations = observationCounter;}
-    // Warning - I guess the mwMeasured details are authorative?
-    if (nStations != stationLocations.size())
+    if (object.contains("sortOrder"))
     {
-        spdlog::warn("Number of stations differs form stationLocations.size()");
+        if (!object["sortOrder"].is_string())
+        {
+            throw BadRequestException("sortOrder must be a string");
+        }
+        auto sortOrder = object["sortOrder"].template get<std::string> ();
+        if (sortOrder == "descending")
+        {
+            query.descending = true;
+        }
+        else if (sortOrder != "ascending")
+        {
+            throw BadRequestException("sortOrder must be ascending or descending");
+        }
     }
-    // Throws - but these aren't essential things so eat the error
-    if (haveEventLocation)
+    // The cursor is bound to the sort so this follows sortBy and sortOrder
+    if (object.contains("cursor"))
     {
+        if (!object["cursor"].is_string())
+        {
+            throw BadRequestException("cursor must be a string");
+        }
         try
         {
-            ::computeDistanceAndAzimuth(eventLocation,
-                                        stationLocations,
-                                        closestDistanceKM,
-                                        azimuthalGap);
+            query.cursor
+                = CCTService::fromCursorToken(
+                      object["cursor"].template get<std::string> (), query);
         }
-        catch (const std::exception &e)
+        catch (const std::invalid_argument &e)
         {
-            spdlog::warn("Failed to get distance/azimuth because " 
-                       + std::string {e.what()});
+            throw BadRequestException("Invalid cursor: "
+                                    + std::string {e.what()});
         }
     }
-    else
+    if (object.contains("pageSize"))
     {
-        spdlog::warn("Could not extract event location from JSON");
+        if (!object["pageSize"].is_number_unsigned() ||
+            object["pageSize"].template get<size_t> () < 1)
+        {
+            throw BadRequestException("pageSize must be a positive integer");
+        }
+        query.pageSize = object["pageSize"].template get<size_t> ();
     }
+    return query;
 }
 
 }
@@ -521,10 +476,93 @@ std::string Callback::operator()(
             throw BadRequestException("Invalid schema: " + schema);
         }
         auto hash = pImpl->mCCTPostgresService->getCurrentHash(schema);
+        auto version = pImpl->mCCTPostgresService->getCurrentVersion(schema);
         nlohmann::json result;
         result["status"] = "success";
         result["request"] = requestType;
         result["hash"] = hash;
+        result["version"] = version;
+        result["epoch"] = pImpl->mCCTPostgresService->getCurrentEpoch(schema);
+        return result.dump();
+    }
+    else if (requestType == "statistics")
+    {
+        if (!object.contains("schema"))
+        {
+            throw BadRequestException("schema not set in JSON request");
+        }
+        auto schema = object["schema"].template get<std::string> ();
+        if (!pImpl->mCCTPostgresService->haveSchema(schema))
+        {
+            throw BadRequestException("Invalid schema: " + schema);
+        }
+        auto statistics = pImpl->mCCTPostgresService->getStatistics(schema);
+        nlohmann::json result;
+        result["status"] = "success";
+        result["request"] = requestType;
+        result["eventCount"] = statistics.eventCount;
+        result["memoryUsage"] = statistics.memoryUsage;
+        result["largestEventMemoryUsage"]
+            = statistics.largestEventMemoryUsage;
+        result["evictedCount"] = statistics.evictedCount;
+        result["version"] = statistics.version;
+        auto cacheStatistics
+            = pImpl->mCCTPostgresService->getEventDataCacheStatistics(schema);
+        auto toJSON = [](const CCTService::CacheStatistics &tier)
+        {
+            nlohmann::json object;
+            object["entries"] = tier.entries;
+            object["bytes"] = tier.bytes;
+            object["capacity"] = tier.capacity;
+            object["hits"] = tier.hits;
+            object["misses"] = tier.misses;
+            object["evictions"] = tier.evictions;
+            return object;
+        };
+        nlohmann::json eventDataCache = toJSON(cacheStatistics.hot);
+        nlohmann::json compressed = toJSON(cacheStatistics.cold);
+        compressed["uncompressedBytes"] = cacheStatistics.coldUncompressedBytes;
+        compressed["compressionRatio"] = cacheStatistics.getCompressionRatio();
+        compressed["decompressions"] = cacheStatistics.decompressions;
+        compressed["meanDecompressionMicroSeconds"]
+            = cacheStatistics.getMeanDecompressionMicroSeconds();
+        compressed["maximumDecompressionMicroSeconds"]
+            = cacheStatistics.maximumDecompressionMicroSeconds;
+        eventDataCache["compressed"] = std::move(compressed);
+        result["eventDataCache"] = std::move(eventDataCache);
+        result["envelopeDataCache"]
+            = toJSON(pImpl->mCCTPostgresService->getEnvelopeDataCacheStatistics(schema));
+        auto poolStatistics
+            = pImpl->mCCTPostgresService->getConnectionPoolStatistics();
+        nlohmann::json connectionPool;
+        connectionPool["size"] = poolStatistics.size;
+        connectionPool["available"] = poolStatistics.available;
+        connectionPool["checkouts"] = poolStatistics.checkouts;
+        connectionPool["timeouts"] = poolStatistics.timeouts;
+        connectionPool["reconnects"] = poolStatistics.reconnects;
+        connectionPool["failedHealthChecks"]
+            = poolStatistics.failedHealthChecks;
+        connectionPool["meanWaitMicroSeconds"]
+            = poolStatistics.getMeanWaitMicroSeconds();
+        connectionPool["maximumWaitMicroSeconds"]
+            = poolStatistics.maximumWaitMicroSeconds;
+        result["connectionPool"] = std::move(connectionPool);
+        nlohmann::json statements = nlohmann::json::object();
+        for (const auto &[name, statementStatistics] :
+             CCTService::getStatementStatistics())
+        {
+            // The statement names are prefixed by the schema
+            if (!name.starts_with(schema + ".")){continue;}
+            nlohmann::json statement;
+            statement["preparations"] = statementStatistics.preparations;
+            statement["executions"] = statementStatistics.executions;
+            statement["meanExecutionMicroSeconds"]
+                = statementStatistics.getMeanExecutionMicroSeconds();
+            statement["maximumExecutionMicroSeconds"]
+                = statementStatistics.maximumExecutionMicroSeconds;
+            statements[name.substr(schema.size() + 1)] = std::move(statement);
+        }
+        result["statements"] = std::move(statements);
         return result.dump();
     }
     else if (requestType == "cctData")
@@ -541,13 +579,65 @@ std::string Callback::operator()(
             spdlog::error(schema + " does not exist");
             throw BadRequestException("Invalid schema: " + schema);
         }
+        auto query = ::parseCatalogQuery(object);
         nlohmann::json result;
-        std::string cctData
-            = pImpl->mCCTPostgresService->lightWeightDataToString(schema, -1); 
+        auto cctData
+            = pImpl->mCCTPostgresService->lightWeightDataToString(schema,
+                                                                  query,
+                                                                  -1); 
         //std::cout << cctData << std::endl;
         result["status"] = "success";
         result["request"] = requestType;
-        result["events"] = std::move(cctData);
+        result["events"] = std::move(cctData.events);
+        result["totalCount"] = cctData.totalCount;
+        if (cctData.nextCursor){result["nextCursor"] = *cctData.nextCursor;}
+        return result.dump();
+    }
+    else if (requestType == "cctDelta")
+    {
+        if (!object.contains("schema"))
+        {
+            throw BadRequestException("schema not set in JSON request");
+        }
+        auto schema = object["schema"].template get<std::string> ();
+        if (!pImpl->mCCTPostgresService->haveSchema(schema))
+        {
+            throw BadRequestException("Invalid schema: " + schema);
+        }
+        // Without a version the client receives a full snapshot
+        uint64_t epoch{0};
+        uint64_t version{0};
+        try
+        {
+            if (object.contains("epoch"))
+            {
+                epoch = object["epoch"].template get<uint64_t> ();
+            }
+            if (object.contains("version"))
+            {
+                version = object["version"].template get<uint64_t> ();
+            }
+        }
+        catch (const std::exception &e)
+        {
+            throw BadRequestException("Invalid epoch or version: "
+                                    + std::string {e.what()});
+        }
+        auto delta
+            = pImpl->mCCTPostgresService->getDelta(schema, epoch, version);
+        nlohmann::json removed = nlohmann::json::array();
+        for (const auto &identifier : delta.removed)
+        {
+            removed.push_back(std::to_string(identifier));
+        }
+        nlohmann::json result;
+        result["status"] = "success";
+        result["request"] = requestType;
+        result["epoch"] = delta.epoch;
+        result["version"] = delta.version;
+        result["isSnapshot"] = delta.isSnapshot;
+        result["events"] = std::move(delta.events);
+        result["removed"] = std::move(removed);
         return result.dump();
     }
     else if (requestType == "eventData")
@@ -574,15 +664,122 @@ std::string Callback::operator()(
         {
             throw BadRequestException("Invalid schema: " + schema);
         }
+        // Named sections and/or JSON Pointers restrict the response to
+        // those subtrees of the document
+        std::map<std::string, std::string> selectors;
+        if (object.contains("sections"))
+        {
+            for (const auto &section :
+                 ::parseStringSet(object["sections"], "sections"))
+            {
+                try
+                {
+                    selectors.insert_or_assign(
+                        section,
+                        CCTService::sectionToJSONPointer(section,
+                                                         eventIdentifier));
+                }
+                catch (const std::exception &e)
+                {
+                    throw BadRequestException(e.what());
+                }
+            }
+        }
+        if (object.contains("pointers"))
+        {
+            for (const auto &pointer :
+                 ::parseStringSet(object["pointers"], "pointers"))
+            {
+                selectors.insert_or_assign(pointer, pointer);
+            }
+        }
+        std::string station;
+        if (object.contains("station"))
+        {
+            station = object["station"].template get<std::string> ();
+        }
+        bool haveEvent{false};
+        try
+        {
+            haveEvent
+                = pImpl->mCCTPostgresService->haveEvent(schema,
+                                                        eventIdentifier);
+        }
+        catch (const std::exception &)
+        {
+            // The database could not be queried so this is not the
+            // client's fault
+            throw std::runtime_error("Server error");
+        }
+        if (!haveEvent)
+        {
+            throw BadRequestException("Invalid event identifier: "
+                                    + eventIdentifier);
+        }
         nlohmann::json result;
         std::string eventData;
         try
         {
-            eventData
-               = pImpl->mCCTPostgresService->heavyWeightDataToString(
+            if (selectors.empty())
+            {
+                eventData
+                   = pImpl->mCCTPostgresService->heavyWeightDataToString(
+                         schema, eventIdentifier, -1);
+            }
+            else
+            {
+                eventData
+                   = pImpl->mCCTPostgresService->heavyWeightDataToString(
+                         schema, eventIdentifier, selectors, station, -1);
+            }
+        }
+        // Only a missing event or malformed pointer is the client's fault;
+        // a connection or database failure propagates as a server error
+        catch (const std::invalid_argument &e)
+        {
+            throw BadRequestException(e.what());
+        }
+        result["status"] = "success";
+        result["request"] = requestType;
+        result["eventIdentifier"] = eventIdentifier;
+        result["data"] = std::move(eventData);
+        return result.dump();
+    }
+    else if (requestType == "eventDetails")
+    {
+        if (!object.contains("schema"))
+        {
+            throw BadRequestException("schema not set in JSON request");
+        }
+        if (!object.contains("eventIdentifier"))
+        {
+            throw BadRequestException(
+                "eventIdentifier not set in JSON request");
+        }
+        spdlog::debug("Performing event details request for "
+                    + credentials.user);
+        auto eventIdentifier
+            = object["eventIdentifier"].template get<std::string> ();
+        if (eventIdentifier.empty())
+        {
+            throw BadRequestException("Event identifier is empty");
+        }
+        auto schema = object["schema"].template get<std::string> (); 
+        if (!pImpl->mCCTPostgresService->haveSchema(schema))
+        {
+            throw BadRequestException("Invalid schema: " + schema);
+        }
+        nlohmann::json result;
+        std::string detailData;
+        try
+        {
+            detailData
+               = pImpl->mCCTPostgresService->detailDataToString(
                      schema, eventIdentifier, -1);
         }
-        catch (const std::exception &e)
+        // Only a missing event is the client's fault; a database failure
+        // propagates as a server error
+        catch (const std::invalid_argument &e)
         {
             throw BadRequestException("Invalid event identifier: "
                                     + eventIdentifier); 
@@ -590,7 +787,7 @@ std::string Callback::operator()(
         result["status"] = "success";
         result["request"] = requestType;
         result["eventIdentifier"] = eventIdentifier;
-        result["data"] = std::move(eventData);
+        result["data"] = std::move(detailData);
         return result.dump();
     }
     else if (requestType == "envelopeData")
@@ -625,7 +822,9 @@ std::string Callback::operator()(
                = pImpl->mCCTPostgresService->envelopeDataToString(
                      schema, eventIdentifier, -1);
         }
-        catch (const std::exception &e)
+        // Only a missing event is the client's fault; a connection or
+        // database failure propagates as a server error
+        catch (const std::invalid_argument &e)
         {
             throw BadRequestException("Invalid event identifier: "
                                     + eventIdentifier);
@@ -662,7 +861,22 @@ std::string Callback::operator()(
         }
         std::string status{"failure"};
         std::string reason;
-        if (!pImpl->mCCTPostgresService->haveEvent(schema, eventIdentifier))
+        bool haveEvent{false};
+        try
+        {
+            haveEvent
+                = pImpl->mCCTPostgresService->haveEvent(schema,
+                                                        eventIdentifier);
+        }
+        catch (const std::exception &)
+        {
+            reason = "Server error";
+        }
+        if (!reason.empty())
+        {
+            spdlog::error("Could not look up " + eventIdentifier);
+        }
+        else if (!haveEvent)
         {
             reason = eventIdentifier + " does not exist";
             spdlog::error(reason);
@@ -675,32 +889,15 @@ std::string Callback::operator()(
             {
 //if (schema == "test")
 //{
-                auto eventDetails
-                    = pImpl->mCCTPostgresService->getEvent(schema,
-                                                           eventIdentifier);
-                //auto nStations
-                //    = ::getNumberOfStations(eventDetails, eventIdentifier);
-                int nStations{-1};
-                int nObservations{-1};
-                double magnitude{-10};
-                double closestDistanceKM{-1};
-                double azimuthalGap{-1};
-                try
-                {
-                    ::getMagnitudeDistanceAzimuthAndNumberOfStations(
-                        eventDetails, eventIdentifier,
-                        magnitude,
-                        closestDistanceKM, 
-                        azimuthalGap,
-                        nStations,
-                        nObservations);
-                }
-                catch (const std::exception &e)
-                {
-                     closestDistanceKM =-1;
-                     azimuthalGap =-1;
-                     spdlog::warn(e.what());
-                }
+                // These were computed when the event was ingested
+                auto netMagInputs
+                    = pImpl->mCCTPostgresService->getNetMagInputs(
+                         schema, eventIdentifier);
+                auto nStations = netMagInputs.nStations;
+                auto nObservations = netMagInputs.nObservations;
+                auto magnitude = netMagInputs.magnitude;
+                auto closestDistanceKM = netMagInputs.closestDistance;
+                auto azimuthalGap = netMagInputs.azimuthalGap;
                 // Figure out the necessary AQMS details
                 auto originIdentifier
                    = pImpl->mAQMSClients->at(schema)
@@ -806,7 +1003,22 @@ std::string Callback::operator()(
         }
         std::string status{"failure"};
         std::string reason;
-        if (!pImpl->mCCTPostgresService->haveEvent(schema, eventIdentifier))
+        bool haveEvent{false};
+        try
+        {
+            haveEvent
+                = pImpl->mCCTPostgresService->haveEvent(schema,
+                                                        eventIdentifier);
+        }
+        catch (const std::exception &)
+        {
+            reason = "Server error";
+        }
+        if (!reason.empty())
+        {
+            spdlog::error("Could not look up " + eventIdentifier);
+        }
+        else if (!haveEvent)
         {
             reason = eventIdentifier + " does not exist";
             spdlog::error(reason);
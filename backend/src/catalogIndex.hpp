@@ -0,0 +1,529 @@
+#ifndef CCT_BACKEND_SERVICE_CATALOG_INDEX_HPP
+#define CCT_BACKEND_SERVICE_CATALOG_INDEX_HPP
+#include <string>
+#include <vector>
+#include <set>
+#include <map>
+#include <optional>
+#include <numeric>
+#include <algorithm>
+#include <functional>
+#include <cmath>
+#include <cstdint>
+#include <bit>
+#include <chrono>
+#include <cstdio>
+#include <limits>
+#include <stdexcept>
+#include "eventModel.hpp"
+#include "chunkedArray.hpp"
+namespace CCTService
+{
+/// @brief Converts an origin time string of the form YYYY-MM-DDTHH:MM:SS.sss
+///        (with an optional trailing Z) to seconds since the epoch (UTC).
+/// @throws std::invalid_argument if the time cannot be parsed.
+[[nodiscard]] inline double originTimeToEpoch(const std::string &originTime)
+{
+    int year{0}, month{0}, day{0}, hour{0}, minute{0};
+    double second{0};
+    auto nParsed = std::sscanf(originTime.c_str(), "%d-%d-%dT%d:%d:%lf",
+                               &year, &month, &day, &hour, &minute, &second);
+    if (nParsed < 3)
+    {
+        throw std::invalid_argument("Could not parse time: " + originTime);
+    }
+    const std::chrono::year_month_day date{std::chrono::year {year},
+                                           std::chrono::month {static_cast<unsigned int> (month)},
+                                           std::chrono::day {static_cast<unsigned int> (day)}};
+    if (!date.ok())
+    {
+        throw std::invalid_argument("Invalid date: " + originTime);
+    }
+    auto days = std::chrono::sys_days {date}.time_since_epoch();
+    return static_cast<double> (std::chrono::seconds {days}.count())
+         + hour*3600.0 + minute*60.0 + second;
+}
+
+/// @brief The position of the last event of a page.  The next page starts
+///        after the event with this sort value and identifier so events
+///        added or removed ahead of it neither repeat nor skip events.
+struct CatalogCursor
+{
+    /// The sort value of the event.  This is not set if the value is
+    /// unknown or the events are sorted by identifier or review status.
+    std::optional<double> value;
+    /// The review status of the event when sorting by review status.
+    std::string text;
+    int64_t identifier{0};
+    [[nodiscard]] bool operator==(const CatalogCursor &) const = default;
+};
+
+/// @brief Defines the filters, sort order, and page of a catalog request.
+struct CatalogQuery
+{
+    enum class SortKey
+    {
+        Identifier,
+        OriginTime,
+        AuthoritativeMagnitude,
+        CCTMagnitude,
+        ReviewStatus
+    };
+    /// Events whose origin time (UTC epoch seconds) is on or after this time.
+    std::optional<double> minimumOriginTime;
+    /// Events whose origin time (UTC epoch seconds) is on or before this time.
+    std::optional<double> maximumOriginTime;
+    /// Events whose authoritative magnitude is at least this value.
+    std::optional<double> minimumMagnitude;
+    /// Events whose authoritative magnitude is at most this value.
+    std::optional<double> maximumMagnitude;
+    /// If not empty then the events must have one of these review
+    /// statuses, e.g., U, A, or R.
+    std::set<std::string> reviewStatuses;
+    /// If not empty then the events must have one of these creation modes.
+    std::set<std::string> creationModes;
+    /// If set then the events' likelyPoorlyConstrained flag must match.
+    std::optional<bool> likelyPoorlyConstrained;
+    /// If not empty then only these fields of each event are returned.
+    /// The eventIdentifier is always returned.
+    std::set<std::string> fields;
+    SortKey sortKey{SortKey::Identifier};
+    bool descending{false};
+    /// If set then the page starts after this event.
+    std::optional<CatalogCursor> cursor;
+    /// The maximum number of events to return.
+    size_t pageSize{std::numeric_limits<size_t>::max()};
+    [[nodiscard]] bool operator==(const CatalogQuery &) const = default;
+};
+
+/// @brief The rows of the events on the requested page.
+struct CatalogQueryResult
+{
+    std::vector<size_t> rows;
+    /// The number of events satisfying the filters.
+    size_t totalCount{0};
+    /// The cursor of the next page (if there is one).
+    std::optional<CatalogCursor> nextCursor;
+};
+
+/// @brief A page of the catalog serialized for the frontend.
+struct CatalogPage
+{
+    std::string events;
+    size_t totalCount{0};
+    /// The opaque token of the next page's cursor (if there is one).
+    std::optional<std::string> nextCursor;
+};
+
+/// @result The opaque token of the cursor.  The token records the sort key
+///         and order of the query so it cannot be used with another sort.
+[[nodiscard]] inline std::string toCursorToken(const CatalogQuery &query,
+                                               const CatalogCursor &cursor)
+{
+    std::string text = std::to_string(static_cast<int> (query.sortKey))
+                     + "|" + (query.descending ? "1" : "0")
+                     + "|" + std::to_string(cursor.identifier) + "|";
+    if (cursor.value)
+    {
+        text = text + std::to_string(std::bit_cast<uint64_t> (*cursor.value));
+    }
+    text = text + "|" + cursor.text;
+    // Hex encode so clients do not depend on the layout
+    constexpr char digits[] = "0123456789abcdef";
+    std::string token;
+    token.reserve(2*text.size());
+    for (const auto &c : text)
+    {
+        auto byte = static_cast<unsigned char> (c);
+        token.push_back(digits[byte >> 4]);
+        token.push_back(digits[byte & 0xF]);
+    }
+    return token;
+}
+
+/// @result The cursor encoded in the token.
+/// @throws std::invalid_argument if the token is malformed or was created
+///         for a different sort key or order than the query's.
+[[nodiscard]] inline CatalogCursor fromCursorToken(const std::string &token,
+                                                   const CatalogQuery &query)
+{
+    auto fromHex = [](const char c) -> int
+    {
+        if (c >= '0' && c <= '9'){return c - '0';}
+        if (c >= 'a' && c <= 'f'){return c - 'a' + 10;}
+        throw std::invalid_argument("Malformed cursor");
+    };
+    if (token.size()%2 != 0){throw std::invalid_argument("Malformed cursor");}
+    std::string text;
+    text.reserve(token.size()/2);
+    for (size_t i = 0; i < token.size(); i = i + 2)
+    {
+        text.push_back(static_cast<char> (16*fromHex(token[i])
+                                        + fromHex(token[i + 1])));
+    }
+    std::vector<std::string> parts;
+    size_t start{0};
+    while (parts.size() < 4)
+    {
+        auto end = text.find('|', start);
+        if (end == std::string::npos)
+        {
+            throw std::invalid_argument("Malformed cursor");
+        }
+        parts.push_back(text.substr(start, end - start));
+        start = end + 1;
+    }
+    CatalogCursor cursor;
+    cursor.text = text.substr(start);
+    try
+    {
+        if (std::stoi(parts[0]) != static_cast<int> (query.sortKey) ||
+            parts[1] != (query.descending ? "1" : "0"))
+        {
+            throw std::invalid_argument(
+                "Cursor was created for a different sort");
+        }
+        cursor.identifier = std::stoll(parts[2]);
+        if (!parts[3].empty())
+        {
+            cursor.value = std::bit_cast<double> (
+                static_cast<uint64_t> (std::stoull(parts[3])));
+        }
+    }
+    catch (const std::out_of_range &)
+    {
+        throw std::invalid_argument("Malformed cursor");
+    }
+    return cursor;
+}
+
+/// @class CatalogIndex "catalogIndex.hpp" "catalogIndex.hpp"
+/// @brief A columnar index of the numeric and categorical summary fields
+///        of the events.  Rows are added, updated, and removed as the
+///        events are ingested so filtering and sorting never has to walk
+///        the JSON.  The rows mirror the rows of the event storage.  Copies
+///        of the index share the columns' unchanged chunks.
+/// @copyright Ben Baker (University of Utah) distributed under the MIT license.
+class CatalogIndex
+{
+public:
+    /// @brief Appends a row for the event with the given summary.
+    void append(const int64_t identifier, const EventSummary &summary)
+    {
+        mIdentifiers.push_back(identifier);
+        mOriginTimes.push_back(0);
+        mAuthoritativeMagnitudes.push_back(0);
+        mCCTMagnitudes.push_back(0);
+        mLikelyPoorlyConstrained.push_back(0);
+        mReviewStatusCodes.push_back(0);
+        mCreationModeCodes.push_back(0);
+        update(mIdentifiers.size() - 1, summary);
+    }
+    /// @brief Updates the given row with the event's summary.
+    /// @throws std::out_of_range if the row does not exist.
+    void update(const size_t row, const EventSummary &summary)
+    {
+        if (row >= mIdentifiers.size())
+        {
+            throw std::out_of_range("Row does not exist");
+        }
+        auto originTime = std::numeric_limits<double>::quiet_NaN();
+        try
+        {
+            originTime = originTimeToEpoch(summary.originTime);
+        }
+        catch (const std::exception &)
+        {
+            // Unknown origin times sort last and never satisfy a time window
+        }
+        mOriginTimes.set(row, originTime);
+        mAuthoritativeMagnitudes.set(row, summary.authoritativeMagnitude);
+        mCCTMagnitudes.set(row, summary.cctMagnitude);
+        mLikelyPoorlyConstrained.set(row,
+                                     summary.likelyPoorlyConstrained ? 1 : 0);
+        mReviewStatusCodes.set(row,
+                               toCode(mReviewStatuses, summary.reviewStatus));
+        mCreationModeCodes.set(row,
+                               toCode(mCreationModes, summary.creationMode));
+    }
+    /// @brief Removes the row.  The last row is moved into its place.
+    void erase(const size_t row)
+    {
+        if (row >= mIdentifiers.size()){return;}
+        auto last = mIdentifiers.size() - 1;
+        if (row != last)
+        {
+            mIdentifiers.set(row, mIdentifiers[last]);
+            mOriginTimes.set(row, mOriginTimes[last]);
+            mAuthoritativeMagnitudes.set(row, mAuthoritativeMagnitudes[last]);
+            mCCTMagnitudes.set(row, mCCTMagnitudes[last]);
+            mLikelyPoorlyConstrained.set(row, mLikelyPoorlyConstrained[last]);
+            mReviewStatusCodes.set(row, mReviewStatusCodes[last]);
+            mCreationModeCodes.set(row, mCreationModeCodes[last]);
+        }
+        mIdentifiers.pop_back();
+        mOriginTimes.pop_back();
+        mAuthoritativeMagnitudes.pop_back();
+        mCCTMagnitudes.pop_back();
+        mLikelyPoorlyConstrained.pop_back();
+        mReviewStatusCodes.pop_back();
+        mCreationModeCodes.pop_back();
+    }
+    /// @brief Removes all rows.
+    void clear() noexcept
+    {
+        mIdentifiers.clear();
+        mOriginTimes.clear();
+        mAuthoritativeMagnitudes.clear();
+        mCCTMagnitudes.clear();
+        mLikelyPoorlyConstrained.clear();
+        mReviewStatusCodes.clear();
+        mCreationModeCodes.clear();
+    }
+    /// @result The number of rows in the index.
+    [[nodiscard]] size_t size() const noexcept
+    {
+        return mIdentifiers.size();
+    }
+    /// @result The origin time of the row in seconds since the epoch.  This
+    ///         is NaN if the origin time could not be parsed.
+    /// @throws std::out_of_range if the row does not exist.
+    [[nodiscard]] double getOriginTime(const size_t row) const
+    {
+        return mOriginTimes.at(row);
+    }
+    /// @result The identifiers of the events on the requested page.
+    [[nodiscard]] CatalogQueryResult query(const CatalogQuery &query) const
+    {
+        CatalogQueryResult result;
+        // Resolve the categorical filters to codes once
+        auto reviewStatusMask = toMask(mReviewStatuses, query.reviewStatuses);
+        auto creationModeMask = toMask(mCreationModes, query.creationModes);
+        // Filter
+        std::vector<size_t> rows;
+        rows.reserve(mIdentifiers.size());
+        for (size_t row = 0; row < mIdentifiers.size(); ++row)
+        {
+            if (query.minimumOriginTime &&
+                !(mOriginTimes[row] >= *query.minimumOriginTime))
+            {
+                continue;
+            }
+            if (query.maximumOriginTime &&
+                !(mOriginTimes[row] <= *query.maximumOriginTime))
+            {
+                continue;
+            }
+            if (query.minimumMagnitude &&
+                !(mAuthoritativeMagnitudes[row] >= *query.minimumMagnitude))
+            {
+                continue;
+            }
+            if (query.maximumMagnitude &&
+                !(mAuthoritativeMagnitudes[row] <= *query.maximumMagnitude))
+            {
+                continue;
+            }
+            if (query.likelyPoorlyConstrained &&
+                (mLikelyPoorlyConstrained[row] == 1) !=
+                *query.likelyPoorlyConstrained)
+            {
+                continue;
+            }
+            if (!query.reviewStatuses.empty() &&
+                !reviewStatusMask[mReviewStatusCodes[row]])
+            {
+                continue;
+            }
+            if (!query.creationModes.empty() &&
+                !creationModeMask[mCreationModeCodes[row]])
+            {
+                continue;
+            }
+            result.totalCount = result.totalCount + 1;
+            if (query.cursor &&
+                !isAfter(row, *query.cursor, query.sortKey, query.descending))
+            {
+                continue;
+            }
+            rows.push_back(row);
+        }
+        if (rows.empty()){return result;}
+        // Sort only as much as is necessary to produce the page
+        auto nEnd = std::min(rows.size(), query.pageSize);
+        auto compare = getComparator(query.sortKey, query.descending);
+        if (nEnd < rows.size())
+        {
+            std::partial_sort(rows.begin(), rows.begin() + nEnd, rows.end(),
+                              compare);
+            result.nextCursor = getCursor(rows[nEnd - 1], query.sortKey);
+        }
+        else
+        {
+            std::sort(rows.begin(), rows.end(), compare);
+        }
+        rows.resize(nEnd);
+        result.rows = std::move(rows);
+        return result;
+    }
+private:
+    [[nodiscard]] const ChunkedArray<double> *
+        getColumn(const CatalogQuery::SortKey sortKey) const noexcept
+    {
+        if (sortKey == CatalogQuery::SortKey::OriginTime)
+        {
+            return &mOriginTimes;
+        }
+        else if (sortKey == CatalogQuery::SortKey::AuthoritativeMagnitude)
+        {
+            return &mAuthoritativeMagnitudes;
+        }
+        else if (sortKey == CatalogQuery::SortKey::CCTMagnitude)
+        {
+            return &mCCTMagnitudes;
+        }
+        return nullptr;
+    }
+    /// The cursor of the row.
+    [[nodiscard]] CatalogCursor getCursor(const size_t row,
+                                          const CatalogQuery::SortKey sortKey) const
+    {
+        CatalogCursor cursor;
+        cursor.identifier = mIdentifiers[row];
+        const auto *column = getColumn(sortKey);
+        if (column && !std::isnan((*column)[row]))
+        {
+            cursor.value = (*column)[row];
+        }
+        if (sortKey == CatalogQuery::SortKey::ReviewStatus)
+        {
+            cursor.text = mReviewStatuses[mReviewStatusCodes[row]];
+        }
+        return cursor;
+    }
+    /// True indicates the row sorts after the cursor.  This must agree with
+    /// the comparator.
+    [[nodiscard]] bool isAfter(const size_t row,
+                               const CatalogCursor &cursor,
+                               const CatalogQuery::SortKey sortKey,
+                               const bool descending) const
+    {
+        auto identifier = mIdentifiers[row];
+        if (const auto *column = getColumn(sortKey))
+        {
+            auto value = (*column)[row];
+            if (!cursor.value)
+            {
+                return std::isnan(value) && identifier > cursor.identifier;
+            }
+            if (std::isnan(value)){return true;} // Unknowns go last
+            if (value == *cursor.value){return identifier > cursor.identifier;}
+            return descending ? value < *cursor.value : value > *cursor.value;
+        }
+        if (sortKey == CatalogQuery::SortKey::ReviewStatus)
+        {
+            const auto &text = mReviewStatuses[mReviewStatusCodes[row]];
+            if (text == cursor.text){return identifier > cursor.identifier;}
+            return descending ? text < cursor.text : text > cursor.text;
+        }
+        return descending ? identifier < cursor.identifier :
+                            identifier > cursor.identifier;
+    }
+    [[nodiscard]] static uint16_t toCode(std::vector<std::string> &dictionary,
+                                         const std::string &value)
+    {
+        auto idx = std::find(dictionary.begin(), dictionary.end(), value);
+        if (idx != dictionary.end())
+        {
+            return static_cast<uint16_t> (std::distance(dictionary.begin(),
+                                                        idx));
+        }
+        if (dictionary.size() >= std::numeric_limits<uint16_t>::max())
+        {
+            throw std::runtime_error("Too many categories");
+        }
+        dictionary.push_back(value);
+        return static_cast<uint16_t> (dictionary.size() - 1);
+    }
+    [[nodiscard]] static std::vector<bool>
+        toMask(const std::vector<std::string> &dictionary,
+               const std::set<std::string> &values)
+    {
+        std::vector<bool> mask(dictionary.size(), false);
+        for (size_t i = 0; i < dictionary.size(); ++i)
+        {
+            mask[i] = values.contains(dictionary[i]);
+        }
+        return mask;
+    }
+    [[nodiscard]] std::function<bool (size_t, size_t)>
+        getComparator(const CatalogQuery::SortKey sortKey,
+                      const bool descending) const
+    {
+        // Ties (and NaNs) are broken by the identifier so paging is stable
+        auto byIdentifier = [this](const size_t lhs, const size_t rhs)
+        {
+            return mIdentifiers[lhs] < mIdentifiers[rhs];
+        };
+        auto byColumn = [byIdentifier](const ChunkedArray<double> &column,
+                                       const bool descending)
+        {
+            return [&column, byIdentifier, descending](const size_t lhs,
+                                                       const size_t rhs)
+            {
+                auto a = column[lhs];
+                auto b = column[rhs];
+                if (std::isnan(a) || std::isnan(b))
+                {
+                    if (std::isnan(a) && std::isnan(b))
+                    {
+                        return byIdentifier(lhs, rhs);
+                    }
+                    return std::isnan(b); // Unknowns go last
+                }
+                if (a == b){return byIdentifier(lhs, rhs);}
+                return descending ? a > b : a < b;
+            };
+        };
+        if (sortKey == CatalogQuery::SortKey::OriginTime)
+        {
+            return byColumn(mOriginTimes, descending);
+        }
+        else if (sortKey == CatalogQuery::SortKey::AuthoritativeMagnitude)
+        {
+            return byColumn(mAuthoritativeMagnitudes, descending);
+        }
+        else if (sortKey == CatalogQuery::SortKey::CCTMagnitude)
+        {
+            return byColumn(mCCTMagnitudes, descending);
+        }
+        else if (sortKey == CatalogQuery::SortKey::ReviewStatus)
+        {
+            return [this, byIdentifier, descending](const size_t lhs,
+                                                    const size_t rhs)
+            {
+                const auto &a = mReviewStatuses[mReviewStatusCodes[lhs]];
+                const auto &b = mReviewStatuses[mReviewStatusCodes[rhs]];
+                if (a == b){return byIdentifier(lhs, rhs);}
+                return descending ? a > b : a < b;
+            };
+        }
+        return [byIdentifier, descending](const size_t lhs, const size_t rhs)
+        {
+            return descending ? byIdentifier(rhs, lhs) : byIdentifier(lhs, rhs);
+        };
+    }
+    // The columns are chunked so copies of the index share the unchanged
+    // rows
+    ChunkedArray<int64_t> mIdentifiers;
+    ChunkedArray<double> mOriginTimes;
+    ChunkedArray<double> mAuthoritativeMagnitudes;
+    ChunkedArray<double> mCCTMagnitudes;
+    ChunkedArray<uint8_t> mLikelyPoorlyConstrained;
+    ChunkedArray<uint16_t> mReviewStatusCodes;
+    ChunkedArray<uint16_t> mCreationModeCodes;
+    std::vector<std::string> mReviewStatuses;
+    std::vector<std::string> mCreationModes;
+};
+}
+#endif
@@ -0,0 +1,438 @@
+#include <string>
+#include <vector>
+#include <map>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "catalogSnapshot.hpp"
+#include "stationNameTable.hpp"
+
+using namespace CCTService;
+
+namespace
+{
+
+constexpr char magic[8]{'C', 'C', 'T', 'S', 'N', 'A', 'P', '\0'};
+/// Increment this when the layout changes.  Older files are then ignored.
+constexpr uint32_t formatVersion{2};
+/// Detects files written on a machine with a different byte order.
+constexpr uint32_t byteOrderMark{0x01020304};
+
+/// FNV-1a digest of the file contents.
+[[nodiscard]] uint64_t checksum(const char *data, const size_t length)
+{
+    uint64_t result{0xcbf29ce484222325ull};
+    for (size_t i = 0; i < length; ++i)
+    {
+        result = (result ^ static_cast<unsigned char> (data[i]))
+                *0x100000001b3ull;
+    }
+    return result;
+}
+
+/// Appends fixed-width values to a byte buffer.
+class Writer
+{
+public:
+    template<typename T>
+    void write(const T value)
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+        mBuffer.append(reinterpret_cast<const char *> (&value), sizeof(T));
+    }
+    void write(const std::string &value)
+    {
+        write(static_cast<uint64_t> (value.size()));
+        mBuffer.append(value);
+    }
+    void write(const std::vector<double> &values)
+    {
+        write(static_cast<uint64_t> (values.size()));
+        mBuffer.append(reinterpret_cast<const char *> (values.data()),
+                       values.size()*sizeof(double));
+    }
+    void write(const std::optional<Spectrum> &spectrum)
+    {
+        write(static_cast<uint8_t> (spectrum ? 1 : 0));
+        if (spectrum)
+        {
+            write(spectrum->frequencies);
+            write(spectrum->values);
+        }
+    }
+    [[nodiscard]] std::string &getBuffer() noexcept
+    {
+        return mBuffer;
+    }
+private:
+    std::string mBuffer;
+};
+
+/// Reads fixed-width values from a byte range.
+class Reader
+{
+public:
+    Reader(const char *begin, const char *end) :
+        mPointer(begin),
+        mEnd(end)
+    {
+    }
+    template<typename T>
+    [[nodiscard]] T read()
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+        require(sizeof(T));
+        T value;
+        std::memcpy(&value, mPointer, sizeof(T));
+        mPointer = mPointer + sizeof(T);
+        return value;
+    }
+    [[nodiscard]] std::string readString()
+    {
+        auto length = read<uint64_t> ();
+        require(length);
+        std::string value(mPointer, length);
+        mPointer = mPointer + length;
+        return value;
+    }
+    [[nodiscard]] std::vector<double> readVector()
+    {
+        auto length = read<uint64_t> ();
+        if (length > static_cast<uint64_t> (mEnd - mPointer)/sizeof(double))
+        {
+            throw std::runtime_error("Snapshot is truncated");
+        }
+        std::vector<double> values(length);
+        std::memcpy(values.data(), mPointer, length*sizeof(double));
+        mPointer = mPointer + length*sizeof(double);
+        return values;
+    }
+    [[nodiscard]] std::optional<Spectrum> readSpectrum()
+    {
+        if (read<uint8_t> () == 0){return std::nullopt;}
+        Spectrum spectrum;
+        spectrum.frequencies = readVector();
+        spectrum.values = readVector();
+        return spectrum;
+    }
+private:
+    void require(const uint64_t length) const
+    {
+        if (length > static_cast<uint64_t> (mEnd - mPointer))
+        {
+            throw std::runtime_error("Snapshot is truncated");
+        }
+    }
+    const char *mPointer{nullptr};
+    const char *mEnd{nullptr};
+};
+
+/// Maps a file read-only and unmaps it on destruction.
+class MappedFile
+{
+public:
+    explicit MappedFile(const std::filesystem::path &fileName)
+    {
+        mDescriptor = ::open(fileName.c_str(), O_RDONLY);
+        if (mDescriptor < 0)
+        {
+            throw std::runtime_error("Could not open " + fileName.string());
+        }
+        struct stat status;
+        if (::fstat(mDescriptor, &status) != 0)
+        {
+            ::close(mDescriptor);
+            throw std::runtime_error("Could not stat " + fileName.string());
+        }
+        mLength = static_cast<size_t> (status.st_size);
+        if (mLength == 0)
+        {
+            ::close(mDescriptor);
+            throw std::runtime_error(fileName.string() + " is empty");
+        }
+        mData = ::mmap(nullptr, mLength, PROT_READ, MAP_PRIVATE,
+                       mDescriptor, 0);
+        if (mData == MAP_FAILED)
+        {
+            ::close(mDescriptor);
+            throw std::runtime_error("Could not map " + fileName.string());
+        }
+        ::madvise(mData, mLength, MADV_SEQUENTIAL);
+    }
+    ~MappedFile()
+    {
+        ::munmap(mData, mLength);
+        ::close(mDescriptor);
+    }
+    [[nodiscard]] const char *data() const noexcept
+    {
+        return static_cast<const char *> (mData);
+    }
+    [[nodiscard]] size_t size() const noexcept
+    {
+        return mLength;
+    }
+    MappedFile(const MappedFile &) = delete;
+    MappedFile& operator=(const MappedFile &) = delete;
+private:
+    void *mData{nullptr};
+    size_t mLength{0};
+    int mDescriptor{-1};
+};
+
+}
+
+/// Pack the catalog
+std::string CCTService::packCatalog(
+    const Events &events,
+    const double lastUpdate,
+    const StationNameTable &stationNames)
+{
+    auto eventList = events.select(CatalogQuery {});
+    // The station identifiers are only meaningful in this process so the
+    // names are written once and the measurements refer to them by index.
+    std::map<int32_t, uint32_t> stationIndices;
+    for (const auto &event : eventList)
+    {
+        for (const auto &station : event->mDetails->stationMeasurements)
+        {
+            stationIndices.try_emplace(
+                station.station,
+                static_cast<uint32_t> (stationIndices.size()));
+        }
+    }
+    std::vector<std::string> names(stationIndices.size());
+    for (const auto &[identifier, index] : stationIndices)
+    {
+        names[index] = stationNames.getName(identifier);
+    }
+    Writer writer;
+    writer.getBuffer().append(magic, sizeof(magic));
+    writer.write(formatVersion);
+    writer.write(byteOrderMark);
+    writer.write(lastUpdate);
+    writer.write(static_cast<uint64_t> (names.size()));
+    for (const auto &name : names){writer.write(name);}
+    writer.write(static_cast<uint64_t> (eventList.size()));
+    for (const auto &event : eventList)
+    {
+        const auto &summary = event->mSummary;
+        writer.write(summary.identifier);
+        writer.write(static_cast<int64_t> (event->mCreationTime.count()));
+        writer.write(event->mLastUpdate);
+        writer.write(summary.originTime);
+        writer.write(summary.latitude);
+        writer.write(summary.longitude);
+        writer.write(summary.depth);
+        writer.write(static_cast<uint8_t> (summary.likelyPoorlyConstrained));
+        writer.write(summary.cctMagnitude);
+        writer.write(summary.cctMagnitudeType);
+        writer.write(summary.authoritativeMagnitude);
+        writer.write(summary.authoritativeMagnitudeType);
+        writer.write(summary.reviewStatus);
+        writer.write(summary.creationMode);
+        writer.write(summary.netMagInputs.magnitude);
+        writer.write(summary.netMagInputs.closestDistance);
+        writer.write(summary.netMagInputs.azimuthalGap);
+        writer.write(static_cast<int32_t> (summary.netMagInputs.nStations));
+        writer.write(static_cast<int32_t> (summary.netMagInputs.nObservations));
+        const auto &details = *event->mDetails;
+        writer.write(details.spectralFit.fit);
+        writer.write(details.spectralFit.bruneLowerBound1);
+        writer.write(details.spectralFit.bruneUpperBound1);
+        writer.write(details.spectralFit.bruneLowerBound2);
+        writer.write(details.spectralFit.bruneUpperBound2);
+        writer.write(static_cast<uint64_t> (details.stationMeasurements.size()));
+        for (const auto &station : details.stationMeasurements)
+        {
+            writer.write(stationIndices.at(station.station));
+            writer.write(station.centerFrequencies);
+            writer.write(station.values);
+            writer.write(station.residuals);
+        }
+    }
+    auto &buffer = writer.getBuffer();
+    writer.write(checksum(buffer.data(), buffer.size()));
+    return std::move(buffer);
+}
+
+/// Unpack the catalog
+UnpackedCatalog CCTService::unpackCatalog(
+    const char *data,
+    const size_t length,
+    StationNameTable &stationNames)
+{
+    if (data == nullptr || length < sizeof(magic) + sizeof(uint64_t) ||
+        std::memcmp(data, magic, sizeof(magic)) != 0)
+    {
+        throw std::runtime_error("Not a packed catalog");
+    }
+    auto payloadLength = length - sizeof(uint64_t);
+    uint64_t expectedChecksum;
+    std::memcpy(&expectedChecksum, data + payloadLength, sizeof(uint64_t));
+    if (checksum(data, payloadLength) != expectedChecksum)
+    {
+        throw std::runtime_error("Packed catalog is corrupt");
+    }
+    Reader reader{data + sizeof(magic), data + payloadLength};
+    if (reader.read<uint32_t> () != formatVersion)
+    {
+        throw std::runtime_error("Unsupported packed catalog format version");
+    }
+    if (reader.read<uint32_t> () != byteOrderMark)
+    {
+        throw std::runtime_error("Packed catalog has a different byte order");
+    }
+    UnpackedCatalog result;
+    result.lastUpdate = reader.read<double> ();
+    auto nStations = reader.read<uint64_t> ();
+    std::vector<int32_t> stationIdentifiers;
+    for (uint64_t i = 0; i < nStations; ++i)
+    {
+        stationIdentifiers.push_back(
+            stationNames.intern(reader.readString()));
+    }
+    auto nEvents = reader.read<uint64_t> ();
+    for (uint64_t i = 0; i < nEvents; ++i)
+    {
+        Event event;
+        auto &summary = event.mSummary;
+        summary.identifier = reader.read<int64_t> ();
+        event.mCreationTime
+            = std::chrono::milliseconds {reader.read<int64_t> ()};
+        event.mLastUpdate = reader.read<double> ();
+        summary.originTime = reader.readString();
+        summary.latitude = reader.read<double> ();
+        summary.longitude = reader.read<double> ();
+        summary.depth = reader.read<double> ();
+        summary.likelyPoorlyConstrained = reader.read<uint8_t> () != 0;
+        summary.cctMagnitude = reader.read<double> ();
+        summary.cctMagnitudeType = reader.readString();
+        summary.authoritativeMagnitude = reader.read<double> ();
+        summary.authoritativeMagnitudeType = reader.readString();
+        summary.reviewStatus = reader.readString();
+        summary.creationMode = reader.readString();
+        summary.netMagInputs.magnitude = reader.read<double> ();
+        summary.netMagInputs.closestDistance = reader.read<double> ();
+        summary.netMagInputs.azimuthalGap = reader.read<double> ();
+        summary.netMagInputs.nStations = reader.read<int32_t> ();
+        summary.netMagInputs.nObservations = reader.read<int32_t> ();
+        EventDetails details;
+        details.spectralFit.fit = reader.readSpectrum();
+        details.spectralFit.bruneLowerBound1 = reader.readSpectrum();
+        details.spectralFit.bruneUpperBound1 = reader.readSpectrum();
+        details.spectralFit.bruneLowerBound2 = reader.readSpectrum();
+        details.spectralFit.bruneUpperBound2 = reader.readSpectrum();
+        auto nMeasurements = reader.read<uint64_t> ();
+        for (uint64_t j = 0; j < nMeasurements; ++j)
+        {
+            StationMeasurements station;
+            station.station = stationIdentifiers.at(reader.read<uint32_t> ());
+            station.centerFrequencies = reader.readVector();
+            station.values = reader.readVector();
+            station.residuals = reader.readVector();
+            details.stationMeasurements.push_back(std::move(station));
+        }
+        event.mDetails
+            = std::make_shared<const EventDetails> (std::move(details));
+        auto identifier = summary.identifier;
+        result.events.push_back(std::pair {identifier, std::move(event)});
+    }
+    return result;
+}
+
+/// Write the snapshot
+void CCTService::writeCatalogSnapshot(
+    const std::filesystem::path &fileName,
+    const Events &events,
+    const double lastUpdate,
+    const StationNameTable &stationNames)
+{
+    auto buffer = packCatalog(events, lastUpdate, stationNames);
+    // Write, flush, then rename so a crash never leaves a partial snapshot
+    auto temporaryFileName = fileName;
+    temporaryFileName += ".tmp";
+    auto descriptor = ::open(temporaryFileName.c_str(),
+                             O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (descriptor < 0)
+    {
+        throw std::runtime_error("Could not open "
+                               + temporaryFileName.string());
+    }
+    size_t nWritten{0};
+    while (nWritten < buffer.size())
+    {
+        auto result = ::write(descriptor, buffer.data() + nWritten,
+                              buffer.size() - nWritten);
+        if (result < 0 && errno == EINTR){continue;}
+        if (result <= 0)
+        {
+            ::close(descriptor);
+            throw std::runtime_error("Could not write "
+                                   + temporaryFileName.string());
+        }
+        nWritten = nWritten + static_cast<size_t> (result);
+    }
+    // The data must be on disk before the rename is or a crash could leave
+    // the new name pointing at an empty file
+    if (::fsync(descriptor) != 0)
+    {
+        ::close(descriptor);
+        throw std::runtime_error("Could not sync "
+                               + temporaryFileName.string());
+    }
+    if (::close(descriptor) != 0)
+    {
+        throw std::runtime_error("Could not close "
+                               + temporaryFileName.string());
+    }
+    std::filesystem::rename(temporaryFileName, fileName);
+    // Make the rename itself durable
+    auto directory = fileName.parent_path();
+    if (directory.empty()){directory = ".";}
+    descriptor = ::open(directory.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (descriptor < 0)
+    {
+        throw std::runtime_error("Could not open " + directory.string());
+    }
+    auto status = ::fsync(descriptor);
+    ::close(descriptor);
+    if (status != 0)
+    {
+        throw std::runtime_error("Could not sync " + directory.string());
+    }
+}
+
+/// Read the snapshot
+CatalogSnapshot CCTService::readCatalogSnapshot(
+    const std::filesystem::path &fileName,
+    std::shared_ptr<StationNameTable> stationNames)
+{
+    if (stationNames == nullptr)
+    {
+        throw std::invalid_argument("Station locations is NULL");
+    }
+    MappedFile file{fileName};
+    UnpackedCatalog unpacked;
+    try
+    {
+        unpacked = unpackCatalog(file.data(), file.size(), *stationNames);
+    }
+    catch (const std::exception &e)
+    {
+        throw std::runtime_error("Could not read " + fileName.string()
+                               + "; failed with: " + std::string {e.what()});
+    }
+    CatalogSnapshot result;
+    result.lastUpdate = unpacked.lastUpdate;
+    result.events = std::make_shared<Events> (stationNames);
+    for (auto &event : unpacked.events)
+    {
+        result.events->insert(std::move(event));
+    }
+    return result;
+}
@@ -0,0 +1,74 @@
+#ifndef CCT_BACKEND_SERVICE_CATALOG_SNAPSHOT_HPP
+#define CCT_BACKEND_SERVICE_CATALOG_SNAPSHOT_HPP
+#include <memory>
+#include <filesystem>
+#include <vector>
+#include <string>
+#include "events.hpp"
+namespace CCTService
+{
+class StationNameTable;
+}
+namespace CCTService
+{
+/// @brief A catalog restored from a snapshot file.
+struct CatalogSnapshot
+{
+    /// The events.
+    std::shared_ptr<Events> events{nullptr};
+    /// The last_update watermark of the events.  Changes after this time
+    /// must be fetched from the database.
+    double lastUpdate{0};
+};
+
+/// @brief The events and watermark unpacked from a packed catalog.
+struct UnpackedCatalog
+{
+    /// The events in the order they were packed.
+    std::vector<std::pair<int64_t, Event>> events;
+    /// The last_update watermark of the events.
+    double lastUpdate{0};
+};
+
+/// @brief Packs the catalog's summaries and details into a compact,
+///        position-independent binary buffer.  The buffer only refers to
+///        its own contents by length so it can be copied or mapped at any
+///        address.
+/// @param[in] events      The catalog.
+/// @param[in] lastUpdate  The last_update watermark of the catalog.
+/// @param[in] stationNames  Resolves the station identifiers to names.
+[[nodiscard]] std::string packCatalog(const Events &events,
+                                      double lastUpdate,
+                                      const StationNameTable &stationNames);
+
+/// @brief Unpacks a buffer written by \c packCatalog().  The stations are
+///        added to the station name table.
+/// @throws std::runtime_error if the buffer was packed by an incompatible
+///         version or is corrupt.
+[[nodiscard]] UnpackedCatalog unpackCatalog(const char *data,
+                                            size_t length,
+                                            StationNameTable &stationNames);
+
+/// @brief Writes the packed catalog to a file.  The file is written to a
+///        temporary file which is synced to disk and then renamed so
+///        readers never see a partial snapshot, even after a crash.
+/// @param[in] fileName    The snapshot file name.
+/// @param[in] events      The catalog.
+/// @param[in] lastUpdate  The last_update watermark of the catalog.
+/// @param[in] stationNames  Resolves the station identifiers to names.
+/// @throws std::runtime_error if the file cannot be written.
+void writeCatalogSnapshot(const std::filesystem::path &fileName,
+                          const Events &events,
+                          double lastUpdate,
+                          const StationNameTable &stationNames);
+
+/// @brief Memory maps and unpacks a snapshot file written by
+///        \c writeCatalogSnapshot().  The stations are added to the
+///        station name table.
+/// @throws std::runtime_error if the file cannot be read, was written by
+///         an incompatible version, or is corrupt.
+[[nodiscard]] CatalogSnapshot
+    readCatalogSnapshot(const std::filesystem::path &fileName,
+                        std::shared_ptr<StationNameTable> stationNames);
+}
+#endif
@@ -6,20 +6,180 @@
 #include <string>
 #include <thread>
 #include <mutex>
+#include <condition_variable>
+#include <utility>
+#include <algorithm>
+#include <memory>
+#include <vector>
+#include <functional>
+#include <future>
+#include <deque>
+#include <array>
+#include <filesystem>
 #include <spdlog/spdlog.h>
 #include <soci/soci.h>
 #include "cctPostgresService.hpp"
 #include "postgresql.hpp"
+#include "connectionPool.hpp"
+#include "changeListener.hpp"
+#include "statementRegistry.hpp"
+#include "workerPool.hpp"
 #include "events.hpp"
+#include "stationNameTable.hpp"
+#include "documentCache.hpp"
+#include "catalogSnapshot.hpp"
+#include "sharedCatalog.hpp"
 #include "unpackCCTJSON.hpp"
 
 using namespace CCTService;
 
+namespace
+{
+/// The event columns unpacked by unpackEventRow.
+const std::string eventColumns{"identifier, CAST(mw_data AS TEXT), cct_magnitude, cct_magnitude_type, authoritative_magnitude, authoritative_magnitude_type, review_status, creation_mode, EXTRACT(epoch FROM last_update)"};
+/// Projects the parts of an event's mw_data document read by the unpackers,
+/// i.e., the event's measuredMwDetails and fitSpectra and the waveform
+/// bands, streams, and corrected values of its spectraMeasurements, so the
+/// rest of the document never leaves the database.  The projection has the
+/// document's shape and keys that are absent from the document are absent
+/// from the projection.
+const std::string projectedFullData{
+R"""((SELECT CAST(
+     (CASE WHEN d->'measuredMwDetails'->k IS NULL THEN CAST('{}' AS JSONB)
+           ELSE jsonb_build_object('measuredMwDetails', jsonb_build_object(k, d->'measuredMwDetails'->k)) END)
+  || (CASE WHEN d->'fitSpectra'->k IS NULL THEN CAST('{}' AS JSONB)
+           ELSE jsonb_build_object('fitSpectra', jsonb_build_object(k, d->'fitSpectra'->k)) END)
+  || (CASE WHEN d->'spectraMeasurements'->k IS NULL THEN CAST('{}' AS JSONB)
+           WHEN jsonb_typeof(d->'spectraMeasurements'->k) <> 'array'
+           THEN jsonb_build_object('spectraMeasurements', jsonb_build_object(k, d->'spectraMeasurements'->k))
+           ELSE jsonb_build_object('spectraMeasurements', jsonb_build_object(k,
+                COALESCE((SELECT jsonb_agg(
+                    CASE WHEN jsonb_typeof(e.m) <> 'object' THEN e.m
+                         ELSE COALESCE((SELECT jsonb_object_agg(f.key,
+                                  CASE WHEN f.key = 'waveform' AND jsonb_typeof(f.value) = 'object'
+                                       THEN COALESCE((SELECT jsonb_object_agg(w.key, w.value)
+                                                        FROM jsonb_each(f.value) AS w
+                                                       WHERE w.key IN ('lowFrequency', 'highFrequency', 'stream')),
+                                                     CAST('{}' AS JSONB))
+                                       ELSE f.value END)
+                                         FROM jsonb_each(e.m) AS f
+                                        WHERE f.key IN ('pathAndSiteCorrected', 'waveform')),
+                                       CAST('{}' AS JSONB)) END
+                    ORDER BY e.o)
+                    FROM jsonb_array_elements(d->'spectraMeasurements'->k) WITH ORDINALITY AS e(m, o)),
+                    CAST('[]' AS JSONB)))) END)
+  AS TEXT)
+  FROM (SELECT CAST(mw_data AS JSONB) AS d, CAST(identifier AS TEXT) AS k) AS p))"""};
+/// The event columns of the projected ingest.
+const std::string projectedEventColumns{"identifier, " + projectedFullData + ", cct_magnitude, cct_magnitude_type, authoritative_magnitude, authoritative_magnitude_type, review_status, creation_mode, EXTRACT(epoch FROM last_update)"};
+/// Orders the events for paging.  This is an integer so the page cursor
+/// compares exactly.
+const std::string lastUpdateKey{"CAST(EXTRACT(epoch FROM last_update)*1000000 AS BIGINT)"};
+
+/// The event columns and paging parameters of a bulk fetch.  These are bound
+/// by reference when the statement is prepared.
+struct EventBatch
+{
+    /// Sizes the columns to the number of rows to fetch.
+    void resize(const size_t batchSize)
+    {
+        identifiers.resize(batchSize);
+        fullData.resize(batchSize);
+        cctMagnitudes.resize(batchSize);
+        cctMagnitudeTypes.resize(batchSize);
+        authoritativeMagnitudes.resize(batchSize);
+        authoritativeMagnitudeTypes.resize(batchSize);
+        reviewStatuses.resize(batchSize);
+        creationModes.resize(batchSize);
+        lastUpdates.resize(batchSize);
+        keys.resize(batchSize);
+        for (auto &columnIndicators : indicators)
+        {
+            columnIndicators.resize(batchSize);
+        }
+    }
+    /// @result The number of rows fetched.
+    [[nodiscard]] size_t size() const noexcept
+    {
+        return identifiers.size();
+    }
+    /// @result True indicates a column of the row is NULL.
+    [[nodiscard]] bool haveNull(const size_t row) const noexcept
+    {
+        for (const auto &columnIndicators : indicators)
+        {
+            if (columnIndicators.at(row) == soci::i_null){return true;}
+        }
+        return false;
+    }
+    std::vector<long long> identifiers;
+    std::vector<std::string> fullData;
+    std::vector<double> cctMagnitudes;
+    std::vector<std::string> cctMagnitudeTypes;
+    std::vector<double> authoritativeMagnitudes;
+    std::vector<std::string> authoritativeMagnitudeTypes;
+    std::vector<std::string> reviewStatuses;
+    std::vector<std::string> creationModes;
+    std::vector<double> lastUpdates;
+    std::vector<long long> keys;
+    /// A NULL fails its row rather than the batch.
+    std::array<std::vector<soci::indicator>, 10> indicators;
+    /// Only rows changed after this UNIX time are fetched.
+    double watermark{0};
+    /// Only rows after this last_update key and identifier are fetched.
+    long long cursorKey{std::numeric_limits<long long>::lowest()};
+    long long cursorIdentifier{std::numeric_limits<long long>::lowest()};
+    /// The number of rows per page.
+    long long limit{0};
+};
+
+/// Prepares a query selecting the event columns and last_update key into
+/// the batch's columns.  If paged then the query's parameters are the
+/// watermark, cursor, and limit.
+[[nodiscard]] soci::statement prepareEventBatch(soci::session &session,
+                                                const std::string &query,
+                                                EventBatch &batch,
+                                                const bool paged)
+{
+    auto &indicators = batch.indicators;
+    soci::details::prepare_temp_type statement = (session.prepare << query);
+    statement, soci::into(batch.identifiers, indicators[0]),
+               soci::into(batch.fullData, indicators[1]),
+               soci::into(batch.cctMagnitudes, indicators[2]),
+               soci::into(batch.cctMagnitudeTypes, indicators[3]),
+               soci::into(batch.authoritativeMagnitudes, indicators[4]),
+               soci::into(batch.authoritativeMagnitudeTypes, indicators[5]),
+               soci::into(batch.reviewStatuses, indicators[6]),
+               soci::into(batch.creationModes, indicators[7]),
+               soci::into(batch.lastUpdates, indicators[8]),
+               soci::into(batch.keys, indicators[9]);
+    if (paged)
+    {
+        statement, soci::use(batch.watermark),
+                   soci::use(batch.cursorKey),
+                   soci::use(batch.cursorIdentifier),
+                   soci::use(batch.limit);
+    }
+    return soci::statement {statement};
+}
+
+/// An event's envelope data as fetched from the database.
+struct CachedEnvelope
+{
+    /// The minified envelope data or empty if there is none.
+    std::string text;
+    /// The UNIX time at which the row was last updated when fetched.
+    double lastUpdate{0};
+};
+
+}
+
 class CCTPostgresService::CCTPostgresServiceImpl
 {
 public:
     CCTPostgresServiceImpl(
         std::unique_ptr<PostgreSQL> &&connection,
+        std::unique_ptr<ConnectionPool> &&connectionPool,
         const std::set<std::string> &schemas)
     {
         if (connection == nullptr)
@@ -30,16 +190,60 @@ public:
         {
             throw std::invalid_argument("Not connected");
         }
+        if (connectionPool == nullptr)
+        {
+            throw std::invalid_argument("Connection pool is NULL");
+        }
         if (schemas.empty()){throw std::invalid_argument("No schemas set");}
         mSchemas = schemas;
         mConnection = std::move(connection);
+        mConnectionPool = std::move(connectionPool);
         for (const auto &schema : mSchemas)
         {
-            mEventsMap.insert( std::pair {schema, Events{}} );
-        }
-        for (const auto &schema : mSchemas)
-        {
-            initialQuery(schema);
+            mSnapshots.try_emplace(schema,
+                                   std::make_shared<const Events> (mStationNames));
+            mPageCache.try_emplace(schema, nullptr);
+            mFullDataCaches.insert(
+                std::pair {schema,
+                           std::make_unique<FullDataCache> (256*1024*1024,
+                                                            256*1024*1024)});
+            mParsedFullDataCaches.insert(
+                std::pair {schema,
+                           std::make_unique<ParsedFullDataCache> (
+                               64*1024*1024,
+                               [](const std::shared_ptr<const ParsedFullData> &parsed)
+                               {
+                                   // A parsed document is several times
+                                   // the size of its text
+                                   return sizeof(ParsedFullData)
+                                        + 4*parsed->text->size();
+                               })});
+            mEvictedEventCaches.insert(
+                std::pair {schema,
+                           std::make_unique<EvictedEventCache> (
+                               16*1024*1024,
+                               [](const std::shared_ptr<const Event> &event)
+                               {
+                                   return sizeof(Event) + event->mMemoryUsage;
+                               })});
+            mMissingEventCaches.insert(
+                std::pair {schema,
+                           std::make_unique<MissingEventCache> (
+                               1024*1024,
+                               [](const std::chrono::steady_clock::time_point &)
+                               {
+                                   // Roughly a list node and a map node
+                                   return size_t {64};
+                               })});
+            mEnvelopeCaches.insert(
+                std::pair {schema,
+                           std::make_unique<EnvelopeCache> (
+                               64*1024*1024,
+                               [](const std::shared_ptr<const CachedEnvelope> &envelope)
+                               {
+                                   return sizeof(CachedEnvelope)
+                                        + envelope->text.capacity();
+                               })});
         }
     }
     ~CCTPostgresServiceImpl()
@@ -50,9 +254,394 @@ public:
     {
         return mRunning;
     }
+    /// Unpacks an event row selected with the event columns.
+    [[nodiscard]] std::pair<int64_t, Event>
+        unpackEventRow(const soci::row &row, double *lastUpdate,
+                       std::string *fullDataText = nullptr)
+    {
+        auto event = unpackEvent(row.get<long long> (0),
+                                 row.get<std::string> (1));
+        auto &summary = event.second.mSummary;
+        summary.cctMagnitude = row.get<double> (2);
+        summary.cctMagnitudeType = row.get<std::string> (3);
+        summary.authoritativeMagnitude = row.get<double> (4);
+        summary.authoritativeMagnitudeType = row.get<std::string> (5);
+        summary.reviewStatus = row.get<std::string> (6);
+        summary.creationMode = row.get<std::string> (7);
+        *lastUpdate = row.get<double> (8);
+        event.second.mLastUpdate = *lastUpdate;
+        if (fullDataText){*fullDataText = row.get<std::string> (1);}
+        return event;
+    }
+    /// The columns of an event row read by a bulk fetch.
+    struct FetchedEvent
+    {
+        int64_t identifier{0};
+        std::string fullData;
+        double cctMagnitude{0};
+        std::string cctMagnitudeType;
+        double authoritativeMagnitude{0};
+        std::string authoritativeMagnitudeType;
+        std::string reviewStatus;
+        std::string creationMode;
+        double lastUpdate{0};
+    };
+    /// An event unpacked and derived from its fetched columns.
+    struct UnpackedEvent
+    {
+        std::pair<int64_t, Event> event;
+        double lastUpdate{0};
+        std::string fullData;
+    };
+    /// Moves a row out of a bulk fetch.
+    [[nodiscard]] static FetchedEvent takeEventRow(EventBatch &batch,
+                                                   const size_t row)
+    {
+        if (batch.haveNull(row))
+        {
+            throw std::runtime_error("Event "
+                                   + std::to_string(batch.identifiers[row])
+                                   + " has a NULL column");
+        }
+        FetchedEvent fetchedEvent;
+        fetchedEvent.identifier = batch.identifiers[row];
+        fetchedEvent.fullData = std::move(batch.fullData[row]);
+        fetchedEvent.cctMagnitude = batch.cctMagnitudes[row];
+        fetchedEvent.cctMagnitudeType = std::move(batch.cctMagnitudeTypes[row]);
+        fetchedEvent.authoritativeMagnitude
+            = batch.authoritativeMagnitudes[row];
+        fetchedEvent.authoritativeMagnitudeType
+            = std::move(batch.authoritativeMagnitudeTypes[row]);
+        fetchedEvent.reviewStatus = std::move(batch.reviewStatuses[row]);
+        fetchedEvent.creationMode = std::move(batch.creationModes[row]);
+        fetchedEvent.lastUpdate = batch.lastUpdates[row];
+        return fetchedEvent;
+    }
+    /// Parses, unpacks, and derives a fetched event.  This is CPU bound and
+    /// runs on the worker pool.
+    [[nodiscard]] UnpackedEvent unpackFetchedEvent(FetchedEvent &&fetchedEvent)
+    {
+        UnpackedEvent result{unpackEvent(fetchedEvent.identifier,
+                                         fetchedEvent.fullData)};
+        auto &summary = result.event.second.mSummary;
+        summary.cctMagnitude = fetchedEvent.cctMagnitude;
+        summary.cctMagnitudeType = std::move(fetchedEvent.cctMagnitudeType);
+        summary.authoritativeMagnitude = fetchedEvent.authoritativeMagnitude;
+        summary.authoritativeMagnitudeType
+            = std::move(fetchedEvent.authoritativeMagnitudeType);
+        summary.reviewStatus = std::move(fetchedEvent.reviewStatus);
+        summary.creationMode = std::move(fetchedEvent.creationMode);
+        result.event.second.mLastUpdate = fetchedEvent.lastUpdate;
+        Events::derive(result.event);
+        result.lastUpdate = fetchedEvent.lastUpdate;
+        result.fullData = std::move(fetchedEvent.fullData);
+        return result;
+    }
+    /// Unpacks the fetched events on the worker pool while the caller
+    /// fetches the next rows.  The unpacked events are published on the
+    /// caller's thread in the order they were fetched.  At most a few events
+    /// per worker are in flight.
+    class OrderedIngest
+    {
+    public:
+        OrderedIngest(CCTPostgresServiceImpl &service,
+                      std::function<void (UnpackedEvent &&)> &&publish) :
+            mService(service),
+            mPublish(std::move(publish))
+        {
+            if (mService.mWorkerPool)
+            {
+                mCapacity = 4*mService.mWorkerPool->size();
+            }
+        }
+        /// Unpacks the event.
+        void push(FetchedEvent &&fetchedEvent)
+        {
+            if (!mService.mWorkerPool)
+            {
+                try
+                {
+                    mPublish(mService.unpackFetchedEvent(std::move(fetchedEvent)));
+                }
+                catch (const std::exception &e)
+                {
+                    spdlog::warn("Failed to unpack event; failed with: "
+                               + std::string {e.what()});
+                }
+                return;
+            }
+            while (mWindow.size() >= mCapacity){publishOldest();}
+            mWindow.push_back(
+                mService.mWorkerPool->submit(
+                    [&service = mService,
+                     fetchedEvent = std::move(fetchedEvent)]() mutable
+                    {
+                        return service.unpackFetchedEvent(std::move(fetchedEvent));
+                    }));
+        }
+        /// Publishes the events in flight.
+        void flush()
+        {
+            while (!mWindow.empty()){publishOldest();}
+        }
+        ~OrderedIngest()
+        {
+            for (auto &future : mWindow)
+            {
+                if (future.valid()){future.wait();}
+            }
+        }
+        OrderedIngest(const OrderedIngest &) = delete;
+        OrderedIngest& operator=(const OrderedIngest &) = delete;
+    private:
+        void publishOldest()
+        {
+            auto future = std::move(mWindow.front());
+            mWindow.pop_front();
+            try
+            {
+                mPublish(future.get());
+            }
+            catch (const std::exception &e)
+            {
+                spdlog::warn("Failed to unpack event; failed with: "
+                           + std::string {e.what()});
+            }
+        }
+        CCTPostgresServiceImpl &mService;
+        std::function<void (UnpackedEvent &&)> mPublish;
+        std::deque<std::future<UnpackedEvent>> mWindow;
+        size_t mCapacity{1};
+    };
+    /// Unpacks the event's summary and details from its mw_data document.
+    /// The database columns of the summary are set by the caller.
+    [[nodiscard]] std::pair<int64_t, Event>
+        unpackEvent(const int64_t identifier, const std::string &fullData)
+    {
+        auto sIdentifier = std::to_string(identifier);
+        // The document is parsed once to fill the typed model and then
+        // discarded
+        auto json = nlohmann::json::parse(fullData);
+        auto summary = ::unpackCCTJSONSummary(json, sIdentifier);
+        auto details
+            = ::unpackCCTJSONDetails(json, sIdentifier, *mStationNames);
+        try
+        {
+            summary.netMagInputs
+                = ::unpackCCTJSONNetMagInputs(json, sIdentifier);
+        }
+        catch (const std::exception &e)
+        {
+            spdlog::warn("Could not compute network magnitude inputs for "
+                       + sIdentifier + "; failed with "
+                       + std::string {e.what()});
+        }
+        return std::pair {identifier,
+                          Event {std::move(summary),
+                                 std::make_shared<const EventDetails>
+                                     (std::move(details))}};
+    }
+    /// Evicts events from the next snapshot per the schema's retention policy.
+    /// The caller holds the publish mutex.
+    void enforceRetentionPolicy(const std::string &schema, Events &events)
+    {
+        auto evicted
+            = events.enforce(mRetentionPolicies[schema],
+                             std::chrono::system_clock::now());
+        if (!evicted.empty())
+        {
+            spdlog::info("Evicted " + std::to_string(evicted.size())
+                       + " events from " + schema);
+        }
+    }
+    /// The schema's snapshot file.
+    [[nodiscard]] std::filesystem::path
+        getSnapshotFileName(const std::string &schema) const
+    {
+        return mSnapshotDirectory / (schema + ".snapshot");
+    }
+    /// Restores the schema's catalog from its snapshot file and, failing
+    /// that, queries it from the database.  A restored catalog is brought
+    /// up to date from its last_update watermark by the poller.
+    void loadCatalog(const std::string &schema)
+    {
+        if (!mSnapshotDirectory.empty() &&
+            std::filesystem::exists(getSnapshotFileName(schema)))
+        {
+            try
+            {
+                auto snapshot = readCatalogSnapshot(getSnapshotFileName(schema),
+                                                    mStationNames);
+                snapshot.events->setJournalCapacity(mJournalCapacity);
+                std::scoped_lock lock(mConnectionMutex, mPublishMutex);
+                enforceRetentionPolicy(schema, *snapshot.events);
+                spdlog::info("Restored "
+                           + std::to_string(snapshot.events->size())
+                           + " events of " + schema + " from snapshot");
+                mWrittenVersions[schema]
+                    = std::pair {snapshot.events->getEpoch(),
+                                 snapshot.events->getVersion()};
+                mSnapshots.at(schema).store(std::move(snapshot.events));
+                mLastUpdateMap[schema] = snapshot.lastUpdate;
+                return;
+            }
+            catch (const std::exception &e)
+            {
+                spdlog::warn("Could not restore " + schema
+                           + " from snapshot; failed with: "
+                           + std::string {e.what()});
+            }
+        }
+        initialQuery(schema);
+    }
+    /// Writes the snapshot files of the catalogs that changed since they
+    /// were last written.
+    void writeSnapshots()
+    {
+        if (mSnapshotDirectory.empty()){return;}
+        for (const auto &schema : mSchemas)
+        {
+            auto [snapshot, lastUpdate] = getSnapshotAndWatermark(schema);
+            if (!snapshot){continue;}
+            std::pair version{snapshot->getEpoch(), snapshot->getVersion()};
+            if (mWrittenVersions.contains(schema) &&
+                mWrittenVersions[schema] == version)
+            {
+                continue;
+            }
+            try
+            {
+                writeCatalogSnapshot(getSnapshotFileName(schema),
+                                     *snapshot, lastUpdate,
+                                     *mStationNames);
+                mWrittenVersions[schema] = version;
+                spdlog::debug("Wrote snapshot of " + schema);
+            }
+            catch (const std::exception &e)
+            {
+                spdlog::warn("Failed to write snapshot of " + schema
+                           + "; failed with: " + std::string {e.what()});
+            }
+        }
+    }
+    /// The published snapshot and its last_update watermark.  The snapshot
+    /// is NULL if the catalog was never loaded.
+    [[nodiscard]] std::pair<std::shared_ptr<const Events>, double>
+        getSnapshotAndWatermark(const std::string &schema)
+    {
+        // The watermark must correspond to the snapshot
+        std::scoped_lock lock(mConnectionMutex);
+        if (!mLastUpdateMap.contains(schema)){return std::pair {nullptr, 0.0};}
+        return std::pair {getSnapshot(schema), mLastUpdateMap[schema]};
+    }
+    /// The schema's shared memory region name.
+    [[nodiscard]] std::string getSharedCatalogName(const std::string &schema) const
+    {
+        return mSharedCatalogName + "_" + schema;
+    }
+    /// Publishes the schema's catalog to shared memory if it changed.
+    void publishSharedCatalog(const std::string &schema)
+    {
+        auto [snapshot, lastUpdate] = getSnapshotAndWatermark(schema);
+        if (!snapshot){return;}
+        std::pair version{snapshot->getEpoch(), snapshot->getVersion()};
+        if (mSharedVersions.contains(schema) &&
+            mSharedVersions[schema] == version)
+        {
+            return;
+        }
+        if (!mPublishers.contains(schema))
+        {
+            mPublishers.insert(
+                std::pair {schema,
+                           std::make_unique<SharedCatalogPublisher>
+                           (getSharedCatalogName(schema),
+                            mSharedCatalogCapacity)});
+            spdlog::info("Publishing " + schema + " to "
+                       + mPublishers.at(schema)->getName());
+        }
+        // Do not retry a catalog that is too big every second
+        mSharedVersions[schema] = version;
+        mPublishers.at(schema)->publish(
+            packCatalog(*snapshot, lastUpdate, *mStationNames),
+            version.first, version.second);
+    }
+    /// Updates the schema's catalog from the publisher's shared memory if
+    /// it changed.  Only the events whose digests changed are applied and
+    /// the catalog then adopts the publisher's epoch and version.
+    void refreshFromSharedCatalog(const std::string &schema)
+    {
+        if (mSubscribers.contains(schema) &&
+            mSubscribers.at(schema)->isStale())
+        {
+            spdlog::info("Shared catalog of " + schema + " was replaced");
+            mSubscribers.erase(schema);
+            mSharedVersions.erase(schema);
+        }
+        if (!mSubscribers.contains(schema))
+        {
+            try
+            {
+                mSubscribers.insert(
+                    std::pair {schema,
+                               std::make_unique<SharedCatalogSubscriber>
+                               (getSharedCatalogName(schema))});
+            }
+            catch (const std::exception &e)
+            {
+                spdlog::debug("Shared catalog of " + schema
+                            + " unavailable; failed with: "
+                            + std::string {e.what()});
+                return;
+            }
+        }
+        const auto &subscriber = *mSubscribers.at(schema);
+        auto version = subscriber.getVersion();
+        if (!version ||
+            (mSharedVersions.contains(schema) &&
+             mSharedVersions[schema] == *version))
+        {
+            return;
+        }
+        auto view = subscriber.read();
+        if (!view){return;}
+        auto unpacked = unpackCatalog(view->packedCatalog.data(),
+                                      view->packedCatalog.size(),
+                                      *mStationNames);
+        // Derive outside of the lock so only the changed events are applied
+        // under it
+        for (auto &event : unpacked.events){Events::derive(event);}
+        std::scoped_lock lock(mConnectionMutex, mPublishMutex);
+        auto next = std::make_shared<Events> (*getSnapshot(schema));
+        auto since = next->getVersion();
+        std::set<int64_t> identifiers;
+        for (auto &event : unpacked.events)
+        {
+            identifiers.insert(event.first);
+            auto current = next->find(event.first);
+            if (current && current->mDigest == event.second.mDigest &&
+                current->mLastUpdate == event.second.mLastUpdate)
+            {
+                continue;
+            }
+            next->update(std::move(event));
+        }
+        auto currentIdentifiers = next->getIdentifiers();
+        for (const auto &identifier : currentIdentifiers)
+        {
+            if (!identifiers.contains(identifier)){next->erase(identifier);}
+        }
+        // Every worker then reports the publisher's epoch and version so a
+        // client's delta is valid whichever worker serves it
+        next->adopt(view->epoch, view->version, since);
+        mSnapshots.at(schema).store(std::move(next));
+        mLastUpdateMap[schema] = unpacked.lastUpdate;
+        mSharedVersions[schema] = std::pair {view->epoch, view->version};
+    }
     void initialQuery(const std::string &schema)
     {
         spdlog::debug("Querying events from " + schema + "...");
+        std::scoped_lock lock(mConnectionMutex);
         if (!mConnection->isConnected())
         {
             spdlog::warn("Reconnecting to CCT postgres");
@@ -63,58 +652,71 @@ public:
             spdlog::warn("CCT postgres connection broken");
             return;
         }
-        auto session
-             = reinterpret_cast<soci::session *> (mConnection->getSession());
-        soci::rowset<soci::row> rows
-            = (session->prepare <<
-                "SELECT identifier, CAST(mw_data AS TEXT), cct_magnitude, cct_magnitude_type, authoritative_magnitude, authoritative_magnitude_type, review_status, creation_mode, EXTRACT(epoch FROM last_update) FROM "
-              + schema + ".event ORDER BY load_date DESC LIMIT 50");
+        const bool projected{mProjectedIngest};
+        const auto &columns
+            = projected ? ::projectedEventColumns : ::eventColumns;
+        auto &statement
+            = mConnection->getStatementRegistry().get(
+                schema + (projected ? ".projectedInitialQuery" :
+                                      ".initialQuery"),
+                [&schema, &columns](soci::session &session,
+                                    PreparedStatement &preparedStatement)
+                {
+                    return ::prepareEventBatch(
+                        session,
+                        "SELECT " + columns + ", " + ::lastUpdateKey
+                      + " FROM " + schema
+                      + ".event ORDER BY load_date DESC LIMIT 50",
+                        preparedStatement.getBuffers<EventBatch> (),
+                        false);
+                });
+        const size_t batchSize{mIngestBatchSize};
+        auto &batch = statement.getBuffers<EventBatch> ();
+        batch.resize(batchSize);
+        statement.execute();
         double newestUpdate = std::numeric_limits<double>::lowest();
-        for (soci::rowset<soci::row>::const_iterator it = rows.begin();
-             it != rows.end();
-             ++it)
+        auto events = std::make_shared<Events> (mStationNames);
+        events->setJournalCapacity(mJournalCapacity);
+        OrderedIngest ingest{*this,
+                             [&](UnpackedEvent &&unpackedEvent)
+                             {
+                                 events->insert(std::move(unpackedEvent.event));
+                                 newestUpdate
+                                     = std::max(unpackedEvent.lastUpdate,
+                                                newestUpdate);
+                             }};
+        while (statement.fetch())
         {
-            const auto &row = *it;
-            try
+            for (size_t row = 0; row < batch.size(); ++row)
             {
-                auto identifier = row.get<long long> (0);
-                auto sIdentifier = std::to_string(identifier);
-                auto json = nlohmann::json::parse(row.get<std::string> (1));
-                auto eventDetails
-                    = ::unpackCCTJSON(json, std::to_string(identifier));
-                eventDetails.emplace("cctMagnitude",
-                                     row.get<double> (2));
-                eventDetails.emplace("cctMagnitudeType",
-                                     row.get<std::string> (3));
-                eventDetails.emplace("authoritativeMagnitude",
-                                     row.get<double> (4));
-                eventDetails.emplace("authoritativeMagnitudeType",
-                                     row.get<std::string> (5));
-                eventDetails.emplace("reviewStatus",
-                                     row.get<std::string> (6));
-                eventDetails.emplace("creationMode",
-                                     row.get<std::string> (7));
-                double lastUpdate = row.get<double> (8);
-                newestUpdate = std::max(lastUpdate, newestUpdate);
-                Event event{eventDetails, json};
+                try
                 {
-                std::scoped_lock lock(mMutex);
-                mEventsMap.at(schema).insert(std::pair {sIdentifier, std::move(event)});
+                    ingest.push(takeEventRow(batch, row));
+                }
+                catch (const std::exception &e)
+                {
+                    spdlog::warn("Failed to unpack event; failed with: "
+                               + std::string {e.what()});
                 }
             }
-            catch (const std::exception &e)
-            {
-                spdlog::warn("Failed to unpack event; failed with: "
-                           + std::string {e.what()});
-            }
+            // The fetch shrinks the columns to the rows it read
+            batch.resize(batchSize);
+        }
+        ingest.flush();
+        {
+        std::scoped_lock publishLock(mPublishMutex);
+        enforceRetentionPolicy(schema, *events);
+        mSnapshots.at(schema).store(std::move(events));
         }
-        mEventsMap.at(schema).generateHash();
         mLastUpdateMap.insert(std::pair {schema, newestUpdate});
         spdlog::debug("Done querying events for schema " + schema);
     }
-    void updateQuery(const std::string &schema)
+    /// Fetches the events changed since the last query.
+    /// @result The number of changed events.
+    [[nodiscard]] size_t updateQuery(const std::string &schema)
     {
         spdlog::debug("Performing update query from " + schema + "...");
+        std::scoped_lock lock(mConnectionMutex);
         if (!mConnection->isConnected())
         {
             spdlog::warn("Reconnecting to CCT postgres");
@@ -123,114 +725,617 @@ public:
         if (!mConnection->isConnected())
         {
             spdlog::critical("CCT postgres connection broken");
-            return;
+            return 0;
         }
         if (!mLastUpdateMap.contains(schema))
         {
             throw std::runtime_error("Can't find last update time for " + schema);
         }
         double newestUpdate = mLastUpdateMap[schema];
-        auto session
-             = reinterpret_cast<soci::session *> (mConnection->getSession());
-        soci::rowset<soci::row> rows
-            = (session->prepare <<
-                "SELECT identifier, CAST(mw_data AS TEXT), cct_magnitude, cct_magnitude_type, authoritative_magnitude, authoritative_magnitude_type, review_status, creation_mode, EXTRACT(epoch FROM last_update) FROM "
-              + schema + ".event "
-              + " WHERE " + schema + ".event.last_update > TO_TIMESTAMP(" + std::to_string(newestUpdate) + ") "
-              + " ORDER BY load_date DESC");
-        bool updated{false};
+        // The changes are fetched a page at a time so a catch-up after an
+        // outage never holds more than a batch of documents
+        const bool projected{mProjectedIngest};
+        const auto &columns
+            = projected ? ::projectedEventColumns : ::eventColumns;
+        auto &statement
+            = mConnection->getStatementRegistry().get(
+                schema + (projected ? ".projectedUpdateQuery" :
+                                      ".updateQuery"),
+                [&schema, &columns](soci::session &session,
+                                    PreparedStatement &preparedStatement)
+                {
+                    return ::prepareEventBatch(
+                        session,
+                        "SELECT " + columns + ", " + ::lastUpdateKey
+                      + " FROM " + schema + ".event "
+                      + " WHERE " + schema + ".event.last_update > TO_TIMESTAMP(:last_update) "
+                      + " AND (" + ::lastUpdateKey + ", identifier) > (:cursor_key, :cursor_identifier) "
+                      + " ORDER BY " + ::lastUpdateKey + ", identifier LIMIT :limit",
+                        preparedStatement.getBuffers<EventBatch> (),
+                        true);
+                });
+        const size_t batchSize{mIngestBatchSize};
+        auto &batch = statement.getBuffers<EventBatch> ();
+        batch.watermark = newestUpdate;
+        batch.cursorKey = std::numeric_limits<long long>::lowest();
+        batch.cursorIdentifier = std::numeric_limits<long long>::lowest();
+        batch.limit = static_cast<long long> (batchSize);
+        auto &fullDataCache = *mFullDataCaches.at(schema);
+        auto &envelopeCache = *mEnvelopeCaches.at(schema);
+        auto &evictedEventCache = *mEvictedEventCaches.at(schema);
+        auto &missingEventCache = *mMissingEventCaches.at(schema);
+        std::vector<std::pair<int64_t, Event>> changedEvents;
         //std::cout << std::setprecision(16) << schema << " " << newestUpdate << std::endl;
-        for (soci::rowset<soci::row>::const_iterator it = rows.begin();
-             it != rows.end();
-             ++it)
+        OrderedIngest ingest{*this,
+                             [&](UnpackedEvent &&unpackedEvent)
+                             {
+                                 auto identifier = unpackedEvent.event.first;
+                                 changedEvents.push_back(
+                                     std::move(unpackedEvent.event));
+                                 newestUpdate
+                                     = std::max(unpackedEvent.lastUpdate,
+                                                newestUpdate);
+                                 // The envelope may have changed with the
+                                 // row.  It is prefetched again if the event
+                                 // is awaiting review.
+                                 envelopeCache.erase(identifier);
+                                 // The event is back in the catalog
+                                 evictedEventCache.erase(identifier);
+                                 missingEventCache.erase(identifier);
+                                 // Refresh the document if an analyst is
+                                 // working with it.  A projected document
+                                 // is incomplete so the full document is
+                                 // fetched again on the next request.
+                                 if (projected)
+                                 {
+                                     fullDataCache.erase(identifier);
+                                 }
+                                 else if (fullDataCache.contains(identifier))
+                                 {
+                                     fullDataCache.insert(
+                                         identifier,
+                                         std::make_shared<const std::string>
+                                         (std::move(unpackedEvent.fullData)));
+                                 }
+                             }};
+        size_t nRows{batchSize};
+        while (nRows == batchSize)
         {
-            const auto &row = *it;
-            try
+            nRows = 0;
+            batch.resize(batchSize);
+            statement.execute();
+            while (statement.fetch())
             {
-                auto identifier = row.get<long long> (0);
-                auto sIdentifier = std::to_string(identifier);
-                auto json = nlohmann::json::parse(row.get<std::string> (1));
-                auto eventDetails
-                    = ::unpackCCTJSON(json, std::to_string(identifier));
-                eventDetails.emplace("cctMagnitude",
-                                     row.get<double> (2));
-                eventDetails.emplace("cctMagnitudeType",
-                                     row.get<std::string> (3));
-                eventDetails.emplace("authoritativeMagnitude",
-                                     row.get<double> (4));
-                eventDetails.emplace("authoritativeMagnitudeType",
-                                     row.get<std::string> (5));
-                eventDetails.emplace("reviewStatus",
-                                     row.get<std::string> (6));
-                eventDetails.emplace("creationMode",
-                                     row.get<std::string> (7));
-                double lastUpdate = row.get<double> (8);
-                //Event event{eventDetails, json};
-                std::pair<std::string, Event>
-                    valueToAddOrInsert{sIdentifier, 
-                                       Event {eventDetails, json}};
+                for (size_t row = 0; row < batch.size(); ++row)
                 {
-                std::scoped_lock lock(mMutex);
-                if (!mEventsMap.at(schema).contains(sIdentifier))
+                    // Advance the cursor even if the row is bad
+                    batch.cursorKey = batch.keys[row];
+                    batch.cursorIdentifier = batch.identifiers[row];
+                    try
+                    {
+                        ingest.push(takeEventRow(batch, row));
+                    }
+                    catch (const std::exception &e)
+                    {
+                        spdlog::warn("Failed to unpack event; failed with: "
+                                   + std::string {e.what()});
+                    }
+                }
+                nRows = nRows + batch.size();
+                batch.resize(batchSize);
+            }
+        }
+        ingest.flush();
+        if (!changedEvents.empty())
+        {
+            // Only the publication excludes accept/reject
+            std::scoped_lock publishLock(mPublishMutex);
+            // Build the next snapshot from the current one.  The copy shares
+            // the current snapshot's chunks and only the chunks holding the
+            // changed events are copied.
+            auto next = std::make_shared<Events> (*getSnapshot(schema));
+            for (auto &changedEvent : changedEvents)
+            {
+                if (!next->contains(changedEvent.first))
                 {
-                    spdlog::info("Adding " + sIdentifier);
-                    mEventsMap.at(schema).insert(std::move(valueToAddOrInsert));
+                    spdlog::info("Adding "
+                               + std::to_string(changedEvent.first));
                 }
                 else
                 {
-                    spdlog::info("Updating " + sIdentifier);
-                    mEventsMap[schema].update(std::move(valueToAddOrInsert));
+                    spdlog::info("Updating "
+                               + std::to_string(changedEvent.first));
+                }
+                next->update(std::move(changedEvent));
+            }
+            enforceRetentionPolicy(schema, *next);
+            mSnapshots.at(schema).store(std::move(next));
+            mLastUpdateMap[schema] = newestUpdate;
+        }
+        return changedEvents.size();
+    }
+    /// Sets the retention policy and applies it to the current snapshot.
+    void setRetentionPolicy(const std::string &schema,
+                            const RetentionPolicy &policy)
+    {
+        std::scoped_lock lock(mPublishMutex);
+        mRetentionPolicies[schema] = policy;
+        auto next = std::make_shared<Events> (*getSnapshot(schema));
+        enforceRetentionPolicy(schema, *next);
+        mSnapshots.at(schema).store(std::move(next));
+    }
+    /// Fetches an event that is not in memory from the database.
+    [[nodiscard]] std::shared_ptr<const Event>
+        fetchEvent(const std::string &schema, const int64_t eventIdentifier)
+    {
+        auto connection = mConnectionPool->checkout();
+        auto &statement
+            = connection->getStatementRegistry().get(
+                schema + ".fetchEvent",
+                [&schema](soci::session &session,
+                          PreparedStatement &preparedStatement)
+                {
+                    return soci::statement {
+                        (session.prepare <<
+                            "SELECT " + ::eventColumns + " FROM "
+                          + schema + ".event WHERE "
+                          + schema + ".event.identifier = :identifier LIMIT 1",
+                         soci::use(preparedStatement.identifier),
+                         soci::into(preparedStatement.row))};
+                });
+        statement.identifier = static_cast<long long> (eventIdentifier);
+        statement.execute();
+        while (statement.fetch())
+        {
+            double lastUpdate;
+            std::string fullData;
+            auto event = unpackEventRow(statement.row, &lastUpdate, &fullData);
+            mFullDataCaches.at(schema)->insert(
+                eventIdentifier,
+                std::make_shared<const std::string> (std::move(fullData)));
+            // Set the fragment, digest, and memory usage like any other
+            // event
+            Events::derive(event);
+            auto result
+                = std::make_shared<const Event> (std::move(event.second));
+            mEvictedEventCaches.at(schema)->insert(eventIdentifier, result);
+            return result;
+        }
+        return nullptr;
+    }
+    /// Fetches the events' documents from the database into the cache.
+    void fetchFullData(const std::string &schema,
+                       const std::vector<int64_t> &eventIdentifiers,
+                       PostgreSQL &connection)
+    {
+        if (eventIdentifiers.empty()){return;}
+        // Bind the identifiers as a Postgres array so the statement has
+        // one shape regardless of the number of events
+        std::string identifierArray{"{"};
+        for (const auto &identifier : eventIdentifiers)
+        {
+            if (identifierArray.size() > 1){identifierArray += ",";}
+            identifierArray += std::to_string(identifier);
+        }
+        identifierArray += "}";
+        auto &statement
+            = connection.getStatementRegistry().get(
+                schema + ".fetchFullData",
+                [&schema](soci::session &session,
+                          PreparedStatement &preparedStatement)
+                {
+                    return soci::statement {
+                        (session.prepare <<
+                            "SELECT identifier, CAST(mw_data AS TEXT) FROM "
+                          + schema + ".event WHERE "
+                          + schema + ".event.identifier = ANY(CAST(:identifiers AS BIGINT[]))",
+                         soci::use(preparedStatement.text),
+                         soci::into(preparedStatement.row))};
+                });
+        statement.text = std::move(identifierArray);
+        statement.execute();
+        auto &fullDataCache = *mFullDataCaches.at(schema);
+        while (statement.fetch())
+        {
+            int64_t identifier = statement.row.get<long long> (0);
+            fullDataCache.insert(
+                identifier,
+                std::make_shared<const std::string>
+                    (statement.row.get<std::string> (1)));
+        }
+    }
+    /// Fetches the events' envelope data from the database into the cache.
+    /// The envelopes are minified once here so requests are served the
+    /// cached text as is.  Missing envelopes are cached as empty.  Each
+    /// envelope is cached with its row's last update so a fill that raced
+    /// a newer update of the row is recognized as stale.
+    /// @result The fetched envelopes.  These may not all fit in the cache.
+    std::map<int64_t, std::shared_ptr<const CachedEnvelope>>
+        fetchEnvelopeData(const std::string &schema,
+                          const std::vector<int64_t> &eventIdentifiers,
+                          PostgreSQL &connection)
+    {
+        std::map<int64_t, std::shared_ptr<const CachedEnvelope>> result;
+        if (eventIdentifiers.empty()){return result;}
+        std::string identifierArray{"{"};
+        for (const auto &identifier : eventIdentifiers)
+        {
+            if (identifierArray.size() > 1){identifierArray += ",";}
+            identifierArray += std::to_string(identifier);
+        }
+        identifierArray += "}";
+        auto &statement
+            = connection.getStatementRegistry().get(
+                schema + ".fetchEnvelopeData",
+                [&schema](soci::session &session,
+                          PreparedStatement &preparedStatement)
+                {
+                    return soci::statement {
+                        (session.prepare <<
+                            "SELECT identifier, CAST(envelope_data AS TEXT), EXTRACT(epoch FROM last_update) FROM "
+                          + schema + ".event WHERE "
+                          + schema + ".event.identifier = ANY(CAST(:identifiers AS BIGINT[]))",
+                         soci::use(preparedStatement.text),
+                         soci::into(preparedStatement.row))};
+                });
+        statement.text = std::move(identifierArray);
+        statement.execute();
+        auto &envelopeCache = *mEnvelopeCaches.at(schema);
+        while (statement.fetch())
+        {
+            int64_t identifier = statement.row.get<long long> (0);
+            std::string envelopeData;
+            if (statement.row.get_indicator(1) != soci::i_null)
+            {
+                try
+                {
+                    envelopeData
+                        = nlohmann::json::parse(
+                              statement.row.get<std::string> (1)).dump(-1);
                 }
-                mEventsMap.at(schema).generateHash();
+                catch (const std::exception &e)
+                {
+                    spdlog::warn("Failed to unpack envelope data for "
+                               + std::to_string(identifier));
+                    envelopeData.clear();
                 }
-                newestUpdate = std::max(lastUpdate, newestUpdate);
-                updated = true;
             }
-            catch (const std::exception &e)
+            auto lastUpdate = statement.row.get<double> (2);
+            auto envelope
+                = std::make_shared<const CachedEnvelope>
+                  (CachedEnvelope {std::move(envelopeData), lastUpdate});
+            envelopeCache.insert(identifier, envelope);
+            result.insert_or_assign(identifier, std::move(envelope));
+        }
+        return result;
+    }
+    /// The event's mw_data document from the cache or, failing that, from
+    /// the database.
+    [[nodiscard]] std::shared_ptr<const std::string>
+        getFullData(const std::string &schema, const int64_t eventIdentifier)
+    {
+        auto &fullDataCache = *mFullDataCaches.at(schema);
+        auto fullData = fullDataCache.get(eventIdentifier);
+        if (fullData){return fullData;}
+        {
+        auto connection = mConnectionPool->checkout();
+        fetchFullData(schema, std::vector<int64_t> {eventIdentifier},
+                      *connection);
+        }
+        // The document could be larger than the cache
+        fullData = fullDataCache.get(eventIdentifier);
+        if (fullData){return fullData;}
+        spdlog::warn("Could not cache document of "
+                   + std::to_string(eventIdentifier));
+        return nullptr;
+    }
+    /// Prefetches the documents of the newest unreviewed events.
+    void prefetchFullData(const std::string &schema)
+    {
+        if (mPrefetchCount == 0){return;}
+        CatalogQuery query;
+        query.sortKey = CatalogQuery::SortKey::OriginTime;
+        query.descending = true;
+        auto &fullDataCache = *mFullDataCaches.at(schema);
+        auto &envelopeCache = *mEnvelopeCaches.at(schema);
+        std::vector<int64_t> eventIdentifiers;
+        std::vector<int64_t> envelopeIdentifiers;
+        size_t nUnreviewed{0};
+        for (const auto &event : getSnapshot(schema)->select(query))
+        {
+            if (nUnreviewed >= mPrefetchCount){break;}
+            const auto &reviewStatus = event->mSummary.reviewStatus;
+            if (reviewStatus == "A" || reviewStatus == "R"){continue;}
+            nUnreviewed = nUnreviewed + 1;
+            if (!fullDataCache.contains(event->mSummary.identifier))
             {
-                spdlog::warn("Failed to unpack event; failed with: "
-                           + std::string {e.what()});
+                eventIdentifiers.push_back(event->mSummary.identifier);
+            }
+            if (!envelopeCache.contains(event->mSummary.identifier))
+            {
+                envelopeIdentifiers.push_back(event->mSummary.identifier);
             }
         }
-        if (updated)
+        if (!eventIdentifiers.empty() || !envelopeIdentifiers.empty())
         {
-            mLastUpdateMap[schema] = newestUpdate;
+            spdlog::debug("Prefetching "
+                        + std::to_string(eventIdentifiers.size())
+                        + " documents and "
+                        + std::to_string(envelopeIdentifiers.size())
+                        + " envelopes from " + schema);
+            // This is the poller so use its connection
+            std::scoped_lock lock(mConnectionMutex);
+            if (!mConnection->isConnected())
+            {
+                spdlog::warn("Reconnecting to CCT postgres");
+                mConnection->connect();
+            }
+            if (!mConnection->isConnected())
+            {
+                spdlog::critical("CCT postgres connection broken");
+                return;
+            }
+            fetchFullData(schema, eventIdentifiers, *mConnection);
+            fetchEnvelopeData(schema, envelopeIdentifiers, *mConnection);
+        }
+    }
+    /// Finds the event in the catalog, the recently fetched evicted events,
+    /// and, failing those, in the database.  An event the database does not
+    /// have is remembered for a while so repeated requests for bogus or
+    /// deleted identifiers do not each cost a query.
+    /// @result The event or NULL if it does not exist.
+    /// @throws std::runtime_error if the database cannot be queried.
+    [[nodiscard]] std::shared_ptr<const Event>
+        findEvent(const std::string &schema, const int64_t eventIdentifier)
+    {
+        auto event = getSnapshot(schema)->find(eventIdentifier);
+        if (event){return event;}
+        auto evictedEvent = mEvictedEventCaches.at(schema)->get(eventIdentifier);
+        if (evictedEvent){return *evictedEvent;}
+        auto &missingEventCache = *mMissingEventCaches.at(schema);
+        auto missingSince = missingEventCache.get(eventIdentifier);
+        auto now = std::chrono::steady_clock::now();
+        if (missingSince)
+        {
+            if (now - *missingSince < mMissingEventLifetime){return nullptr;}
+            missingEventCache.erase(eventIdentifier);
+        }
+        spdlog::debug("Fetching evicted event "
+                    + std::to_string(eventIdentifier) + " from " + schema);
+        auto fetchedEvent = fetchEvent(schema, eventIdentifier);
+        if (!fetchedEvent)
+        {
+            [[maybe_unused]] auto evicted
+                = missingEventCache.insert(eventIdentifier, now);
         }
+        return fetchedEvent;
     }
     void start()
     {
         stop();
+        if (!mWorkerPool)
+        {
+            size_t nThreads = mIngestThreads;
+            if (nThreads == 0)
+            {
+                nThreads = std::max(1U, std::thread::hardware_concurrency());
+            }
+            mWorkerPool = std::make_unique<WorkerPool> (nThreads, 4*nThreads);
+        }
+        if (!mLoaded)
+        {
+            for (const auto &schema : mSchemas)
+            {
+                if (mSharedCatalogMode == SharedCatalogMode::Subscribe)
+                {
+                    refreshFromSharedCatalog(schema);
+                }
+                else
+                {
+                    loadCatalog(schema);
+                }
+            }
+            mLoaded = true;
+        }
         setRunning(true);
         mThread = std::thread(&CCTPostgresServiceImpl::run, this);
     }
+    /// Polls the schemas until stopped.  A schema's poll interval drops to
+    /// the minimum while its events are changing and doubles, up to the
+    /// query interval, while they are not.  Refresh requests and change
+    /// notifications wake the poller immediately.
     void run()
     {
+        using Clock = std::chrono::steady_clock;
+        std::map<std::string, PollSchedule> schedules;
+        for (const auto &schema : mSchemas)
+        {
+            schedules.insert(std::pair {schema,
+                                        PollSchedule {mMinimumQueryInterval,
+                                                      Clock::now()}});
+        }
+        auto nextSnapshotWrite = Clock::now();
+        // Polling should never find changes the listener has not heard
+        // about.  The first pass is skipped since it catches up on changes
+        // made before the listener started.
+        bool checkNotifications{mChangeListener != nullptr &&
+                                mSharedCatalogMode != SharedCatalogMode::Subscribe};
+        bool firstPass{true};
+        bool polledChanges{false};
         while (isRunning())
         {
-            auto now 
-                = std::chrono::duration_cast<std::chrono::seconds> (
-                    std::chrono::system_clock::now().time_since_epoch());
-            if (now > mLastQuery + mQueryInterval)
+            // Notifications of the polled changes were drained by the wait
+            if (checkNotifications && polledChanges)
             {
-                // Perform update query
-                for (const auto &schema : mSchemas)
+                if (mChangeListener->getNumberOfNotifications() == 0)
                 {
-                    try
+                    spdlog::warn(
+                        "Polling found changed events but no change notification has been received; "
+                        "check that database/notifyEventChange.sql was run on each schema");
+                }
+                checkNotifications = false;
+            }
+            auto schemas = takeRefreshRequests();
+            for (const auto &schedule : schedules)
+            {
+                if (Clock::now() >= schedule.second.nextQuery)
+                {
+                    schemas.insert(schedule.first);
+                }
+            }
+            for (const auto &schema : schemas)
+            {
+                if (!isRunning()){break;}
+                auto &schedule = schedules.at(schema);
+                if (refresh(schema) > 0)
+                {
+                    schedule.interval = mMinimumQueryInterval;
+                    if (!firstPass){polledChanges = true;}
+                }
+                else
+                {
+                    schedule.interval = std::min(2*schedule.interval,
+                                                 mQueryInterval);
+                }
+                schedule.nextQuery = Clock::now() + schedule.interval;
+            }
+            firstPass = false;
+            for (const auto &schema : mSchemas)
+            {
+                try
+                {
+                    if (mSharedCatalogMode == SharedCatalogMode::Publish)
                     {
-                        updateQuery(schema); 
+                        publishSharedCatalog(schema);
                     }
-                    catch (const std::exception &e)
+                    else if (mSharedCatalogMode
+                             == SharedCatalogMode::Subscribe)
+                    {
+                        refreshFromSharedCatalog(schema);
+                    }
+                }
+                catch (const std::exception &e)
+                {
+                    spdlog::error("Failed to share catalog of " + schema
+                                + "; failed with "
+                                + std::string {e.what()});
+                }
+            }
+            if (Clock::now() >= nextSnapshotWrite)
+            {
+                writeSnapshots();
+                nextSnapshotWrite = Clock::now() + mSnapshotInterval;
+            }
+            // Sleep until the next scheduled task
+            auto deadline = nextSnapshotWrite;
+            for (const auto &schedule : schedules)
+            {
+                deadline = std::min(schedule.second.nextQuery, deadline);
+            }
+            if (mSharedCatalogMode != SharedCatalogMode::Disabled)
+            {
+                deadline = std::min(Clock::now() + std::chrono::seconds {1},
+                                    deadline);
+            }
+            waitUntil(deadline);
+        }
+    }
+    /// Sleeps until the deadline, a refresh request, a change notification,
+    /// or a stop request.
+    void waitUntil(const std::chrono::steady_clock::time_point &deadline)
+    {
+        if (mChangeListener &&
+            mSharedCatalogMode != SharedCatalogMode::Subscribe)
+        {
+            {
+            std::scoped_lock lock(mWakeMutex);
+            if (!mRunning || !mRefreshRequests.empty()){return;}
+            }
+            // Sleep on the listener's socket so changes are fetched as soon
+            // as they are committed.  Requests interrupt the wait.
+            try
+            {
+                auto timeout
+                    = std::chrono::duration_cast<std::chrono::milliseconds>
+                      (deadline - std::chrono::steady_clock::now());
+                auto channels
+                    = mChangeListener->wait(
+                         std::max(timeout, std::chrono::milliseconds {0}));
+                std::scoped_lock lock(mWakeMutex);
+                for (const auto &schema : mSchemas)
+                {
+                    if (channels.contains(getChangeChannel(schema)))
                     {
-                        spdlog::error("Failed to perform update query on " + schema
-                                    + "; failed with "
-                                    + std::string {e.what()});
+                        spdlog::debug("Change notification from " + schema);
+                        mRefreshRequests.insert(schema);
                     }
                 }
-                mLastQuery = now;
+                return;
+            }
+            catch (const std::exception &e)
+            {
+                spdlog::error("Failed to wait for change notifications; failed with "
+                            + std::string {e.what()});
+            }
+            // Don't spin on a broken listener
+            std::unique_lock lock(mWakeMutex);
+            mWakeCondition.wait_for(lock, std::chrono::seconds {1},
+                                    [this]()
+                                    {
+                                        return !mRunning;
+                                    });
+            return;
+        }
+        std::unique_lock lock(mWakeMutex);
+        mWakeCondition.wait_until(lock, deadline,
+                                  [this]()
+                                  {
+                                      return !mRunning ||
+                                             !mRefreshRequests.empty();
+                                  });
+    }
+    /// Asks the poller to refresh the schema as soon as possible.
+    void requestRefresh(const std::string &schema)
+    {
+        {
+        std::scoped_lock lock(mWakeMutex);
+        mRefreshRequests.insert(schema);
+        }
+        mWakeCondition.notify_one();
+        if (mChangeListener){mChangeListener->interrupt();}
+    }
+    /// Takes the pending refresh requests.
+    [[nodiscard]] std::set<std::string> takeRefreshRequests()
+    {
+        std::scoped_lock lock(mWakeMutex);
+        return std::exchange(mRefreshRequests, {});
+    }
+    /// Fetches the schema's changed events and prefetches its documents.
+    /// @result The number of changed events.
+    size_t refresh(const std::string &schema)
+    {
+        size_t nChanged{0};
+        try
+        {
+            // Subscribers leave polling to the publisher
+            if (mSharedCatalogMode != SharedCatalogMode::Subscribe)
+            {
+                nChanged = updateQuery(schema);
             }
-            std::this_thread::sleep_for(std::chrono::seconds (1));
-            
+            prefetchFullData(schema);
         }
+        catch (const std::exception &e)
+        {
+            spdlog::error("Failed to perform update query on " + schema
+                        + "; failed with "
+                        + std::string {e.what()});
+        }
+        return nChanged;
+    }
+    /// The notification channel raised by the schema's event trigger.
+    [[nodiscard]] static std::string getChangeChannel(const std::string &schema)
+    {
+        return "cct_" + schema + "_event";
     }
     void setRunning(bool running)
     {
@@ -238,63 +1343,157 @@ public:
     }
     void stop()
     {
+        {
+        std::scoped_lock lock(mWakeMutex);
         setRunning(false);
-        if (mThread.joinable()){mThread.join();}
+        }
+        mWakeCondition.notify_all();
+        if (mChangeListener){mChangeListener->interrupt();}
+        if (mThread.joinable())
+        {
+            mThread.join();
+            writeSnapshots();
+        }
     }
-    /// Have event?
+    /// Have event?  An evicted event is fetched once and kept so the
+    /// request that follows does not query the database again.
+    /// @throws std::runtime_error if the database cannot be queried.
     [[nodiscard]] bool haveEvent(const std::string &schema,
-                                 const std::string &event) const noexcept
+                                 const int64_t event)
     {
-        if (!mEventsMap.contains(schema)){return false;}
-        std::scoped_lock lock(mMutex);
-        return mEventsMap.at(schema).contains(event); 
-    } 
+        if (!mSnapshots.contains(schema)){return false;}
+        return findEvent(schema, event) != nullptr;
+    }
+    /// The current catalog of the schema.  Readers hold on to the snapshot
+    /// for as long as they need it and are never blocked by the writers.
+    [[nodiscard]] std::shared_ptr<const Events>
+        getSnapshot(const std::string &schema) const
+    {
+        return mSnapshots.at(schema).load();
+    }
     /// Lightweight data to string
     [[nodiscard]] std::string lightWeightDataToString(const std::string &schema,
                                                       const int indent) const
     {
-        std::scoped_lock lock(mMutex);
-        return mEventsMap.at(schema).lightWeightDataToString(indent);
+        return getSnapshot(schema)->lightWeightDataToString(indent);
     }   
-    /// Query for envelope data
-    [[nodiscard]] std::string envelopeDataToString(const std::string &schema,
-                                                   const std::string &eventIdentifier,
-                                                   const int indent) const
-    {
-        std::string result;
-        auto session
-             = reinterpret_cast<soci::session *> (mConnection->getSession());
-        *session << "SELECT CAST(envelope_data AS TEXT) FROM "
-                  + schema + ".event "
-                  + " WHERE " + schema + ".event.identifier = " + eventIdentifier
-                  + " LIMIT 1;",
-                  soci::into(result);
-        if (!result.empty())
+    /// Filtered, sorted, and paged lightweight data to string
+    [[nodiscard]] CatalogPage lightWeightDataToString(const std::string &schema,
+                                                      const CatalogQuery &query,
+                                                      const int indent) const
+    {
+        auto snapshot = getSnapshot(schema);
+        // Pages of pre-serialized summaries are reused until the catalog
+        // or the query changes
+        bool cacheable{query.fields.empty() && indent < 0};
+        auto &pageCache = mPageCache.at(schema);
+        if (cacheable)
         {
-            try
+            auto cachedPage = pageCache.load();
+            // A subscriber adopts the publisher's versions which start over
+            // when the publisher restarts so the epoch must match as well
+            if (cachedPage &&
+                cachedPage->epoch == snapshot->getEpoch() &&
+                cachedPage->version == snapshot->getVersion() &&
+                cachedPage->query == query)
             {
-                auto envelopeJsonData = nlohmann::json::parse(result);
-                result = envelopeJsonData.dump(indent); 
+                return cachedPage->page;
             }
-            catch (const std::exception &e)
+        }
+        auto page = snapshot->lightWeightDataToString(query, indent);
+        if (cacheable)
+        {
+            pageCache.store(std::make_shared<const CachedPage>
+                            (CachedPage {snapshot->getEpoch(),
+                                         snapshot->getVersion(),
+                                         query, page}));
+        }
+        return page;
+    }
+    /// The envelope data from the cache or, failing that, from the database.
+    [[nodiscard]] std::string envelopeDataToString(const std::string &schema,
+                                                   const int64_t eventIdentifier,
+                                                   const int indent)
+    {
+        auto &envelopeCache = *mEnvelopeCaches.at(schema);
+        auto envelopeData = envelopeCache.get(eventIdentifier);
+        // Drop an envelope older than the catalog's copy of its row
+        auto event = getSnapshot(schema)->find(eventIdentifier);
+        if (envelopeData && event &&
+            (*envelopeData)->lastUpdate < event->mLastUpdate)
+        {
+            envelopeCache.erase(eventIdentifier);
+            envelopeData = std::nullopt;
+        }
+        if (!envelopeData)
+        {
+            // Serve what was fetched since it may have been too big for,
+            // or already evicted from, the cache
+            std::map<int64_t, std::shared_ptr<const CachedEnvelope>> fetched;
             {
-                spdlog::warn("Failed to unpack data for " + eventIdentifier);
-                result.clear();
+            auto connection = mConnectionPool->checkout();
+            fetched
+                = fetchEnvelopeData(schema,
+                                    std::vector<int64_t> {eventIdentifier},
+                                    *connection);
             }
+            auto idx = fetched.find(eventIdentifier);
+            if (idx == fetched.end()){return "";}
+            envelopeData = std::move(idx->second);
         }
-        return result; 
+        // The cached text is minified
+        const auto &text = (*envelopeData)->text;
+        if (indent < 0 || text.empty()){return text;}
+        return nlohmann::json::parse(text).dump(indent);
+    }
+    /// Detail data to string
+    [[nodiscard]] std::string detailDataToString(const std::string &schema,
+                                                 const int64_t eventIdentifier,
+                                                 const int indent)
+    {
+        auto event = findEvent(schema, eventIdentifier);
+        if (!event){return "";}
+        auto details = toJSONString(*event->mDetails, eventIdentifier,
+                                    mStationNames.get());
+        if (indent < 0){return details;}
+        return nlohmann::json::parse(details).dump(indent);
     }
     /// Heavyweight data to string
     [[nodiscard]] std::string heavyWeightDataToString(const std::string &schema,
-                                                      const std::string &eventIdentifier,
-                                                      const int indent) const
+                                                      const int64_t eventIdentifier,
+                                                      const int indent)
+    {
+        auto fullData = getFullData(schema, eventIdentifier);
+        if (!fullData){return "";}
+        if (indent < 0){return *fullData;}
+        return nlohmann::json::parse(*fullData).dump(indent);
+    }
+    /// Selected heavyweight data to string
+    [[nodiscard]] std::string heavyWeightDataToString(
+        const std::string &schema,
+        const int64_t eventIdentifier,
+        const std::map<std::string, std::string> &selectors,
+        const std::string &station,
+        const int indent)
     {
-        std::scoped_lock lock(mMutex);
-        return mEventsMap.at(schema).heavyWeightDataToString(eventIdentifier, indent);
+        auto fullData = getFullData(schema, eventIdentifier);
+        if (!fullData){return "";}
+        // Reuse the parsed document while the cached text is unchanged
+        auto &parsedFullDataCache = *mParsedFullDataCaches.at(schema);
+        auto parsed = parsedFullDataCache.get(eventIdentifier);
+        if (!parsed || (*parsed)->text != fullData)
+        {
+            parsed = std::make_shared<const ParsedFullData>
+                     (ParsedFullData {fullData,
+                                      nlohmann::json::parse(*fullData)});
+            parsedFullDataCache.insert(eventIdentifier, *parsed);
+        }
+        return fullDataToString((*parsed)->document, selectors, station,
+                                indent);
     }
     /// Accept or reject event
     [[nodiscard]] bool acceptRejectEvent(const std::string &schema,
-                                         const std::string &eventIdentifier,
+                                         const int64_t eventIdentifier,
                                          const std::string &reviewStatus)
     {
         bool success{true};
@@ -302,28 +1501,26 @@ public:
            = std::chrono::duration_cast<std::chrono::microseconds> (
              std::chrono::high_resolution_clock::now().time_since_epoch());
         auto lastUpdate = static_cast<double> (nowMuS.count())*1.e-6;
-        std::string query = "UPDATE "
-                          + schema + ".event SET (review_status, last_update) = (:review_status, TO_TIMESTAMP(:last_update)) WHERE "
-                          + schema + ".event.identifier=:identifier";
-        {
-        std::scoped_lock lock(mMutex);
-        if (!mConnection->isConnected())
-        {
-            spdlog::warn("Reconnecting to CCT postgres");
-            mConnection->connect();
-        }
-        if (!mConnection->isConnected())
         {
-            spdlog::critical("CCT postgres connection broken");
-            return false;
-        }
-        auto session
-             = reinterpret_cast<soci::session *> (mConnection->getSession());
-        soci::statement statement
-             = (session->prepare << query,
-                                    soci::use(reviewStatus),
-                                    soci::use(lastUpdate),
-                                    soci::use(eventIdentifier));
+        auto connection = mConnectionPool->checkout();
+        auto &statement
+            = connection->getStatementRegistry().get(
+                schema + ".acceptRejectEvent",
+                [&schema](soci::session &session,
+                          PreparedStatement &preparedStatement)
+                {
+                    return soci::statement {
+                        (session.prepare <<
+                            "UPDATE "
+                          + schema + ".event SET (review_status, last_update) = (:review_status, TO_TIMESTAMP(:last_update)) WHERE "
+                          + schema + ".event.identifier=:identifier",
+                         soci::use(preparedStatement.text),
+                         soci::use(preparedStatement.time),
+                         soci::use(preparedStatement.identifier))};
+                });
+        statement.text = reviewStatus;
+        statement.time = lastUpdate;
+        statement.identifier = static_cast<long long> (eventIdentifier);
         try
         {
             statement.execute();
@@ -332,55 +1529,233 @@ public:
         catch (const std::exception &e)
         {
             spdlog::critical(e.what());
+            connection.markSuspect();
             success = false;
         }
         }
-        // Won't matter if we fail - but let's try to update the event data
-        try
-        {
-            updateQuery(schema);
-        }
-        catch (const std::exception &e)
+        if (success)
         {
-            spdlog::warn("Failed to perform update query after accept/reject: "
-                       + std::string {e.what()});
+            publishReviewStatus(schema, eventIdentifier, reviewStatus);
+            // The poller still fetches the row to pick up any other changes
+            requestRefresh(schema);
         }
         return success;
     }
+    /// Publishes a review status that was written to the database so the
+    /// next catalog request sees it without waiting for the poller.
+    /// Subscribers do not do this since their versions must be the
+    /// publisher's; a local version would be relabeled by the next adopted
+    /// catalog and clients at it would miss the publisher's changes.  The
+    /// status reaches a subscriber once the publisher polls the row.
+    void publishReviewStatus(const std::string &schema,
+                             const int64_t eventIdentifier,
+                             const std::string &reviewStatus)
+    {
+        if (!mSnapshots.contains(schema)){return;}
+        if (mSharedCatalogMode == SharedCatalogMode::Subscribe){return;}
+        // The poller only holds this while it publishes so this never waits
+        // on its database queries
+        std::scoped_lock lock(mPublishMutex);
+        auto current = getSnapshot(schema);
+        auto event = current->find(eventIdentifier);
+        if (!event || event->mSummary.reviewStatus == reviewStatus){return;}
+        // The copy shares the event's details
+        std::pair<int64_t, Event> updatedEvent{eventIdentifier, *event};
+        updatedEvent.second.mSummary.reviewStatus = reviewStatus;
+        // The serialized summary changed so it must be derived again
+        Events::derive(updatedEvent);
+        auto next = std::make_shared<Events> (*current);
+        next->update(std::move(updatedEvent));
+        mSnapshots.at(schema).store(std::move(next));
+    }
     /// Accept event
     [[nodiscard]] bool acceptEvent(const std::string &schema,
-                                   const std::string &eventIdentifier)
+                                   const int64_t eventIdentifier)
     {
         return acceptRejectEvent(schema, eventIdentifier, "A");
     }
     /// Reject event
     [[nodiscard]] bool rejectEvent(const std::string &schema,
-                                   const std::string &eventIdentifier)
+                                   const int64_t eventIdentifier)
     {
         return acceptRejectEvent(schema, eventIdentifier, "R");
     }
     [[nodiscard]] size_t getCurrentHash(const std::string &schema) const
     {
-        if (!mEventsMap.contains(schema)){return 0;}
-        std::scoped_lock lock(mMutex);
-        return mEventsMap.at(schema).getHash();
+        if (!mSnapshots.contains(schema)){return 0;}
+        return getSnapshot(schema)->getHash();
+    }
+    [[nodiscard]] uint64_t getCurrentVersion(const std::string &schema) const
+    {
+        if (!mSnapshots.contains(schema)){return 0;}
+        return getSnapshot(schema)->getVersion();
+    }
+    [[nodiscard]] uint64_t getCurrentEpoch(const std::string &schema) const
+    {
+        if (!mSnapshots.contains(schema)){return 0;}
+        return getSnapshot(schema)->getEpoch();
+    }
+    /// Changes since the client's version
+    [[nodiscard]] CatalogDelta getDelta(const std::string &schema,
+                                        const uint64_t epoch,
+                                        const uint64_t version) const
+    {
+        return getSnapshot(schema)->delta(epoch, version);
+    }
+    /// Get network magnitude inputs
+    [[nodiscard]] NetMagInputs getNetMagInputs(const std::string &schema,
+                                               const int64_t eventIdentifier)
+    {
+        auto event = findEvent(schema, eventIdentifier);
+        if (!event)
+        {
+            throw std::invalid_argument(std::to_string(eventIdentifier)
+                                      + " does not exist in " + schema);
+        }
+        return event->mSummary.netMagInputs;
     }
     /// Get event
-    [[nodiscard]] Event getEvent(const std::string &schema,
-                                 const std::string &eventIdentifier) const
+    [[nodiscard]] std::shared_ptr<const Event>
+        getEvent(const std::string &schema,
+                 const int64_t eventIdentifier)
+    {
+        auto event = findEvent(schema, eventIdentifier);
+        if (!event)
+        {
+            throw std::invalid_argument(std::to_string(eventIdentifier)
+                                      + " does not exist in " + schema);
+        }
+        return event;
+    }
+    /// Statistics
+    [[nodiscard]] CatalogStatistics getStatistics(const std::string &schema) const
+    {
+        return getSnapshot(schema)->getStatistics();
+    }
+    /// Document cache statistics
+    [[nodiscard]] DocumentCacheStatistics
+        getEventDataCacheStatistics(const std::string &schema) const
+    {
+        return mFullDataCaches.at(schema)->getStatistics();
+    }
+    /// Envelope cache statistics
+    [[nodiscard]] CacheStatistics
+        getEnvelopeDataCacheStatistics(const std::string &schema) const
+    {
+        return mEnvelopeCaches.at(schema)->getStatistics();
+    }
+    /// Connection pool statistics
+    [[nodiscard]] ConnectionPoolStatistics getConnectionPoolStatistics() const noexcept
     {
-        std::scoped_lock lock(mMutex);
-        return mEventsMap.at(schema).at(eventIdentifier);
+        return mConnectionPool->getStatistics();
     }
 //private:
-    mutable std::mutex mMutex;
+    /// A catalog page and the query and catalog epoch and version it was
+    /// built from.
+    struct CachedPage
+    {
+        uint64_t epoch{0};
+        uint64_t version{0};
+        CatalogQuery query;
+        CatalogPage page;
+    };
+    /// Serializes use of the poller's database connection and guards the
+    /// last_update watermarks.
+    mutable std::mutex mConnectionMutex;
+    /// Serializes building and publishing the next catalog snapshot and
+    /// guards the retention policies.  This is only held while a snapshot
+    /// is copied, modified, and stored so accept/reject never waits on the
+    /// poller's queries.  If both are needed then the connection mutex is
+    /// locked first.
+    std::mutex mPublishMutex;
     std::unique_ptr<PostgreSQL> mConnection{nullptr};
+    /// The connections used by the request threads.  These never wait on
+    /// the poller's connection.
+    std::unique_ptr<ConnectionPool> mConnectionPool{nullptr};
     std::thread mThread;
     std::set<std::string> mSchemas;
-    std::map<std::string, Events> mEventsMap;
+    /// The published catalog snapshot of each schema.  The map is populated
+    /// at construction so only the atomic pointers are modified afterwards.
+    std::map<std::string, std::atomic<std::shared_ptr<const Events>>> mSnapshots;
+    /// The most recently served catalog page of each schema.
+    mutable std::map<std::string, std::atomic<std::shared_ptr<const CachedPage>>> mPageCache;
     std::map<std::string, double> mLastUpdateMap;
-    std::chrono::seconds mLastQuery{0};
+    std::shared_ptr<StationNameTable> mStationNames{
+        std::make_shared<StationNameTable> ()};
+    std::map<std::string, RetentionPolicy> mRetentionPolicies;
+    /// The recently used mw_data documents of each schema.  Only the
+    /// summaries and details are kept for every event.  The least recently
+    /// used documents are kept compressed.
+    using FullDataCache = DocumentCache<int64_t>;
+    std::map<std::string, std::unique_ptr<FullDataCache>> mFullDataCaches;
+    /// The parsed mw_data documents of each schema's recent subtree reads.
+    /// An entry is only used while its text is the cached document.
+    struct ParsedFullData
+    {
+        std::shared_ptr<const std::string> text;
+        nlohmann::json document;
+    };
+    using ParsedFullDataCache
+        = LRUCache<int64_t, std::shared_ptr<const ParsedFullData>>;
+    std::map<std::string, std::unique_ptr<ParsedFullDataCache>> mParsedFullDataCaches;
+    /// The recently fetched evicted events of each schema.
+    using EvictedEventCache = LRUCache<int64_t, std::shared_ptr<const Event>>;
+    std::map<std::string, std::unique_ptr<EvictedEventCache>> mEvictedEventCaches;
+    /// When each schema's recently requested identifiers were found to be
+    /// missing from the database.
+    using MissingEventCache
+        = LRUCache<int64_t, std::chrono::steady_clock::time_point>;
+    std::map<std::string, std::unique_ptr<MissingEventCache>> mMissingEventCaches;
+    /// How long an identifier missing from the database is reported missing
+    /// without querying the database again.
+    std::chrono::seconds mMissingEventLifetime{30};
+    /// The minified envelope data of each schema's recently used and
+    /// prefetched events.
+    using EnvelopeCache = LRUCache<int64_t, std::shared_ptr<const CachedEnvelope>>;
+    std::map<std::string, std::unique_ptr<EnvelopeCache>> mEnvelopeCaches;
+    std::atomic<size_t> mPrefetchCount{10};
+    /// The number of rows per bulk fetch of the ingest queries.
+    std::atomic<size_t> mIngestBatchSize{100};
+    /// If true then the ingest queries fetch the projected mw_data documents.
+    std::atomic<bool> mProjectedIngest{false};
+    /// Parses and unpacks the fetched events.  If 0 then this uses all of
+    /// the hardware threads.
+    size_t mIngestThreads{0};
+    std::unique_ptr<WorkerPool> mWorkerPool{nullptr};
+    std::atomic<size_t> mJournalCapacity{4096};
+    /// The catalogs are written here so a restart can serve them before
+    /// catching up with the database.  If empty then this is disabled.
+    std::filesystem::path mSnapshotDirectory;
+    /// The epoch and version of each schema's last written snapshot.
+    std::map<std::string, std::pair<uint64_t, uint64_t>> mWrittenVersions;
+    std::chrono::seconds mSnapshotInterval{5*60};
+    bool mLoaded{false};
+    /// Shares the catalogs with other processes.
+    SharedCatalogMode mSharedCatalogMode{SharedCatalogMode::Disabled};
+    std::string mSharedCatalogName{"cctCatalog"};
+    size_t mSharedCatalogCapacity{256*1024*1024};
+    std::map<std::string, std::unique_ptr<SharedCatalogPublisher>> mPublishers;
+    std::map<std::string, std::unique_ptr<SharedCatalogSubscriber>> mSubscribers;
+    /// The epoch and version of each schema's last published or applied
+    /// shared catalog.
+    std::map<std::string, std::pair<uint64_t, uint64_t>> mSharedVersions;
+    /// Wakes the poller when a schema's events change.  If NULL then the
+    /// poller relies on the query interval.
+    std::unique_ptr<ChangeListener> mChangeListener{nullptr};
+    /// When a schema is next polled.
+    struct PollSchedule
+    {
+        std::chrono::seconds interval{1};
+        std::chrono::steady_clock::time_point nextQuery;
+    };
+    /// The poll interval of a schema whose events are changing.
+    std::chrono::seconds mMinimumQueryInterval{1};
+    /// The poll interval of a schema whose events are not changing.
     std::chrono::seconds mQueryInterval{1*60};
+    /// Wakes the poller when it is stopped or asked to refresh a schema.
+    std::mutex mWakeMutex;
+    std::condition_variable mWakeCondition;
+    std::set<std::string> mRefreshRequests;
     std::atomic<bool> mRunning{false};
     //double mLastUpdate{std::numeric_limits<double>::lowest()};
 };
@@ -388,8 +1763,11 @@ public:
 /// Constructor
 CCTPostgresService::CCTPostgresService(
     std::unique_ptr<PostgreSQL> &&connection,
+    std::unique_ptr<ConnectionPool> &&connectionPool,
     const std::set<std::string> &schemas) :
-    pImpl(std::make_unique<CCTPostgresServiceImpl> (std::move(connection), schemas))
+    pImpl(std::make_unique<CCTPostgresServiceImpl> (std::move(connection),
+                                                    std::move(connectionPool),
+                                                    schemas))
 {
 }
 
@@ -421,9 +1799,29 @@ void CCTPostgresService::start()
 
 /// Have event?
 bool CCTPostgresService::haveEvent(const std::string &schema,
-                                   const std::string &event) const noexcept
+                                   const std::string &event) const
 {
-    return pImpl->haveEvent(schema, event); 
+    int64_t identifier{0};
+    try
+    {
+        identifier = convertEventIdentifier(event);
+    }
+    catch (const std::exception &)
+    {
+        return false;
+    }
+    // A database failure is not a missing event.  The driver's message is
+    // logged here rather than passed on to the client.
+    try
+    {
+        return pImpl->haveEvent(schema, identifier);
+    }
+    catch (const std::exception &e)
+    {
+        spdlog::error("Could not look up " + event + " in " + schema
+                    + "; failed with: " + std::string {e.what()});
+    }
+    throw std::runtime_error("Could not look up " + event + " in " + schema);
 }
 
 /// Schemas
@@ -438,8 +1836,8 @@ bool CCTPostgresService::haveSchema(const std::string &schema) const noexcept
     return pImpl->mSchemas.contains(schema);
 }
 
-/// Get event reference
-Event CCTPostgresService::getEvent(
+/// Get event handle
+std::shared_ptr<const Event> CCTPostgresService::getEvent(
     const std::string &schema, const std::string &identifier) const 
 {
     if (!haveSchema(schema))
@@ -451,7 +1849,23 @@ Event CCTPostgresService::getEvent(
         throw std::invalid_argument(identifier
                                   + " does not exist in " + schema);
     }
-    return pImpl->getEvent(schema, identifier);
+    return pImpl->getEvent(schema, convertEventIdentifier(identifier));
+}
+
+/// Network magnitude inputs
+NetMagInputs CCTPostgresService::getNetMagInputs(
+    const std::string &schema, const std::string &identifier) const
+{
+    if (!haveSchema(schema))
+    {
+        throw std::invalid_argument("Schema " + schema + " does not exist");
+    }
+    if (!haveEvent(schema, identifier))
+    {
+        throw std::invalid_argument(identifier
+                                  + " does not exist in " + schema);
+    }
+    return pImpl->getNetMagInputs(schema, convertEventIdentifier(identifier));
 }
 
 /// Lightweight data
@@ -462,13 +1876,65 @@ std::string CCTPostgresService::lightWeightDataToString(
     return pImpl->lightWeightDataToString(schema, indent);
 }
 
+/// Filtered lightweight data
+CatalogPage CCTPostgresService::lightWeightDataToString(
+    const std::string &schema,
+    const CatalogQuery &query,
+    const int indent) const
+{
+    if (!haveSchema(schema))
+    {
+        throw std::invalid_argument("Schema " + schema + " does not exist");
+    }
+    return pImpl->lightWeightDataToString(schema, query, indent);
+}
+
 /// Heavyweight data
 std::string CCTPostgresService::heavyWeightDataToString(
     const std::string &schema,
     const std::string &identifier,
     const int indent) const
 {
-    return pImpl->heavyWeightDataToString(schema, identifier, indent);
+    return pImpl->heavyWeightDataToString(schema,
+                                          convertEventIdentifier(identifier),
+                                          indent);
+}
+
+/// Selected heavyweight data
+std::string CCTPostgresService::heavyWeightDataToString(
+    const std::string &schema,
+    const std::string &identifier,
+    const std::map<std::string, std::string> &selectors,
+    const std::string &station,
+    const int indent) const
+{
+    if (!haveSchema(schema))
+    {
+        throw std::invalid_argument("Schema " + schema + " does not exist");
+    }
+    return pImpl->heavyWeightDataToString(schema,
+                                          convertEventIdentifier(identifier),
+                                          selectors, station, indent);
+}
+
+/// Detail data
+std::string CCTPostgresService::detailDataToString(
+    const std::string &schema,
+    const std::string &identifier,
+    const int indent) const
+{
+    if (!haveSchema(schema))
+    {
+        throw std::invalid_argument("Schema " + schema + " does not exist");
+    }
+    if (!haveEvent(schema, identifier))
+    {
+        throw std::invalid_argument("Event " + identifier
+                                  + " does not exist in schema " + schema);
+    }
+    return pImpl->detailDataToString(schema,
+                                     convertEventIdentifier(identifier),
+                                     indent);
 }
 
 /// Envelope data
@@ -486,7 +1952,9 @@ std::string CCTPostgresService::envelopeDataToString(
         throw std::invalid_argument("Event " + identifier
                                   + " does not exist in schema " + schema);
     }
-    return pImpl->envelopeDataToString(schema, identifier, indent);
+    return pImpl->envelopeDataToString(schema,
+                                       convertEventIdentifier(identifier),
+                                       indent);
 }
 
 
@@ -504,7 +1972,7 @@ void CCTPostgresService::acceptEvent(
         throw std::invalid_argument("Event " + identifier
                                   + " does not exist in schema " + schema);
     }
-    if (!pImpl->acceptEvent(schema, identifier))
+    if (!pImpl->acceptEvent(schema, convertEventIdentifier(identifier)))
     {
         throw std::runtime_error("Failed to accept event " + identifier);
     }
@@ -524,7 +1992,7 @@ void CCTPostgresService::rejectEvent(
         throw std::invalid_argument("Event " + identifier
                                   + " does not exist in schema " + schema);
     }
-    if (!pImpl->rejectEvent(schema, identifier))
+    if (!pImpl->rejectEvent(schema, convertEventIdentifier(identifier)))
     {
         throw std::runtime_error("Failed to reject event " + identifier);
     }
@@ -534,3 +2002,278 @@ size_t CCTPostgresService::getCurrentHash(const std::string &schema) const
 {
     return pImpl->getCurrentHash(schema);
 }
+
+/// Retention policy
+void CCTPostgresService::setRetentionPolicy(const std::string &schema,
+                                            const RetentionPolicy &policy)
+{
+    if (!haveSchema(schema))
+    {
+        throw std::invalid_argument("Schema " + schema + " does not exist");
+    }
+    if (policy.maximumAge && policy.maximumAge->count() <= 0)
+    {
+        throw std::invalid_argument("Maximum age must be positive");
+    }
+    pImpl->setRetentionPolicy(schema, policy);
+}
+
+/// Statistics
+CatalogStatistics CCTPostgresService::getStatistics(
+    const std::string &schema) const
+{
+    if (!haveSchema(schema))
+    {
+        throw std::invalid_argument("Schema " + schema + " does not exist");
+    }
+    return pImpl->getStatistics(schema);
+}
+
+/// Document cache statistics
+DocumentCacheStatistics CCTPostgresService::getEventDataCacheStatistics(
+    const std::string &schema) const
+{
+    if (!haveSchema(schema))
+    {
+        throw std::invalid_argument("Schema " + schema + " does not exist");
+    }
+    return pImpl->getEventDataCacheStatistics(schema);
+}
+
+/// Change listener
+void CCTPostgresService::setChangeListener(
+    std::unique_ptr<PostgreSQL> &&connection)
+{
+    if (isRunning())
+    {
+        throw std::runtime_error("Cannot set change listener while running");
+    }
+    std::set<std::string> channels;
+    for (const auto &schema : pImpl->mSchemas)
+    {
+        channels.insert(CCTPostgresServiceImpl::getChangeChannel(schema));
+    }
+    pImpl->mChangeListener
+        = std::make_unique<ChangeListener> (std::move(connection), channels);
+}
+
+/// Ingest batch size
+void CCTPostgresService::setIngestBatchSize(const size_t batchSize)
+{
+    if (batchSize == 0)
+    {
+        throw std::invalid_argument("Batch size must be positive");
+    }
+    if (isRunning())
+    {
+        throw std::runtime_error("Cannot set batch size while running");
+    }
+    pImpl->mIngestBatchSize = batchSize;
+}
+
+/// Projected ingest
+void CCTPostgresService::setProjectedIngest(const bool projected)
+{
+    if (isRunning())
+    {
+        throw std::runtime_error("Cannot set ingest mode while running");
+    }
+    pImpl->mProjectedIngest = projected;
+}
+
+/// Ingest threads
+void CCTPostgresService::setNumberOfIngestThreads(const size_t nThreads)
+{
+    if (isRunning())
+    {
+        throw std::runtime_error("Cannot set ingest threads while running");
+    }
+    pImpl->mIngestThreads = nThreads;
+    pImpl->mWorkerPool = nullptr;
+}
+
+/// Query interval
+void CCTPostgresService::setQueryInterval(const std::chrono::seconds &interval)
+{
+    if (interval.count() <= 0)
+    {
+        throw std::invalid_argument("Query interval must be positive");
+    }
+    if (isRunning())
+    {
+        throw std::runtime_error("Cannot set query interval while running");
+    }
+    pImpl->mQueryInterval = interval;
+}
+
+/// Minimum query interval
+void CCTPostgresService::setMinimumQueryInterval(
+    const std::chrono::seconds &interval)
+{
+    if (interval.count() <= 0)
+    {
+        throw std::invalid_argument("Minimum query interval must be positive");
+    }
+    if (isRunning())
+    {
+        throw std::runtime_error("Cannot set query interval while running");
+    }
+    pImpl->mMinimumQueryInterval = interval;
+}
+
+/// Refresh
+void CCTPostgresService::requestRefresh(const std::string &schema)
+{
+    if (!haveSchema(schema))
+    {
+        throw std::invalid_argument("Schema " + schema + " does not exist");
+    }
+    pImpl->requestRefresh(schema);
+}
+
+/// Connection pool statistics
+ConnectionPoolStatistics
+    CCTPostgresService::getConnectionPoolStatistics() const noexcept
+{
+    return pImpl->getConnectionPoolStatistics();
+}
+
+/// Document cache size
+void CCTPostgresService::setEventDataCacheCapacity(const size_t capacity)
+{
+    for (auto &fullDataCache : pImpl->mFullDataCaches)
+    {
+        fullDataCache.second->setCapacity(capacity);
+    }
+}
+
+/// Envelope cache size
+void CCTPostgresService::setEnvelopeDataCacheCapacity(const size_t capacity)
+{
+    for (auto &envelopeCache : pImpl->mEnvelopeCaches)
+    {
+        [[maybe_unused]] auto evicted
+            = envelopeCache.second->setCapacity(capacity);
+    }
+}
+
+/// Envelope cache statistics
+CacheStatistics CCTPostgresService::getEnvelopeDataCacheStatistics(
+    const std::string &schema) const
+{
+    if (!haveSchema(schema))
+    {
+        throw std::invalid_argument("Schema " + schema + " does not exist");
+    }
+    return pImpl->getEnvelopeDataCacheStatistics(schema);
+}
+
+/// Compressed document cache size
+void CCTPostgresService::setCompressedEventDataCacheCapacity(
+    const size_t capacity)
+{
+    for (auto &fullDataCache : pImpl->mFullDataCaches)
+    {
+        fullDataCache.second->setColdCapacity(capacity);
+    }
+}
+
+/// Number of prefetched documents
+void CCTPostgresService::setNumberOfPrefetchedEvents(const size_t nEvents) noexcept
+{
+    pImpl->mPrefetchCount = nEvents;
+}
+
+/// Catalog version
+uint64_t CCTPostgresService::getCurrentVersion(const std::string &schema) const
+{
+    return pImpl->getCurrentVersion(schema);
+}
+
+/// Catalog epoch
+uint64_t CCTPostgresService::getCurrentEpoch(const std::string &schema) const
+{
+    return pImpl->getCurrentEpoch(schema);
+}
+
+/// Catalog changes
+CatalogDelta CCTPostgresService::getDelta(const std::string &schema,
+                                          const uint64_t epoch,
+                                          const uint64_t version) const
+{
+    if (!haveSchema(schema))
+    {
+        throw std::invalid_argument("Schema " + schema + " does not exist");
+    }
+    return pImpl->getDelta(schema, epoch, version);
+}
+
+/// Snapshot directory
+void CCTPostgresService::setSnapshotDirectory(
+    const std::filesystem::path &directory)
+{
+    if (isRunning())
+    {
+        throw std::runtime_error("Snapshot directory must be set before start");
+    }
+    if (!directory.empty() && !std::filesystem::exists(directory))
+    {
+        if (!std::filesystem::create_directories(directory))
+        {
+            throw std::runtime_error("Failed to create "
+                                   + directory.string());
+        }
+    }
+    pImpl->mSnapshotDirectory = directory;
+}
+
+/// Snapshot interval
+void CCTPostgresService::setSnapshotInterval(
+    const std::chrono::seconds &interval)
+{
+    if (interval.count() <= 0)
+    {
+        throw std::invalid_argument("Snapshot interval must be positive");
+    }
+    if (isRunning())
+    {
+        throw std::runtime_error("Snapshot interval must be set before start");
+    }
+    pImpl->mSnapshotInterval = interval;
+}
+
+/// Shared memory catalog
+void CCTPostgresService::setSharedCatalog(const std::string &name,
+                                          const SharedCatalogMode mode,
+                                          const size_t capacity)
+{
+    if (mode != SharedCatalogMode::Disabled && name.empty())
+    {
+        throw std::invalid_argument("Shared catalog name is empty");
+    }
+    if (capacity == 0)
+    {
+        throw std::invalid_argument("Shared catalog capacity must be positive");
+    }
+    if (isRunning())
+    {
+        throw std::runtime_error("Shared catalog must be set before start");
+    }
+    pImpl->mSharedCatalogName = name;
+    pImpl->mSharedCatalogMode = mode;
+    pImpl->mSharedCatalogCapacity = capacity;
+}
+
+/// Journal length
+void CCTPostgresService::setJournalCapacity(const size_t capacity)
+{
+    if (capacity == 0)
+    {
+        throw std::invalid_argument("Journal capacity must be positive");
+    }
+    if (isRunning())
+    {
+        throw std::runtime_error("Journal capacity must be set before start");
+    }
+    pImpl->mJournalCapacity = capacity;
+}
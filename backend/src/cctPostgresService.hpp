@@ -2,13 +2,27 @@
 #define CCT_BACKEND_SERVICE_DATABASE_CCT_POSTGRES_SERVICE_HPP
 #include <memory>
 #include <set>
+#include <map>
+#include <chrono>
+#include <filesystem>
 #include "events.hpp"
+#include "documentCache.hpp"
+#include "connectionPool.hpp"
 namespace CCTService
 {
  class PostgreSQL;
 }
 namespace CCTService
 {
+/// @brief Defines how the processed catalog is shared between processes.
+enum class SharedCatalogMode
+{
+    Disabled,  /*!< The process polls the database for its own catalog. */
+    Publish,   /*!< The process polls the database and publishes its catalog
+                    to shared memory. */
+    Subscribe  /*!< The process reads its catalog from a publisher's shared
+                    memory and does not poll the database for it. */
+};
 /// @name CCTPostgreSQL "cctPostgreSQL.hpp" "cctPostgreSQL.hpp"
 /// @brief Defines the interactivity with the CCT PostgreSQL database.
 /// @copyright Ben Baker (University of Utah) distributed under the MIT license. 
@@ -20,16 +34,21 @@ public:
 
     /// @brief Constructor.
     CCTPostgresService() = delete;
-    /// @brief Creates the postgres service that queries the given schemas
-    ///        from the given database connection.
+    /// @brief Creates the postgres service that queries the given schemas.
+    /// @param[in] connection      The poller's dedicated connection.
+    /// @param[in] connectionPool  The connections used to serve requests.
+    /// @param[in] schemas         The schemas.
     CCTPostgresService(std::unique_ptr<PostgreSQL> &&connection,
+                       std::unique_ptr<ConnectionPool> &&connectionPool,
                        const std::set<std::string> &schemas);
     /// @}
 
     /// @name Operators
     /// @{
 
-    /// @brief Starts the poller service.
+    /// @brief Loads the catalogs and starts the poller service.  If a
+    ///        snapshot directory is set then the catalogs are restored from
+    ///        their snapshot files when possible.
     void start();
     /// @result True indicates the service is running.
     [[nodiscard]] bool isRunning() const noexcept;
@@ -50,12 +69,157 @@ public:
     //[[nodiscard]] const Events &getEventsReference(const std::string &schema) const;
 
     /// @result True indicates the event identifier exists in the schema.
-    [[nodiscard]] bool haveEvent(const std::string &schema, const std::string &identifier) const noexcept;
-    [[nodiscard]] Event getEvent(const std::string &schema, const std::string &identifier) const;
+    ///         An identifier the database does not have is reported missing
+    ///         for a short time without querying the database again.
+    /// @throws std::runtime_error if the event is not in memory and the
+    ///         database cannot be queried.
+    [[nodiscard]] bool haveEvent(const std::string &schema, const std::string &identifier) const;
+    /// @result A shared handle to the event.  The event is immutable and
+    ///         stays valid after the catalog is updated.
+    [[nodiscard]] std::shared_ptr<const Event> getEvent(const std::string &schema, const std::string &identifier) const;
+    /// @result The magnitude, station and observation counts, closest
+    ///         distance, and azimuthal gap computed when the event was
+    ///         ingested.  These are used to create the network magnitude
+    ///         on accept.
+    [[nodiscard]] NetMagInputs getNetMagInputs(const std::string &schema, const std::string &identifier) const;
     [[nodiscard]] std::string lightWeightDataToString(const std::string &schema, int indent =-1) const;
+    /// @result The events in the schema satisfying the query's filters,
+    ///         sorted, and paged.
+    [[nodiscard]] CatalogPage lightWeightDataToString(const std::string &schema, const CatalogQuery &query, int indent =-1) const;
+    /// @result The spectral fit and station measurements of the event.
+    /// @throws std::invalid_argument if the schema or event does not exist.
+    /// @throws std::runtime_error if the event cannot be looked up.
+    [[nodiscard]] std::string detailDataToString(const std::string &schema, const std::string &identifier, int indent =-1) const;
     [[nodiscard]] std::string heavyWeightDataToString(const std::string &schema, const std::string &identifier, int indent =-1) const;
+    /// @result The subtrees of the event's mw_data document selected by
+    ///         JSON Pointers.  See \c fullDataToString().
+    [[nodiscard]] std::string heavyWeightDataToString(const std::string &schema, const std::string &identifier,
+                                                      const std::map<std::string, std::string> &selectors,
+                                                      const std::string &station, int indent =-1) const;
+    /// @result The event's minified envelope data or empty if it has none.
+    /// @throws std::invalid_argument if the schema or event does not exist.
+    /// @throws std::runtime_error if the database cannot be queried.
     [[nodiscard]] std::string envelopeDataToString(const std::string &schema, const std::string &identifier, int indent =-1) const;
+    /// @brief Sets the policy defining which of the schema's events are
+    ///        kept in memory.  Evicted events are fetched from the database
+    ///        on demand.
+    /// @throws std::invalid_argument if the schema does not exist or the
+    ///         maximum age is not positive.
+    void setRetentionPolicy(const std::string &schema, const RetentionPolicy &policy);
+    /// @result The memory accounting of the schema's cached events.
+    [[nodiscard]] CatalogStatistics getStatistics(const std::string &schema) const;
+    /// @result The occupancy and hit rate of the schema's mw_data document
+    ///         cache and the compression ratio and decompression time of its
+    ///         compressed tier.
+    [[nodiscard]] DocumentCacheStatistics getEventDataCacheStatistics(const std::string &schema) const;
+    /// @result The occupancy and hit rate of the schema's envelope data
+    ///         cache.
+    /// @throws std::invalid_argument if the schema does not exist.
+    [[nodiscard]] CacheStatistics getEnvelopeDataCacheStatistics(const std::string &schema) const;
+    /// @brief Sets the byte budget of each schema's envelope data cache.
+    ///        The envelopes of the newest unreviewed events are prefetched
+    ///        and the others are fetched from the database on first use.
+    void setEnvelopeDataCacheCapacity(size_t capacity);
+    /// @brief Sets the byte budget of each schema's mw_data document cache.
+    ///        The documents are fetched from the database on first use.
+    void setEventDataCacheCapacity(size_t capacity);
+    /// @brief Sets the byte budget of each schema's compressed mw_data
+    ///        documents.  Documents evicted from the expanded cache are
+    ///        compressed and are expanded again when they are next read.
+    ///        This has no effect if compiled without zlib.
+    void setCompressedEventDataCacheCapacity(size_t capacity);
+    /// @brief Sets the number of the newest unreviewed events per schema
+    ///        whose documents are prefetched by the poller.
+    void setNumberOfPrefetchedEvents(size_t nEvents) noexcept;
+    /// @brief Listens for the notifications raised when the schemas' events
+    ///        change so that the poller fetches them immediately.  The
+    ///        channel of a schema is cct_schema_event.  The trigger is
+    ///        created by database/notifyEventChange.sql.  A warning is
+    ///        logged if polling finds changes that were never announced.
+    /// @param[in] connection  The connection dedicated to listening.
+    /// @throws std::runtime_error if the service is running or the
+    ///         connection cannot be established.
+    void setChangeListener(std::unique_ptr<PostgreSQL> &&connection);
+    /// @brief Sets the number of events fetched per round trip when the
+    ///        catalogs are loaded and updated.  Larger batches have less
+    ///        per-row overhead but hold more mw_data documents in memory.
+    /// @throws std::invalid_argument if the batch size is 0.
+    /// @throws std::runtime_error if the service is running.
+    void setIngestBatchSize(size_t batchSize);
+    /// @brief If true then the ingest queries project, with Postgres' JSON
+    ///        operators, the parts of each mw_data document needed for the
+    ///        event's summary and details.  This reduces the transfer and
+    ///        parse time of each ingested event.  The full documents are
+    ///        fetched when they are requested.  This requires that the
+    ///        mw_data column can be cast to JSONB.
+    /// @throws std::runtime_error if the service is running.
+    void setProjectedIngest(bool projected);
+    /// @brief Sets the number of threads that parse and unpack the fetched
+    ///        events.  If 0 then all of the hardware threads are used.
+    /// @throws std::runtime_error if the service is running.
+    void setNumberOfIngestThreads(size_t nThreads);
+    /// @brief Sets how often a catalog whose events are not changing is
+    ///        polled.  The poller backs off to this interval while a catalog
+    ///        is idle.  With a change listener this is a safety net for
+    ///        missed notifications.
+    /// @throws std::invalid_argument if the interval is not positive.
+    /// @throws std::runtime_error if the service is running.
+    void setQueryInterval(const std::chrono::seconds &interval);
+    /// @brief Sets how often a catalog whose events are changing is polled.
+    /// @throws std::invalid_argument if the interval is not positive.
+    /// @throws std::runtime_error if the service is running.
+    void setMinimumQueryInterval(const std::chrono::seconds &interval);
+    /// @brief Asks the poller to fetch the schema's changed events now.  This
+    ///        does not wait for the query.
+    /// @throws std::invalid_argument if the schema does not exist.
+    void requestRefresh(const std::string &schema);
+    /// @result The usage and checkout wait times of the connections used to
+    ///         serve requests.
+    [[nodiscard]] ConnectionPoolStatistics getConnectionPoolStatistics() const noexcept;
+    /// @result The order-independent digest of the schema's catalog.
     [[nodiscard]] size_t getCurrentHash(const std::string &schema) const;
+    /// @result The version of the schema's catalog.  This increases every
+    ///         time an event is added, changed, or removed.
+    [[nodiscard]] uint64_t getCurrentVersion(const std::string &schema) const;
+    /// @result Identifies the history of the schema's catalog.  This
+    ///         changes when the catalog is reloaded, e.g., on restart, so
+    ///         versions are only comparable within an epoch.
+    [[nodiscard]] uint64_t getCurrentEpoch(const std::string &schema) const;
+    /// @result The summaries of the events added or changed and the
+    ///         identifiers of the events removed since the given version.
+    ///         If the epoch differs or the journal no longer holds all of
+    ///         the changes then this is a full snapshot of the catalog.
+    /// @throws std::invalid_argument if the schema does not exist.
+    [[nodiscard]] CatalogDelta getDelta(const std::string &schema, uint64_t epoch, uint64_t version) const;
+    /// @brief Sets the number of changes per schema kept in the change
+    ///        journal.  Clients further behind receive a full snapshot.
+    /// @throws std::invalid_argument if the capacity is 0.
+    /// @throws std::runtime_error if the service is running.
+    void setJournalCapacity(size_t capacity);
+    /// @brief Sets the directory to which the catalog snapshots are written.
+    ///        On start the catalogs are restored from these files and then
+    ///        brought up to date from the database.  The directory is
+    ///        created if it does not exist.  If empty then snapshots are
+    ///        disabled.
+    /// @throws std::runtime_error if the service is running or the directory
+    ///         cannot be created.
+    void setSnapshotDirectory(const std::filesystem::path &directory);
+    /// @brief Sets how often changed catalogs are written to the snapshot
+    ///        directory.  The catalogs are also written on stop.
+    /// @throws std::invalid_argument if the interval is not positive.
+    /// @throws std::runtime_error if the service is running.
+    void setSnapshotInterval(const std::chrono::seconds &interval);
+    /// @brief Shares the catalogs through POSIX shared memory so that one
+    ///        ingest process can serve several worker processes.
+    /// @param[in] name      The region name prefix.  Each schema is shared
+    ///                      in the region name_schema.
+    /// @param[in] mode      Publish or subscribe.
+    /// @param[in] capacity  The largest packed catalog in bytes a publisher
+    ///                      can share.
+    /// @throws std::invalid_argument if the name is empty or the capacity
+    ///         is 0.
+    /// @throws std::runtime_error if the service is running.
+    void setSharedCatalog(const std::string &name, SharedCatalogMode mode, size_t capacity);
     /// @name Destructors
     /// @{
 
@@ -0,0 +1,125 @@
+#ifndef CCT_BACKEND_SERVICE_CHANGE_JOURNAL_HPP
+#define CCT_BACKEND_SERVICE_CHANGE_JOURNAL_HPP
+#include <vector>
+#include <optional>
+#include <stdexcept>
+#include <cstdint>
+#include "chunkedArray.hpp"
+namespace CCTService
+{
+/// @brief A change to an event in the catalog.
+struct Change
+{
+    /// Defines the change.
+    enum class Type : uint8_t
+    {
+        Insert,       /*!< The event was added. */
+        Update,       /*!< The event was modified. */
+        ReviewStatus, /*!< The event's review status was modified. */
+        Evict,        /*!< The event was evicted by the retention policy. */
+        Erase         /*!< The event was removed. */
+    };
+    /// The catalog version after the change.
+    uint64_t sequence{0};
+    /// The event identifier.
+    int64_t identifier{0};
+    /// The change type.
+    Type type{Type::Insert};
+};
+
+/// @class ChangeJournal "changeJournal.hpp" "changeJournal.hpp"
+/// @brief A bounded ring buffer of the most recent catalog changes.  When
+///        the buffer is full the oldest change is overwritten.  The buffer is
+///        chunked so copies of the journal share the unchanged entries.
+///        This class is not thread-safe; it is published as part of a
+///        catalog snapshot.
+/// @copyright Ben Baker (University of Utah) distributed under the MIT license.
+class ChangeJournal
+{
+public:
+    /// @brief Creates a journal holding up to capacity changes.
+    /// @throws std::invalid_argument if the capacity is 0.
+    explicit ChangeJournal(const size_t capacity = 4096)
+    {
+        if (capacity == 0)
+        {
+            throw std::invalid_argument("Journal capacity must be positive");
+        }
+        mChanges.resize(capacity, Change {});
+    }
+    /// @brief Records the change.  The sequence numbers must increase.
+    void append(const Change &change)
+    {
+        if (mSize == mChanges.size())
+        {
+            mLowWatermark = mChanges[mHead].sequence;
+        }
+        else
+        {
+            mSize = mSize + 1;
+        }
+        mChanges.set(mHead, change);
+        mHead = (mHead + 1)%mChanges.size();
+    }
+    /// @brief Discards all changes.  Changes after the given sequence number
+    ///        will be recorded.
+    void reset(const uint64_t sequence) noexcept
+    {
+        mHead = 0;
+        mSize = 0;
+        mLowWatermark = sequence;
+    }
+    /// @brief Assigns the given sequence number to the changes recorded after
+    ///        the afterSequence.  This lets a catalog that applied another
+    ///        catalog's changes adopt that catalog's sequence numbers.
+    void relabel(const uint64_t afterSequence, const uint64_t sequence) noexcept
+    {
+        // The relabeled changes are the newest so walk back from the head
+        for (size_t i = 0; i < mSize; ++i)
+        {
+            auto slot = (mHead + mChanges.size() - 1 - i)%mChanges.size();
+            auto change = mChanges[slot];
+            if (change.sequence <= afterSequence){break;}
+            change.sequence = sequence;
+            mChanges.set(slot, change);
+        }
+    }
+    /// @result The changes with sequence numbers greater than the given
+    ///         sequence number from oldest to newest.  If some of those
+    ///         changes were overwritten then this is empty.
+    [[nodiscard]] std::optional<std::vector<Change>>
+        since(const uint64_t sequence) const
+    {
+        if (sequence < mLowWatermark){return std::nullopt;}
+        std::vector<Change> result;
+        auto tail = (mHead + mChanges.size() - mSize)%mChanges.size();
+        for (size_t i = 0; i < mSize; ++i)
+        {
+            const auto &change = mChanges[(tail + i)%mChanges.size()];
+            if (change.sequence > sequence){result.push_back(change);}
+        }
+        return result;
+    }
+    /// @result The sequence number after which all changes are recorded.
+    [[nodiscard]] uint64_t getLowWatermark() const noexcept
+    {
+        return mLowWatermark;
+    }
+    /// @result The number of recorded changes.
+    [[nodiscard]] size_t size() const noexcept
+    {
+        return mSize;
+    }
+    /// @result The maximum number of recorded changes.
+    [[nodiscard]] size_t capacity() const noexcept
+    {
+        return mChanges.size();
+    }
+private:
+    ChunkedArray<Change, 8> mChanges;
+    size_t mHead{0};
+    size_t mSize{0};
+    uint64_t mLowWatermark{0};
+};
+}
+#endif
@@ -0,0 +1,192 @@
+#include <string>
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include <soci/soci.h>
+#include <soci/postgresql/soci-postgresql.h>
+#include <libpq-fe.h>
+#include <spdlog/spdlog.h>
+#include "changeListener.hpp"
+#include "postgresql.hpp"
+
+using namespace CCTService;
+
+namespace
+{
+/// Postgres truncates identifiers longer than this.
+constexpr size_t maximumChannelLength{63};
+}
+
+class ChangeListener::ChangeListenerImpl
+{
+public:
+    ChangeListenerImpl() :
+        mInterrupt(::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC))
+    {
+        if (mInterrupt < 0)
+        {
+            throw std::runtime_error("Failed to create interrupt: "
+                                   + std::string {std::strerror(errno)});
+        }
+    }
+    ~ChangeListenerImpl()
+    {
+        ::close(mInterrupt);
+    }
+    /// Wakes a pending or the next wait.
+    void interrupt() noexcept
+    {
+        uint64_t one{1};
+        [[maybe_unused]] auto nWritten = ::write(mInterrupt, &one, sizeof(one));
+    }
+    /// Resets the interrupt.
+    void clearInterrupt() noexcept
+    {
+        uint64_t count{0};
+        [[maybe_unused]] auto nRead = ::read(mInterrupt, &count, sizeof(count));
+    }
+    /// The libpq connection underlying the soci session.
+    [[nodiscard]] PGconn *getConnection() const
+    {
+        auto session
+            = reinterpret_cast<soci::session *> (mConnection->getSession());
+        auto backend
+            = static_cast<soci::postgresql_session_backend *>
+              (session->get_backend());
+        if (backend == nullptr)
+        {
+            throw std::runtime_error("Not a postgresql session");
+        }
+        return backend->conn_;
+    }
+    /// (Re)connects and subscribes to the channels.
+    void listen()
+    {
+        mListening = false;
+        if (!mConnection->isConnected()){mConnection->connect();}
+        auto session
+            = reinterpret_cast<soci::session *> (mConnection->getSession());
+        for (const auto &channel : mChannels)
+        {
+            *session << "LISTEN \"" + channel + "\"";
+        }
+        mListening = true;
+    }
+    /// Moves the received notifications into the notified channels.
+    void drain(PGconn *connection, std::set<std::string> *notified)
+    {
+        while (auto notification = PQnotifies(connection))
+        {
+            notified->insert(std::string {notification->relname});
+            PQfreemem(notification);
+            mNotifications = mNotifications + 1;
+        }
+    }
+    std::set<std::string> wait(const std::chrono::milliseconds &timeout)
+    {
+        std::set<std::string> notified;
+        if (!mListening)
+        {
+            spdlog::warn("Reconnecting CCT change listener");
+            mConnection->connect(); // Throws
+            listen();
+            return mChannels;
+        }
+        auto connection = getConnection();
+        // Notifications can arrive with the results of LISTEN
+        drain(connection, &notified);
+        if (!notified.empty()){return notified;}
+        auto socket = PQsocket(connection);
+        if (socket < 0 || PQstatus(connection) != CONNECTION_OK)
+        {
+            spdlog::warn("CCT change listener connection broken");
+            mListening = false;
+            return notified;
+        }
+        std::array<struct pollfd, 2> descriptors{
+            pollfd {socket, POLLIN, 0},
+            pollfd {mInterrupt, POLLIN, 0}};
+        auto result = ::poll(descriptors.data(), descriptors.size(),
+                             static_cast<int> (timeout.count()));
+        if (result < 0)
+        {
+            if (errno == EINTR){return notified;}
+            throw std::runtime_error("Failed to wait for notifications: "
+                                   + std::string {std::strerror(errno)});
+        }
+        if (result == 0){return notified;}
+        if (descriptors[1].revents != 0){clearInterrupt();}
+        if (descriptors[0].revents == 0){return notified;}
+        if (PQconsumeInput(connection) == 0)
+        {
+            spdlog::warn("CCT change listener lost connection: "
+                       + std::string {PQerrorMessage(connection)});
+            mListening = false;
+            return notified;
+        }
+        drain(connection, &notified);
+        return notified;
+    }
+    std::unique_ptr<PostgreSQL> mConnection{nullptr};
+    std::set<std::string> mChannels;
+    std::atomic<uint64_t> mNotifications{0};
+    int mInterrupt{-1};
+    bool mListening{false};
+};
+
+/// Constructor
+ChangeListener::ChangeListener(std::unique_ptr<PostgreSQL> &&connection,
+                               const std::set<std::string> &channels) :
+    pImpl(std::make_unique<ChangeListenerImpl> ())
+{
+    if (connection == nullptr)
+    {
+        throw std::invalid_argument("Connection is NULL");
+    }
+    if (channels.empty()){throw std::invalid_argument("No channels");}
+    for (const auto &channel : channels)
+    {
+        if (channel.empty() ||
+            channel.find('"') != std::string::npos ||
+            channel.size() > maximumChannelLength)
+        {
+            throw std::invalid_argument("Invalid channel: " + channel);
+        }
+    }
+    pImpl->mConnection = std::move(connection);
+    pImpl->mChannels = channels;
+    pImpl->listen();
+}
+
+/// Wait
+std::set<std::string>
+    ChangeListener::wait(const std::chrono::milliseconds &timeout)
+{
+    return pImpl->wait(timeout);
+}
+
+/// Interrupt
+void ChangeListener::interrupt() noexcept
+{
+    pImpl->interrupt();
+}
+
+/// Channels
+std::set<std::string> ChangeListener::getChannels() const noexcept
+{
+    return pImpl->mChannels;
+}
+
+/// Notifications
+uint64_t ChangeListener::getNumberOfNotifications() const noexcept
+{
+    return pImpl->mNotifications;
+}
+
+/// Destructor
+ChangeListener::~ChangeListener() = default;
@@ -0,0 +1,60 @@
+#ifndef CCT_BACKEND_SERVICE_DATABASE_CHANGE_LISTENER_HPP
+#define CCT_BACKEND_SERVICE_DATABASE_CHANGE_LISTENER_HPP
+#include <memory>
+#include <set>
+#include <string>
+#include <chrono>
+#include <cstdint>
+namespace CCTService
+{
+ class PostgreSQL;
+}
+namespace CCTService
+{
+/// @name ChangeListener "changeListener.hpp" "changeListener.hpp"
+/// @brief Listens for PostgreSQL notifications on a dedicated connection so
+///        that the poller can fetch changed events moments after they are
+///        committed.  The notifications are raised by a trigger on each
+///        schema's event table that is created by
+///        database/notifyEventChange.sql.  The trigger sends an empty
+///        payload so Postgres collapses the notifications raised in a
+///        transaction and a bulk load produces one wakeup.
+/// @copyright Ben Baker (University of Utah) distributed under the MIT license.
+class ChangeListener
+{
+public:
+    /// @brief Listens on the given channels.
+    /// @param[in] connection  The connection dedicated to listening.  This is
+    ///                        connected if necessary.
+    /// @param[in] channels    The notification channels.
+    /// @throws std::invalid_argument if the connection is NULL, there are no
+    ///         channels, or a channel name is invalid.
+    /// @throws std::runtime_error if the connection cannot be established.
+    ChangeListener(std::unique_ptr<PostgreSQL> &&connection,
+                   const std::set<std::string> &channels);
+    /// @brief Waits for notifications.  If the connection was lost then it is
+    ///        reestablished and, since notifications may have been missed,
+    ///        every channel is reported.
+    /// @param[in] timeout  The longest time to wait.
+    /// @result The channels that were notified.  This is empty if the wait
+    ///         timed out or was interrupted.
+    /// @throws std::runtime_error if the connection cannot be reestablished.
+    [[nodiscard]] std::set<std::string> wait(const std::chrono::milliseconds &timeout);
+    /// @brief Makes a pending wait, or the next wait, return early without
+    ///        notifications.  This may be called from any thread.
+    void interrupt() noexcept;
+    /// @result The notification channels.
+    [[nodiscard]] std::set<std::string> getChannels() const noexcept;
+    /// @result The number of notifications received.
+    [[nodiscard]] uint64_t getNumberOfNotifications() const noexcept;
+    /// @brief Destructor.
+    ~ChangeListener();
+
+    ChangeListener(const ChangeListener &) = delete;
+    ChangeListener& operator=(const ChangeListener &) = delete;
+private:
+    class ChangeListenerImpl;
+    std::unique_ptr<ChangeListenerImpl> pImpl;
+};
+}
+#endif
@@ -0,0 +1,122 @@
+#ifndef CCT_BACKEND_SERVICE_CHUNKED_ARRAY_HPP
+#define CCT_BACKEND_SERVICE_CHUNKED_ARRAY_HPP
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <stdexcept>
+namespace CCTService
+{
+/// @class ChunkedArray "chunkedArray.hpp" "chunkedArray.hpp"
+/// @brief An array stored in fixed-size chunks that copies share until they
+///        are modified.  Copying the array copies one pointer per chunk and
+///        modifying an element copies only the chunk holding it, so the next
+///        catalog snapshot can be built from the current one without copying
+///        every element.  This class is not thread-safe; a copy that is
+///        published must not be modified.
+/// @copyright Ben Baker (University of Utah) distributed under the MIT license.
+template<typename T, size_t ChunkShift = 10>
+class ChunkedArray
+{
+public:
+    /// The number of elements per chunk.
+    static constexpr size_t ChunkSize{size_t {1} << ChunkShift};
+    ChunkedArray() = default;
+    /// @brief Creates an array of the given size filled with the value.
+    ChunkedArray(const size_t size, const T &value)
+    {
+        resize(size, value);
+    }
+    /// @result The i'th element.
+    [[nodiscard]] const T &operator[](const size_t i) const noexcept
+    {
+        return (*mChunks[i >> ChunkShift])[i & (ChunkSize - 1)];
+    }
+    /// @result The i'th element.
+    /// @throws std::out_of_range if the element does not exist.
+    [[nodiscard]] const T &at(const size_t i) const
+    {
+        if (i >= mSize){throw std::out_of_range("Element does not exist");}
+        return (*this)[i];
+    }
+    /// @brief Sets the i'th element.  The chunk holding it is copied if it
+    ///        is shared with another array.
+    void set(const size_t i, T value)
+    {
+        getMutableChunk(i >> ChunkShift)[i & (ChunkSize - 1)]
+            = std::move(value);
+    }
+    /// @brief Appends the value.
+    void push_back(T value)
+    {
+        if ((mSize & (ChunkSize - 1)) == 0)
+        {
+            mChunks.push_back(std::make_shared<std::vector<T>> ());
+            mChunks.back()->reserve(ChunkSize);
+        }
+        getMutableChunk(mChunks.size() - 1).push_back(std::move(value));
+        mSize = mSize + 1;
+    }
+    /// @brief Removes the last element.
+    void pop_back()
+    {
+        if (mSize == 0){return;}
+        getMutableChunk(mChunks.size() - 1).pop_back();
+        mSize = mSize - 1;
+        if ((mSize & (ChunkSize - 1)) == 0){mChunks.pop_back();}
+    }
+    /// @brief Resizes the array.  New elements are set to the value.
+    void resize(const size_t size, const T &value = T {})
+    {
+        while (mSize > size){pop_back();}
+        while (mSize < size){push_back(value);}
+    }
+    /// @brief Removes all elements.
+    void clear() noexcept
+    {
+        mChunks.clear();
+        mSize = 0;
+    }
+    [[nodiscard]] size_t size() const noexcept
+    {
+        return mSize;
+    }
+    [[nodiscard]] bool empty() const noexcept
+    {
+        return mSize == 0;
+    }
+    /// @result The last element.
+    [[nodiscard]] const T &back() const noexcept
+    {
+        return (*this)[mSize - 1];
+    }
+    /// @result The number of chunks shared with another array.  This is
+    ///         for testing.
+    [[nodiscard]] size_t getNumberOfSharedChunks() const noexcept
+    {
+        size_t result{0};
+        for (const auto &chunk : mChunks)
+        {
+            if (chunk.use_count() > 1){result = result + 1;}
+        }
+        return result;
+    }
+private:
+    /// A chunk held only by this array cannot be reached by a published
+    /// copy so it is modified in place.
+    [[nodiscard]] std::vector<T> &getMutableChunk(const size_t chunk)
+    {
+        auto &pointer = mChunks[chunk];
+        if (pointer.use_count() > 1)
+        {
+            auto copy = std::make_shared<std::vector<T>> ();
+            copy->reserve(ChunkSize);
+            copy->assign(pointer->begin(), pointer->end());
+            pointer = std::move(copy);
+        }
+        return *pointer;
+    }
+    std::vector<std::shared_ptr<std::vector<T>>> mChunks;
+    size_t mSize{0};
+};
+}
+#endif
@@ -0,0 +1,259 @@
+#include <string>
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+#include <stdexcept>
+#include <soci/soci.h>
+#include <spdlog/spdlog.h>
+#include "connectionPool.hpp"
+#include "postgresql.hpp"
+
+using namespace CCTService;
+
+class ConnectionPool::ConnectionPoolImpl
+{
+public:
+    struct Entry
+    {
+        std::unique_ptr<PostgreSQL> connection{nullptr};
+        std::chrono::steady_clock::time_point lastUsed;
+        bool inUse{false};
+        /// An exception was thrown while the connection was leased.
+        bool suspect{false};
+    };
+    /// Validates the connection and reconnects it if necessary.
+    void prepare(Entry &entry)
+    {
+        auto &connection = *entry.connection;
+        bool healthy = connection.isConnected();
+        if (healthy &&
+            (entry.suspect ||
+             std::chrono::steady_clock::now() - entry.lastUsed
+             > mHealthCheckInterval))
+        {
+            try
+            {
+                auto session
+                    = reinterpret_cast<soci::session *> (connection.getSession());
+                int one{0};
+                *session << "SELECT 1", soci::into(one);
+            }
+            catch (const std::exception &e)
+            {
+                spdlog::warn("CCT connection failed health check: "
+                           + std::string {e.what()});
+                healthy = false;
+            }
+            if (!healthy)
+            {
+                std::scoped_lock lock(mMutex);
+                mFailedHealthChecks = mFailedHealthChecks + 1;
+            }
+        }
+        if (!healthy)
+        {
+            spdlog::warn("Reconnecting to CCT postgres");
+            connection.connect(); // Throws
+            {
+                std::scoped_lock lock(mMutex);
+                mReconnects = mReconnects + 1;
+            }
+            if (!connection.isConnected())
+            {
+                throw std::runtime_error("CCT postgres connection broken");
+            }
+        }
+        entry.suspect = false;
+    }
+    mutable std::mutex mMutex;
+    std::condition_variable mConditionVariable;
+    std::vector<Entry> mEntries;
+    std::chrono::milliseconds mCheckoutTimeout{5000};
+    std::chrono::seconds mHealthCheckInterval{60};
+    size_t mAvailable{0};
+    uint64_t mCheckouts{0};
+    uint64_t mTimeouts{0};
+    uint64_t mReconnects{0};
+    uint64_t mFailedHealthChecks{0};
+    uint64_t mWaitMicroSeconds{0};
+    uint64_t mMaximumWaitMicroSeconds{0};
+};
+
+/// Constructor
+ConnectionPool::ConnectionPool(
+    std::vector<std::unique_ptr<PostgreSQL>> &&connections) :
+    pImpl(std::make_unique<ConnectionPoolImpl> ())
+{
+    if (connections.empty())
+    {
+        throw std::invalid_argument("No connections");
+    }
+    for (auto &connection : connections)
+    {
+        if (connection == nullptr)
+        {
+            throw std::invalid_argument("Connection is NULL");
+        }
+        ConnectionPoolImpl::Entry entry;
+        entry.connection = std::move(connection);
+        entry.lastUsed = std::chrono::steady_clock::now();
+        pImpl->mEntries.push_back(std::move(entry));
+    }
+    pImpl->mAvailable = pImpl->mEntries.size();
+}
+
+/// Destructor
+ConnectionPool::~ConnectionPool() = default;
+
+/// Timeout
+void ConnectionPool::setCheckoutTimeout(
+    const std::chrono::milliseconds &timeout)
+{
+    if (timeout.count() < 0)
+    {
+        throw std::invalid_argument("Timeout must be non-negative");
+    }
+    std::scoped_lock lock(pImpl->mMutex);
+    pImpl->mCheckoutTimeout = timeout;
+}
+
+/// Health check interval
+void ConnectionPool::setHealthCheckInterval(
+    const std::chrono::seconds &interval)
+{
+    if (interval.count() < 0)
+    {
+        throw std::invalid_argument("Interval must be non-negative");
+    }
+    std::scoped_lock lock(pImpl->mMutex);
+    pImpl->mHealthCheckInterval = interval;
+}
+
+/// Checkout
+ConnectionPool::Lease ConnectionPool::checkout()
+{
+    auto startTime = std::chrono::steady_clock::now();
+    size_t index{0};
+    {
+        std::unique_lock lock(pImpl->mMutex);
+        if (!pImpl->mConditionVariable.wait_for(lock,
+                                                pImpl->mCheckoutTimeout,
+                                                [this]
+                                                {
+                                                    return pImpl->mAvailable > 0;
+                                                }))
+        {
+            pImpl->mTimeouts = pImpl->mTimeouts + 1;
+            throw std::runtime_error(
+                "Timed out waiting for a CCT database connection");
+        }
+        while (pImpl->mEntries[index].inUse){index = index + 1;}
+        pImpl->mEntries[index].inUse = true;
+        pImpl->mAvailable = pImpl->mAvailable - 1;
+        auto wait = static_cast<uint64_t>
+                    (std::chrono::duration_cast<std::chrono::microseconds>
+                     (std::chrono::steady_clock::now() - startTime).count());
+        pImpl->mCheckouts = pImpl->mCheckouts + 1;
+        pImpl->mWaitMicroSeconds = pImpl->mWaitMicroSeconds + wait;
+        pImpl->mMaximumWaitMicroSeconds
+            = std::max(pImpl->mMaximumWaitMicroSeconds, wait);
+    }
+    // The lease returns the connection even if it cannot be reestablished
+    Lease lease{this, index};
+    pImpl->prepare(pImpl->mEntries[index]);
+    return lease;
+}
+
+/// Checkin
+void ConnectionPool::checkin(const size_t index, const bool suspect) noexcept
+{
+    {
+        std::scoped_lock lock(pImpl->mMutex);
+        auto &entry = pImpl->mEntries[index];
+        entry.inUse = false;
+        entry.suspect = entry.suspect || suspect;
+        entry.lastUsed = std::chrono::steady_clock::now();
+        pImpl->mAvailable = pImpl->mAvailable + 1;
+    }
+    pImpl->mConditionVariable.notify_one();
+}
+
+/// Size
+size_t ConnectionPool::size() const noexcept
+{
+    return pImpl->mEntries.size();
+}
+
+/// Statistics
+ConnectionPoolStatistics ConnectionPool::getStatistics() const noexcept
+{
+    std::scoped_lock lock(pImpl->mMutex);
+    ConnectionPoolStatistics statistics;
+    statistics.size = pImpl->mEntries.size();
+    statistics.available = pImpl->mAvailable;
+    statistics.checkouts = pImpl->mCheckouts;
+    statistics.timeouts = pImpl->mTimeouts;
+    statistics.reconnects = pImpl->mReconnects;
+    statistics.failedHealthChecks = pImpl->mFailedHealthChecks;
+    statistics.waitMicroSeconds = pImpl->mWaitMicroSeconds;
+    statistics.maximumWaitMicroSeconds = pImpl->mMaximumWaitMicroSeconds;
+    return statistics;
+}
+
+/// Lease
+ConnectionPool::Lease::Lease(ConnectionPool *pool, const size_t index) noexcept :
+    mPool(pool),
+    mIndex(index),
+    mUncaughtExceptions(std::uncaught_exceptions())
+{
+}
+
+/// Move constructor
+ConnectionPool::Lease::Lease(Lease &&lease) noexcept
+{
+    *this = std::move(lease);
+}
+
+/// Move assignment
+ConnectionPool::Lease& ConnectionPool::Lease::operator=(Lease &&lease) noexcept
+{
+    if (&lease == this){return *this;}
+    if (mPool){mPool->checkin(mIndex, mSuspect);}
+    mPool = lease.mPool;
+    mIndex = lease.mIndex;
+    mUncaughtExceptions = lease.mUncaughtExceptions;
+    mSuspect = lease.mSuspect;
+    lease.mPool = nullptr;
+    return *this;
+}
+
+/// Connection
+PostgreSQL &ConnectionPool::Lease::operator*() const noexcept
+{
+    return *mPool->pImpl->mEntries[mIndex].connection;
+}
+
+/// Connection
+PostgreSQL *ConnectionPool::Lease::operator->() const noexcept
+{
+    return mPool->pImpl->mEntries[mIndex].connection.get();
+}
+
+/// Mark suspect
+void ConnectionPool::Lease::markSuspect() noexcept
+{
+    mSuspect = true;
+}
+
+/// Destructor
+ConnectionPool::Lease::~Lease()
+{
+    // A query that threw may have left the session unusable
+    if (mPool)
+    {
+        mPool->checkin(mIndex,
+                       mSuspect
+                    || std::uncaught_exceptions() > mUncaughtExceptions);
+    }
+}
@@ -0,0 +1,115 @@
+#ifndef CCT_BACKEND_SERVICE_DATABASE_CONNECTION_POOL_HPP
+#define CCT_BACKEND_SERVICE_DATABASE_CONNECTION_POOL_HPP
+#include <memory>
+#include <vector>
+#include <chrono>
+#include <cstdint>
+namespace CCTService
+{
+ class PostgreSQL;
+}
+namespace CCTService
+{
+/// @brief The usage and wait times of a connection pool.
+struct ConnectionPoolStatistics
+{
+    /// The number of connections in the pool.
+    size_t size{0};
+    /// The number of connections not checked out.
+    size_t available{0};
+    /// The number of successful checkouts.
+    uint64_t checkouts{0};
+    /// The number of checkouts that timed out.
+    uint64_t timeouts{0};
+    /// The number of times a connection was reestablished.
+    uint64_t reconnects{0};
+    /// The number of health checks that found a broken connection.
+    uint64_t failedHealthChecks{0};
+    /// The total and largest time spent waiting for a connection in
+    /// microseconds.
+    uint64_t waitMicroSeconds{0};
+    uint64_t maximumWaitMicroSeconds{0};
+    /// @result The mean time spent waiting for a connection in microseconds.
+    [[nodiscard]] double getMeanWaitMicroSeconds() const noexcept
+    {
+        if (checkouts == 0){return 0;}
+        return static_cast<double> (waitMicroSeconds)
+              /static_cast<double> (checkouts);
+    }
+};
+
+/// @name ConnectionPool "connectionPool.hpp" "connectionPool.hpp"
+/// @brief A fixed-size pool of PostgreSQL connections shared by the request
+///        threads.  A connection is checked out for the duration of a
+///        query and returned when its lease is destroyed.  A connection is
+///        validated before it is handed out if it has been idle longer
+///        than the health check interval, if its lease was marked suspect,
+///        or if an exception propagated through its lease, and it is
+///        reconnected if it is broken.
+///        This class is thread-safe.
+/// @copyright Ben Baker (University of Utah) distributed under the MIT license.
+class ConnectionPool
+{
+public:
+    /// @brief Exclusive use of a connection.  The connection is returned to
+    ///        the pool on destruction.  The pool must outlive its leases.
+    class Lease
+    {
+    public:
+        Lease(Lease &&lease) noexcept;
+        Lease& operator=(Lease &&lease) noexcept;
+        /// @result The leased connection.
+        [[nodiscard]] PostgreSQL &operator*() const noexcept;
+        [[nodiscard]] PostgreSQL *operator->() const noexcept;
+        /// @brief Validates the connection before it is next handed out.
+        ///        Call this when catching a query failure since the caught
+        ///        exception no longer marks the lease.
+        void markSuspect() noexcept;
+        /// @brief Returns the connection to the pool.
+        ~Lease();
+        Lease(const Lease &) = delete;
+        Lease& operator=(const Lease &) = delete;
+    private:
+        friend class ConnectionPool;
+        Lease(ConnectionPool *pool, size_t index) noexcept;
+        ConnectionPool *mPool{nullptr};
+        size_t mIndex{0};
+        /// The uncaught exceptions when the lease was created so a lease
+        /// destroyed during an unrelated unwind is not suspect.
+        int mUncaughtExceptions{0};
+        bool mSuspect{false};
+    };
+
+    /// @brief Creates a pool from the given connections.  The connections
+    ///        need not be connected yet.
+    /// @throws std::invalid_argument if there are no connections or a
+    ///         connection is NULL.
+    explicit ConnectionPool(std::vector<std::unique_ptr<PostgreSQL>> &&connections);
+    /// @brief Sets the longest time to wait for a connection.
+    /// @throws std::invalid_argument if the timeout is negative.
+    void setCheckoutTimeout(const std::chrono::milliseconds &timeout);
+    /// @brief Connections idle longer than this are validated before they
+    ///        are handed out.
+    /// @throws std::invalid_argument if the interval is negative.
+    void setHealthCheckInterval(const std::chrono::seconds &interval);
+    /// @result A connected connection for exclusive use.
+    /// @throws std::runtime_error if no connection became available within
+    ///         the checkout timeout or the connection could not be
+    ///         reestablished.
+    [[nodiscard]] Lease checkout();
+    /// @result The number of connections.
+    [[nodiscard]] size_t size() const noexcept;
+    /// @result The pool usage and wait times.
+    [[nodiscard]] ConnectionPoolStatistics getStatistics() const noexcept;
+    /// @brief Destructor.
+    ~ConnectionPool();
+
+    ConnectionPool(const ConnectionPool &) = delete;
+    ConnectionPool& operator=(const ConnectionPool &) = delete;
+private:
+    void checkin(size_t index, bool suspect) noexcept;
+    class ConnectionPoolImpl;
+    std::unique_ptr<ConnectionPoolImpl> pImpl;
+};
+}
+#endif
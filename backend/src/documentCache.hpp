@@ -0,0 +1,360 @@
+#ifndef CCT_BACKEND_SERVICE_DOCUMENT_CACHE_HPP
+#define CCT_BACKEND_SERVICE_DOCUMENT_CACHE_HPP
+#include <string>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include <chrono>
+#include <stdexcept>
+#include <cstdint>
+#include <unordered_map>
+#ifdef WITH_ZLIB
+#include <zlib.h>
+#endif
+#include "lruCache.hpp"
+namespace CCTService
+{
+/// @brief The occupancy of the hot and cold tiers of a document cache and
+///        the cost of the cold tier.
+struct DocumentCacheStatistics
+{
+    /// The recently used, expanded documents.
+    CacheStatistics hot;
+    /// The less recently used, compressed documents.
+    CacheStatistics cold;
+    /// The expanded size of the documents in the cold tier.
+    size_t coldUncompressedBytes{0};
+    /// The number of cold documents expanded and promoted to the hot tier.
+    uint64_t decompressions{0};
+    /// The total and largest time spent decompressing in microseconds.
+    uint64_t decompressionMicroSeconds{0};
+    uint64_t maximumDecompressionMicroSeconds{0};
+    /// @result The expanded size divided by the compressed size of the
+    ///         cold tier or 0 if the cold tier is empty.
+    [[nodiscard]] double getCompressionRatio() const noexcept
+    {
+        if (cold.bytes == 0){return 0;}
+        return static_cast<double> (coldUncompressedBytes)
+              /static_cast<double> (cold.bytes);
+    }
+    /// @result The mean decompression time in microseconds.
+    [[nodiscard]] double getMeanDecompressionMicroSeconds() const noexcept
+    {
+        if (decompressions == 0){return 0;}
+        return static_cast<double> (decompressionMicroSeconds)
+              /static_cast<double> (decompressions);
+    }
+};
+
+/// @brief A document compressed with zlib.
+struct CompressedDocument
+{
+    std::vector<unsigned char> bytes;
+    /// The length of the expanded document.
+    size_t length{0};
+};
+
+/// @result True indicates the documents can be compressed.
+[[nodiscard]] constexpr bool haveCompression() noexcept
+{
+#ifdef WITH_ZLIB
+    return true;
+#else
+    return false;
+#endif
+}
+
+/// @result The zlib-compressed document.
+/// @throws std::runtime_error if the document cannot be compressed.
+[[nodiscard]] inline CompressedDocument compress(const std::string &document)
+{
+#ifdef WITH_ZLIB
+    CompressedDocument result;
+    result.length = document.size();
+    auto nBytes = compressBound(static_cast<uLong> (document.size()));
+    result.bytes.resize(nBytes);
+    // Demotion happens on the request path so favor speed over ratio
+    auto status
+        = compress2(result.bytes.data(), &nBytes,
+                    reinterpret_cast<const Bytef *> (document.data()),
+                    static_cast<uLong> (document.size()), Z_BEST_SPEED);
+    if (status != Z_OK)
+    {
+        throw std::runtime_error("Failed to compress document");
+    }
+    result.bytes.resize(nBytes);
+    result.bytes.shrink_to_fit();
+    return result;
+#else
+    throw std::runtime_error("Compiled without zlib");
+#endif
+}
+
+/// @result The expanded document.
+/// @throws std::runtime_error if the document cannot be decompressed.
+[[nodiscard]] inline std::string decompress(const CompressedDocument &document)
+{
+#ifdef WITH_ZLIB
+    std::string result(document.length, '\0');
+    auto nBytes = static_cast<uLongf> (document.length);
+    auto status
+        = uncompress(reinterpret_cast<Bytef *> (result.data()), &nBytes,
+                     document.bytes.data(),
+                     static_cast<uLong> (document.bytes.size()));
+    if (status != Z_OK || nBytes != document.length)
+    {
+        throw std::runtime_error("Failed to decompress document");
+    }
+    return result;
+#else
+    throw std::runtime_error("Compiled without zlib");
+#endif
+}
+
+/// @class DocumentCache "documentCache.hpp" "documentCache.hpp"
+/// @brief A two-tier, byte-bounded cache of text documents.  Documents are
+///        inserted into the hot tier expanded.  Documents evicted from the
+///        hot tier are demoted to the cold tier compressed and documents
+///        read from the cold tier are expanded and promoted back to the hot
+///        tier.  The recency of each tier is tracked by its LRU list.  If
+///        compiled without zlib then the cold tier is disabled.  This class
+///        is thread-safe.  Compression and decompression run outside the
+///        cache-wide lock; each key carries a generation that changes when
+///        the key is replaced or erased so a document is only moved between
+///        the tiers if its key was not modified in the meantime.
+/// @copyright Ben Baker (University of Utah) distributed under the MIT license.
+template<typename Key>
+class DocumentCache
+{
+public:
+    using Document = std::shared_ptr<const std::string>;
+    /// @brief Constructor.
+    /// @param[in] hotCapacity   The byte budget of the expanded documents.
+    /// @param[in] coldCapacity  The byte budget of the compressed documents.
+    DocumentCache(const size_t hotCapacity, const size_t coldCapacity) :
+        mHot(hotCapacity,
+             [](const Document &document)
+             {
+                 return sizeof(std::string) + document->capacity();
+             }),
+        mCold(haveCompression() ? coldCapacity : 0,
+              [](const std::shared_ptr<const CompressedDocument> &document)
+              {
+                  return sizeof(CompressedDocument)
+                       + document->bytes.capacity();
+              })
+    {
+    }
+    /// @result The document or NULL if it is not in the cache.
+    [[nodiscard]] Document get(const Key &key)
+    {
+        auto document = mHot.get(key);
+        if (document){return *document;}
+        std::shared_ptr<const CompressedDocument> compressed;
+        uint64_t generation{0};
+        {
+        std::scoped_lock lock(mMutex);
+        // Another thread may have promoted the document while this waited
+        if (mHot.contains(key))
+        {
+            document = mHot.get(key);
+            if (document){return *document;}
+        }
+        auto coldDocument = mCold.get(key);
+        if (!coldDocument){return nullptr;}
+        compressed = std::move(*coldDocument);
+        generation = mGenerations.at(key);
+        }
+        auto startTime = std::chrono::steady_clock::now();
+        auto expanded
+            = std::make_shared<const std::string> (decompress(*compressed));
+        auto duration
+            = std::chrono::duration_cast<std::chrono::microseconds>
+              (std::chrono::steady_clock::now() - startTime).count();
+        mDecompressions += 1;
+        mDecompressionMicroSeconds += static_cast<uint64_t> (duration);
+        auto maximum = mMaximumDecompressionMicroSeconds.load();
+        while (static_cast<uint64_t> (duration) > maximum &&
+               !mMaximumDecompressionMicroSeconds.compare_exchange_weak(
+                   maximum, static_cast<uint64_t> (duration)))
+        {
+        }
+        std::vector<Demotion> evicted;
+        {
+        std::scoped_lock lock(mMutex);
+        // If the key was replaced or erased then the expanded document is
+        // still a valid answer for this read but it must not be reinstalled
+        if (isCurrentLocked(key, generation) && !mHot.contains(key))
+        {
+            auto current = mCold.extract(key);
+            if (current)
+            {
+                mColdUncompressedBytes -= (*current)->length;
+                evicted = evictLocked(mHot.insert(key, expanded));
+                if (!mHot.contains(key)){mGenerations.erase(key);}
+            }
+        }
+        }
+        demote(std::move(evicted));
+        return expanded;
+    }
+    /// @result True indicates the key is in either tier.  This does not
+    ///         change the recency of the entry.
+    [[nodiscard]] bool contains(const Key &key) const
+    {
+        std::scoped_lock lock(mMutex);
+        return mHot.contains(key) || mCold.contains(key);
+    }
+    /// @brief Adds or replaces the document in the hot tier.
+    void insert(const Key &key, Document document)
+    {
+        std::vector<Demotion> evicted;
+        {
+        std::scoped_lock lock(mMutex);
+        auto compressed = mCold.extract(key);
+        if (compressed){mColdUncompressedBytes -= (*compressed)->length;}
+        mGeneration = mGeneration + 1;
+        mGenerations[key] = mGeneration;
+        evicted = evictLocked(mHot.insert(key, std::move(document)));
+        if (!mHot.contains(key)){mGenerations.erase(key);}
+        }
+        demote(std::move(evicted));
+    }
+    /// @brief Removes the key from both tiers.
+    void erase(const Key &key)
+    {
+        std::scoped_lock lock(mMutex);
+        mHot.erase(key);
+        auto compressed = mCold.extract(key);
+        if (compressed){mColdUncompressedBytes -= (*compressed)->length;}
+        mGenerations.erase(key);
+    }
+    /// @brief Changes the byte budget of the hot tier.  Evicted documents
+    ///        are demoted.
+    void setCapacity(const size_t capacity)
+    {
+        std::vector<Demotion> evicted;
+        {
+        std::scoped_lock lock(mMutex);
+        evicted = evictLocked(mHot.setCapacity(capacity));
+        }
+        demote(std::move(evicted));
+    }
+    /// @brief Changes the byte budget of the cold tier.
+    void setColdCapacity(const size_t capacity)
+    {
+        if (!haveCompression()){return;}
+        std::scoped_lock lock(mMutex);
+        forgetLocked(mCold.setCapacity(capacity));
+    }
+    /// @result The cache statistics.  The cold tier hits and misses count
+    ///         the reads that missed the hot tier.
+    [[nodiscard]] DocumentCacheStatistics getStatistics() const
+    {
+        DocumentCacheStatistics statistics;
+        statistics.hot = mHot.getStatistics();
+        statistics.cold = mCold.getStatistics();
+        statistics.coldUncompressedBytes = mColdUncompressedBytes.load();
+        statistics.decompressions = mDecompressions.load();
+        statistics.decompressionMicroSeconds
+            = mDecompressionMicroSeconds.load();
+        statistics.maximumDecompressionMicroSeconds
+            = mMaximumDecompressionMicroSeconds.load();
+        return statistics;
+    }
+private:
+    /// A document evicted from the hot tier and the generation of its key
+    /// at the time.
+    struct Demotion
+    {
+        Key key;
+        Document document;
+        uint64_t generation{0};
+    };
+    [[nodiscard]] bool isCurrentLocked(const Key &key,
+                                       const uint64_t generation) const
+    {
+        auto idx = mGenerations.find(key);
+        return idx != mGenerations.end() && idx->second == generation;
+    }
+    /// Records the generations of the documents evicted from the hot tier.
+    /// Without a cold tier the evicted documents are gone.
+    [[nodiscard]] std::vector<Demotion> evictLocked(
+        std::vector<std::pair<Key, Document>> &&evicted)
+    {
+        std::vector<Demotion> result;
+        for (auto &entry : evicted)
+        {
+            auto idx = mGenerations.find(entry.first);
+            if (idx == mGenerations.end()){continue;}
+            if (!haveCompression())
+            {
+                mGenerations.erase(idx);
+                continue;
+            }
+            result.push_back(Demotion {entry.first,
+                                       std::move(entry.second),
+                                       idx->second});
+        }
+        return result;
+    }
+    /// Compresses the evicted documents without the lock then installs
+    /// those whose keys were not replaced or erased in the meantime.
+    void demote(std::vector<Demotion> &&evicted)
+    {
+        if (evicted.empty()){return;}
+        std::vector<std::shared_ptr<const CompressedDocument>> compressed;
+        compressed.reserve(evicted.size());
+        for (const auto &entry : evicted)
+        {
+            compressed.push_back(
+                std::make_shared<const CompressedDocument>
+                (compress(*entry.document)));
+        }
+        std::scoped_lock lock(mMutex);
+        for (size_t i = 0; i < evicted.size(); ++i)
+        {
+            const auto &key = evicted[i].key;
+            if (!isCurrentLocked(key, evicted[i].generation) ||
+                mHot.contains(key) || mCold.contains(key))
+            {
+                continue;
+            }
+            auto length = compressed[i]->length;
+            forgetLocked(mCold.insert(key, std::move(compressed[i])));
+            if (mCold.contains(key))
+            {
+                mColdUncompressedBytes += length;
+            }
+            else
+            {
+                mGenerations.erase(key);
+            }
+        }
+    }
+    void forgetLocked(
+        const std::vector<std::pair<Key, std::shared_ptr<const CompressedDocument>>> &evicted)
+    {
+        for (const auto &entry : evicted)
+        {
+            mColdUncompressedBytes -= entry.second->length;
+            if (!mHot.contains(entry.first))
+            {
+                mGenerations.erase(entry.first);
+            }
+        }
+    }
+    mutable std::mutex mMutex;
+    LRUCache<Key, Document> mHot;
+    LRUCache<Key, std::shared_ptr<const CompressedDocument>> mCold;
+    /// The generation of each key in either tier or being demoted.
+    std::unordered_map<Key, uint64_t> mGenerations;
+    uint64_t mGeneration{0};
+    std::atomic<size_t> mColdUncompressedBytes{0};
+    std::atomic<uint64_t> mDecompressions{0};
+    std::atomic<uint64_t> mDecompressionMicroSeconds{0};
+    std::atomic<uint64_t> mMaximumDecompressionMicroSeconds{0};
+};
+}
+#endif
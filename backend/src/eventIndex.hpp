@@ -0,0 +1,128 @@
+#ifndef CCT_BACKEND_SERVICE_EVENT_INDEX_HPP
+#define CCT_BACKEND_SERVICE_EVENT_INDEX_HPP
+#include <vector>
+#include <cstdint>
+#include <optional>
+#include <limits>
+#include <algorithm>
+#include <stdexcept>
+#include "chunkedArray.hpp"
+namespace CCTService
+{
+/// @class EventIndex "eventIndex.hpp" "eventIndex.hpp"
+/// @brief An open-addressing (linear probing) hash index that maps an
+///        integer event identifier to the event's row in contiguous storage.
+///        The keys and rows are stored in flat arrays so that a lookup
+///        typically touches a single cache line.  The arrays are chunked so
+///        copies of the index share the slots that have not changed.
+/// @note Event identifiers must be non-negative.
+/// @copyright Ben Baker (University of Utah) distributed under the MIT license.
+class EventIndex
+{
+public:
+    /// @result The row of the event if it exists.
+    [[nodiscard]] std::optional<uint32_t> find(const int64_t identifier) const noexcept
+    {
+        if (mSize == 0){return std::nullopt;}
+        for (auto slot = getHomeSlot(identifier); ;
+             slot = (slot + 1) & mMask)
+        {
+            if (mKeys[slot] == identifier){return mRows[slot];}
+            if (mKeys[slot] == mEmpty){return std::nullopt;}
+        }
+    }
+    /// @result True indicates the identifier is in the index.
+    [[nodiscard]] bool contains(const int64_t identifier) const noexcept
+    {
+        return find(identifier).has_value();
+    }
+    /// @brief Adds the identifier or updates its row.
+    /// @throws std::invalid_argument if the identifier is negative.
+    void insertOrAssign(const int64_t identifier, const uint32_t row)
+    {
+        if (identifier < 0)
+        {
+            throw std::invalid_argument("Identifier must be non-negative");
+        }
+        // Keep the load factor at or below 1/2 so probe sequences stay short
+        if (2*(mSize + 1) > mKeys.size()){rehash(std::max<size_t> (16, 2*mKeys.size()));}
+        auto slot = getHomeSlot(identifier);
+        while (mKeys[slot] != mEmpty && mKeys[slot] != identifier)
+        {
+            slot = (slot + 1) & mMask;
+        }
+        if (mKeys[slot] == mEmpty){mSize = mSize + 1;}
+        mKeys.set(slot, identifier);
+        mRows.set(slot, row);
+    }
+    /// @brief Removes the identifier from the index.
+    /// @result True indicates the identifier was removed.
+    bool erase(const int64_t identifier) noexcept
+    {
+        if (mSize == 0){return false;}
+        auto slot = getHomeSlot(identifier);
+        while (mKeys[slot] != identifier)
+        {
+            if (mKeys[slot] == mEmpty){return false;}
+            slot = (slot + 1) & mMask;
+        }
+        // Backward-shift deletion so no tombstones are required
+        auto hole = slot;
+        for (auto next = (hole + 1) & mMask;
+             mKeys[next] != mEmpty;
+             next = (next + 1) & mMask)
+        {
+            auto home = getHomeSlot(mKeys[next]);
+            // Move the entry into the hole if its home is not in (hole, next]
+            if (((next - home) & mMask) >= ((next - hole) & mMask))
+            {
+                mKeys.set(hole, mKeys[next]);
+                mRows.set(hole, mRows[next]);
+                hole = next;
+            }
+        }
+        mKeys.set(hole, mEmpty);
+        mSize = mSize - 1;
+        return true;
+    }
+    /// @brief Removes all identifiers.
+    void clear() noexcept
+    {
+        mKeys.clear();
+        mRows.clear();
+        mMask = 0;
+        mSize = 0;
+    }
+    /// @result The number of identifiers in the index.
+    [[nodiscard]] size_t size() const noexcept
+    {
+        return mSize;
+    }
+private:
+    [[nodiscard]] size_t getHomeSlot(const int64_t identifier) const noexcept
+    {
+        // Fibonacci hashing scatters sequential identifiers
+        auto hash = static_cast<uint64_t> (identifier)*11400714819323198485ull;
+        return static_cast<size_t> (hash >> 32) & mMask;
+    }
+    void rehash(const size_t capacity)
+    {
+        ChunkedArray<int64_t> keys(capacity, mEmpty);
+        ChunkedArray<uint32_t> rows(capacity, 0);
+        std::swap(keys, mKeys);
+        std::swap(rows, mRows);
+        mMask = capacity - 1;
+        mSize = 0;
+        for (size_t i = 0; i < keys.size(); ++i)
+        {
+            if (keys[i] != mEmpty){insertOrAssign(keys[i], rows[i]);}
+        }
+    }
+    static constexpr int64_t mEmpty{-1};
+    ChunkedArray<int64_t> mKeys;
+    ChunkedArray<uint32_t> mRows;
+    size_t mMask{0};
+    size_t mSize{0};
+};
+}
+#endif
@@ -0,0 +1,422 @@
+#ifndef CCT_BACKEND_SERVICE_EVENT_MODEL_HPP
+#define CCT_BACKEND_SERVICE_EVENT_MODEL_HPP
+#include <string>
+#include <string_view>
+#include <vector>
+#include <array>
+#include <optional>
+#include <limits>
+#include <charconv>
+#include <cstdint>
+#include <cmath>
+#include <cstring>
+#include <cstdio>
+#include "stationNameTable.hpp"
+namespace CCTService
+{
+/// @brief The quantities required to create the network magnitude when the
+///        event is accepted.  Negative values indicate the quantity could
+///        not be computed.
+struct NetMagInputs
+{
+    double magnitude{-10};
+    /// Distance to the closest station in km.
+    double closestDistance{-1};
+    /// Azimuthal gap in degrees.
+    double azimuthalGap{-1};
+    int nStations{-1};
+    int nObservations{-1};
+};
+
+/// @brief The summary required by the frontend's event table.
+struct EventSummary
+{
+    int64_t identifier{-1};
+    /// The origin time, e.g., 2024-01-01T00:00:00.000.
+    std::string originTime;
+    double latitude{0};
+    double longitude{0};
+    double depth{0};
+    bool likelyPoorlyConstrained{false};
+    double cctMagnitude{std::numeric_limits<double>::quiet_NaN()};
+    std::string cctMagnitudeType;
+    double authoritativeMagnitude{std::numeric_limits<double>::quiet_NaN()};
+    std::string authoritativeMagnitudeType;
+    std::string reviewStatus;
+    std::string creationMode;
+    /// The accept-time network magnitude inputs computed at ingest.
+    NetMagInputs netMagInputs;
+};
+
+/// @brief A spectrum stored as a structure of arrays.
+struct Spectrum
+{
+    /// The frequencies in Hz.
+    std::vector<double> frequencies;
+    /// The spectral values.
+    std::vector<double> values;
+};
+
+/// @brief The fit spectrum and its uncertainty bounds.
+struct SpectralFit
+{
+    std::optional<Spectrum> fit;
+    std::optional<Spectrum> bruneLowerBound1;
+    std::optional<Spectrum> bruneUpperBound1;
+    std::optional<Spectrum> bruneLowerBound2;
+    std::optional<Spectrum> bruneUpperBound2;
+};
+
+/// @brief The measurements at a station sorted by center frequency and
+///        stored as a structure of arrays.
+struct StationMeasurements
+{
+    /// The station's identifier in the station name table.
+    int32_t station{-1};
+    std::vector<double> centerFrequencies;
+    std::vector<double> values;
+    /// The residual with respect to the fit.  This is NaN if the fit has
+    /// no value at the center frequency.
+    std::vector<double> residuals;
+};
+
+/// @brief The spectral fit and station measurements required to plot
+///        the event.
+struct EventDetails
+{
+    SpectralFit spectralFit;
+    std::vector<StationMeasurements> stationMeasurements;
+};
+
+/// @brief Appends a number to the JSON string.  Non-finite numbers are
+///        written as null.
+inline void appendJSONNumber(std::string &json, const double value)
+{
+    if (!std::isfinite(value))
+    {
+        json.append("null");
+        return;
+    }
+    char buffer[32];
+    auto [end, ec] = std::to_chars(buffer, buffer + sizeof(buffer), value);
+    json.append(buffer, end);
+}
+
+/// @brief Appends an integer to the JSON string.
+inline void appendJSONNumber(std::string &json, const int64_t value)
+{
+    char buffer[24];
+    auto [end, ec] = std::to_chars(buffer, buffer + sizeof(buffer), value);
+    json.append(buffer, end);
+}
+
+/// @brief Appends a quoted and escaped string to the JSON string.
+inline void appendJSONString(std::string &json, const std::string &value)
+{
+    json.push_back('"');
+    for (const auto &c : value)
+    {
+        switch (c)
+        {
+            case '"':  json.append("\\\""); break;
+            case '\\': json.append("\\\\"); break;
+            case '\b': json.append("\\b"); break;
+            case '\f': json.append("\\f"); break;
+            case '\n': json.append("\\n"); break;
+            case '\r': json.append("\\r"); break;
+            case '\t': json.append("\\t"); break;
+            default:
+                if (static_cast<unsigned char> (c) < 0x20)
+                {
+                    char buffer[8];
+                    std::snprintf(buffer, sizeof(buffer), "\\u%04x",
+                                  static_cast<unsigned int> (c));
+                    json.append(buffer);
+                }
+                else
+                {
+                    json.push_back(c);
+                }
+        }
+    }
+    json.push_back('"');
+}
+
+/// @brief Appends an array of numbers to the JSON string.
+inline void appendJSONArray(std::string &json,
+                            const std::vector<double> &values)
+{
+    json.push_back('[');
+    for (size_t i = 0; i < values.size(); ++i)
+    {
+        if (i > 0){json.push_back(',');}
+        appendJSONNumber(json, values[i]);
+    }
+    json.push_back(']');
+}
+
+/// @brief Appends the number or null if it is not valid.
+inline void appendJSONOptional(std::string &json, const double value,
+                               const bool valid)
+{
+    if (valid)
+    {
+        appendJSONNumber(json, value);
+    }
+    else
+    {
+        json.append("null");
+    }
+}
+
+/// @brief Appends the count or null if it is negative.
+inline void appendJSONCount(std::string &json, const int count)
+{
+    if (count >= 0)
+    {
+        appendJSONNumber(json, static_cast<int64_t> (count));
+    }
+    else
+    {
+        json.append("null");
+    }
+}
+
+/// @brief A key of the summary's JSON object and the function writing its
+///        value.
+struct SummaryField
+{
+    std::string_view key;
+    void (*append)(std::string &json, const EventSummary &summary);
+};
+
+/// The summary's keys in the same (sorted) order as nlohmann::json would
+/// write them.
+inline constexpr std::array<SummaryField, 17> summaryFields
+{{
+    {"authoritativeMagnitude",
+     [](std::string &json, const EventSummary &summary)
+     {
+         appendJSONNumber(json, summary.authoritativeMagnitude);
+     }},
+    {"authoritativeMagnitudeType",
+     [](std::string &json, const EventSummary &summary)
+     {
+         appendJSONString(json, summary.authoritativeMagnitudeType);
+     }},
+    {"azimuthalGap",
+     [](std::string &json, const EventSummary &summary)
+     {
+         const auto gap = summary.netMagInputs.azimuthalGap;
+         appendJSONOptional(json, gap, gap >= 0 && gap <= 360);
+     }},
+    {"cctMagnitude",
+     [](std::string &json, const EventSummary &summary)
+     {
+         appendJSONNumber(json, summary.cctMagnitude);
+     }},
+    {"cctMagnitudeType",
+     [](std::string &json, const EventSummary &summary)
+     {
+         appendJSONString(json, summary.cctMagnitudeType);
+     }},
+    {"closestDistance",
+     [](std::string &json, const EventSummary &summary)
+     {
+         const auto distance = summary.netMagInputs.closestDistance;
+         appendJSONOptional(json, distance, distance >= 0);
+     }},
+    {"creationMode",
+     [](std::string &json, const EventSummary &summary)
+     {
+         appendJSONString(json, summary.creationMode);
+     }},
+    {"depth",
+     [](std::string &json, const EventSummary &summary)
+     {
+         appendJSONNumber(json, summary.depth);
+     }},
+    {"eventIdentifier",
+     [](std::string &json, const EventSummary &summary)
+     {
+         appendJSONString(json, std::to_string(summary.identifier));
+     }},
+    {"latitude",
+     [](std::string &json, const EventSummary &summary)
+     {
+         appendJSONNumber(json, summary.latitude);
+     }},
+    {"likelyPoorlyConstrained",
+     [](std::string &json, const EventSummary &summary)
+     {
+         json.append(summary.likelyPoorlyConstrained ? "true" : "false");
+     }},
+    {"longitude",
+     [](std::string &json, const EventSummary &summary)
+     {
+         appendJSONNumber(json, summary.longitude);
+     }},
+    {"mw",
+     [](std::string &json, const EventSummary &summary)
+     {
+         const auto magnitude = summary.netMagInputs.magnitude;
+         appendJSONOptional(json, magnitude, magnitude > -10);
+     }},
+    {"numberOfObservations",
+     [](std::string &json, const EventSummary &summary)
+     {
+         appendJSONCount(json, summary.netMagInputs.nObservations);
+     }},
+    {"numberOfStations",
+     [](std::string &json, const EventSummary &summary)
+     {
+         appendJSONCount(json, summary.netMagInputs.nStations);
+     }},
+    {"originTime",
+     [](std::string &json, const EventSummary &summary)
+     {
+         appendJSONString(json, summary.originTime);
+     }},
+    {"reviewStatus",
+     [](std::string &json, const EventSummary &summary)
+     {
+         appendJSONString(json, summary.reviewStatus);
+     }},
+}};
+
+/// @result The summary field with the given key or NULL if there is none.
+[[nodiscard]] inline const SummaryField *
+    findSummaryField(const std::string_view key) noexcept
+{
+    for (const auto &field : summaryFields)
+    {
+        if (field.key == key){return &field;}
+    }
+    return nullptr;
+}
+
+/// @result The summary as the JSON object expected by the frontend's
+///         event table.  The keys are in the same (sorted) order as
+///         nlohmann::json would write them.
+[[nodiscard]] inline std::string toJSONString(const EventSummary &summary)
+{
+    std::string json;
+    json.reserve(512);
+    json.push_back('{');
+    for (const auto &field : summaryFields)
+    {
+        if (json.size() > 1){json.push_back(',');}
+        json.push_back('"');
+        json.append(field.key);
+        json.append("\":");
+        field.append(json, summary);
+    }
+    json.push_back('}');
+    return json;
+}
+
+/// @brief Appends the spectral fit or null if there is none.
+inline void appendJSONSpectralFit(std::string &json,
+                                  const EventDetails &details)
+{
+    auto appendSpectrum = [](std::string &json, const char *name,
+                             const std::optional<Spectrum> &spectrum,
+                             bool &first)
+    {
+        if (!spectrum){return;}
+        if (!first){json.push_back(',');}
+        first = false;
+        json.push_back('"');
+        json.append(name);
+        json.append("\":{\"frequencies\":");
+        appendJSONArray(json, spectrum->frequencies);
+        json.append(",\"values\":");
+        appendJSONArray(json, spectrum->values);
+        json.push_back('}');
+    };
+    const auto &spectralFit = details.spectralFit;
+    if (!spectralFit.fit &&
+        !spectralFit.bruneLowerBound1 && !spectralFit.bruneUpperBound1 &&
+        !spectralFit.bruneLowerBound2 && !spectralFit.bruneUpperBound2)
+    {
+        json.append("null");
+        return;
+    }
+    bool first{true};
+    json.push_back('{');
+    appendSpectrum(json, "bruneLowerBound-1",
+                   spectralFit.bruneLowerBound1, first);
+    appendSpectrum(json, "bruneLowerBound-2",
+                   spectralFit.bruneLowerBound2, first);
+    appendSpectrum(json, "bruneUpperBound-1",
+                   spectralFit.bruneUpperBound1, first);
+    appendSpectrum(json, "bruneUpperBound-2",
+                   spectralFit.bruneUpperBound2, first);
+    appendSpectrum(json, "fit", spectralFit.fit, first);
+    json.push_back('}');
+}
+
+/// @brief Appends the array of station measurements.
+/// @param[in] stationNames  Resolves the station identifiers to names.
+///                              If NULL then the identifiers are written.
+inline void appendJSONStationMeasurements(
+    std::string &json,
+    const EventDetails &details,
+    const StationNameTable *stationNames)
+{
+    json.push_back('[');
+    for (size_t i = 0; i < details.stationMeasurements.size(); ++i)
+    {
+        const auto &station = details.stationMeasurements[i];
+        if (i > 0){json.push_back(',');}
+        json.append("{\"measurements\":[");
+        for (size_t j = 0; j < station.values.size(); ++j)
+        {
+            if (j > 0){json.push_back(',');}
+            json.append("{\"centerFrequency\":");
+            appendJSONNumber(json, station.centerFrequencies[j]);
+            json.append(",\"residual\":");
+            appendJSONNumber(json, station.residuals[j]);
+            json.append(",\"value\":");
+            appendJSONNumber(json, station.values[j]);
+            json.push_back('}');
+        }
+        json.append("],\"station\":");
+        if (stationNames)
+        {
+            appendJSONString(json,
+                             stationNames->getName(station.station));
+        }
+        else
+        {
+            appendJSONString(json, std::to_string(station.station));
+        }
+        json.push_back('}');
+    }
+    json.push_back(']');
+}
+
+/// @result The event's spectral fit and station measurements as the JSON
+///         object expected by the frontend's plots.
+/// @param[in] details           The details.
+/// @param[in] eventIdentifier   The event identifier.
+/// @param[in] stationNames  Resolves the station identifiers to names.
+///                              If NULL then the identifiers are written.
+[[nodiscard]] inline std::string
+    toJSONString(const EventDetails &details,
+                 const int64_t eventIdentifier,
+                 const StationNameTable *stationNames)
+{
+    std::string json;
+    json.append("{\"eventIdentifier\":");
+    appendJSONString(json, std::to_string(eventIdentifier));
+    json.append(",\"spectralFit\":");
+    appendJSONSpectralFit(json, details);
+    json.append(",\"stationMeasurements\":");
+    appendJSONStationMeasurements(json, details, stationNames);
+    json.push_back('}');
+    return json;
+}
+
+}
+#endif
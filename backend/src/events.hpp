@@ -2,13 +2,226 @@
 #define CCT_BACKEND_SERVICE_EVENTS_HPP
 #include <string>
 #include <chrono>
+#include <map>
+#include <set>
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <cmath>
+#include <limits>
+#include <algorithm>
+#include <string_view>
+#include <atomic>
 #include <nlohmann/json.hpp>
+#include "eventModel.hpp"
+#include "stationNameTable.hpp"
+#include "catalogIndex.hpp"
+#include "eventIndex.hpp"
+#include "changeJournal.hpp"
+#include "chunkedArray.hpp"
 namespace CCTService
 {
+/// @brief Converts an event identifier string, e.g., 60012345 or
+///        uu60012345, to an integer.
+/// @throws std::invalid_argument if the identifier cannot be converted.
+[[nodiscard]] inline int64_t convertEventIdentifier(const std::string &eventIdentifier)
+{
+    if (eventIdentifier.empty())
+    {   
+        throw std::invalid_argument("Event identifier is empty");
+    }   
+    int64_t identifier{-1};
+    try 
+    {   
+        identifier = std::stol(eventIdentifier);    
+    }   
+    catch (...)
+    {   
+        try
+        {
+            // Might be in form of uu8238239 so pop uu
+            auto temporaryIdentifier = eventIdentifier;
+            if (temporaryIdentifier.size() > 2)
+            {
+                temporaryIdentifier.erase(0, 2); 
+            }
+            identifier = std::stol(temporaryIdentifier);
+        }
+        catch (const std::exception &e) 
+        {
+            throw std::invalid_argument("Could not convert "
+                                      + eventIdentifier + " to an integer");
+        }
+    }   
+    if (identifier < 0)
+    {   
+        throw std::invalid_argument("Could not convert "
+                                  + eventIdentifier + " to an integer");
+    }   
+    return identifier;
+}
+
+/// @brief Converts a named section of the mw_data document, e.g.,
+///        measuredMwDetails, fitSpectra, or spectraMeasurements, to the
+///        JSON Pointer of that section for the given event.
+/// @throws std::invalid_argument if the section is not handled.
+[[nodiscard]] inline std::string
+    sectionToJSONPointer(const std::string &section,
+                         const std::string &eventIdentifier)
+{
+    if (section != "measuredMwDetails" &&
+        section != "fitSpectra" &&
+        section != "spectraMeasurements")
+    {
+        throw std::invalid_argument("Unhandled section: " + section);
+    }
+    std::string escapedIdentifier;
+    for (const auto &c : eventIdentifier)
+    {
+        if (c == '~'){escapedIdentifier += "~0";}
+        else if (c == '/'){escapedIdentifier += "~1";}
+        else {escapedIdentifier.push_back(c);}
+    }
+    return "/" + section + "/" + escapedIdentifier;
+}
+
+/// @result True indicates the spectra measurement was made at the station,
+///         e.g., UU.CTU.
+[[nodiscard]] inline bool isMeasurementAtStation(
+    const nlohmann::json &spectraMeasurement, const std::string &name)
+{
+    if (!spectraMeasurement.is_object() ||
+        !spectraMeasurement.contains("waveform")){return false;}
+    const auto &waveform = spectraMeasurement["waveform"];
+    if (!waveform.is_object() || !waveform.contains("stream")){return false;}
+    const auto &stream = waveform["stream"];
+    if (!stream.is_object() || !stream.contains("station")){return false;}
+    const auto &station = stream["station"];
+    if (!station.contains("networkName") ||
+        !station.contains("stationName")){return false;}
+    return station["networkName"].template get<std::string> ()
+         + "."
+         + station["stationName"].template get<std::string> () == name;
+}
+
+/// @result An estimate of the heap memory in bytes used by the array.
+template<typename T>
+[[nodiscard]] size_t estimateMemoryUsage(const std::vector<T> &values)
+{
+    return values.capacity()*sizeof(T);
+}
+
+/// @result An estimate of the heap memory in bytes used by the string.
+[[nodiscard]] inline size_t estimateMemoryUsage(const std::string &value)
+{
+    // Short strings fit in the small string buffer
+    return value.capacity() > 15 ? value.capacity() + 1 : 0;
+}
+
+/// @result An estimate of the heap memory in bytes used by the details.
+[[nodiscard]] inline size_t estimateMemoryUsage(const EventDetails &details)
+{
+    size_t result{0};
+    for (const auto &spectrum : {&details.spectralFit.fit,
+                                 &details.spectralFit.bruneLowerBound1,
+                                 &details.spectralFit.bruneUpperBound1,
+                                 &details.spectralFit.bruneLowerBound2,
+                                 &details.spectralFit.bruneUpperBound2})
+    {
+        if (*spectrum)
+        {
+            result = result + estimateMemoryUsage((*spectrum)->frequencies)
+                   + estimateMemoryUsage((*spectrum)->values);
+        }
+    }
+    result = result + estimateMemoryUsage(details.stationMeasurements);
+    for (const auto &station : details.stationMeasurements)
+    {
+        result = result + estimateMemoryUsage(station.centerFrequencies)
+               + estimateMemoryUsage(station.values)
+               + estimateMemoryUsage(station.residuals);
+    }
+    return result;
+}
+
+/// @brief Defines which events are kept in memory.  Events violating any
+///        limit are evicted oldest first but can still be fetched from the
+///        database.  An unset limit is not enforced.
+struct RetentionPolicy
+{
+    /// Defines the time from which an event's age is measured.
+    enum class AgeReference
+    {
+        OriginTime, /*!< The event's origin time. */
+        LoadTime    /*!< The time the event was loaded into memory. */
+    };
+    /// The maximum age of an event.
+    std::optional<std::chrono::seconds> maximumAge;
+    /// The maximum number of events.
+    std::optional<size_t> maximumCount;
+    /// The maximum estimated memory usage in bytes of the events.
+    std::optional<size_t> maximumBytes;
+    /// Defines how the age is measured.  This also defines which event
+    /// is oldest when enforcing the count and byte limits.
+    AgeReference ageReference{AgeReference::OriginTime};
+};
+
+/// @brief Summarizes the memory used by the cached events of a schema.
+struct CatalogStatistics
+{
+    /// The number of events in memory.
+    size_t eventCount{0};
+    /// The estimated memory usage in bytes of the events.
+    size_t memoryUsage{0};
+    /// The estimated memory usage in bytes of the largest event.
+    size_t largestEventMemoryUsage{0};
+    /// The number of events evicted by the retention policy.
+    uint64_t evictedCount{0};
+    /// The catalog version.
+    uint64_t version{0};
+};
+
+/// @brief The changes to the catalog since a client's last synchronization.
+struct CatalogDelta
+{
+    /// Identifies the catalog's history.  Versions from a different epoch,
+    /// e.g., from before a restart, cannot be synchronized.
+    uint64_t epoch{0};
+    /// The catalog version after applying the delta.
+    uint64_t version{0};
+    /// True indicates the journal no longer holds the changes since the
+    /// client's version so the events are the entire catalog.
+    bool isSnapshot{false};
+    /// The summaries of the added and changed events as a JSON array.
+    std::string events{"[]"};
+    /// The identifiers of the removed and evicted events.
+    std::vector<int64_t> removed;
+};
+
 struct Event
 {
-    nlohmann::json mLightWeightData;
-    nlohmann::json mFullData;
+    /// The summary required by the frontend's event table.
+    EventSummary mSummary;
+    /// The spectral fit and station measurements required to plot the event.
+    /// These are immutable so copies of the event, e.g., one with a new
+    /// review status, share them rather than copying the measurements.
+    std::shared_ptr<const EventDetails> mDetails
+    {
+        std::make_shared<const EventDetails> ()
+    };
+    /// The summary serialized without indentation.  This is set by Events
+    /// on insert or update and is spliced into the catalog payload.
+    std::string mLightWeightFragment;
+    /// The estimated memory usage in bytes of the event.  This is set by
+    /// Events on insert or update.
+    size_t mMemoryUsage{0};
+    /// The content digest of the summary and details.  This is set by
+    /// Events on insert or update.
+    uint64_t mDigest{0};
+    /// The UNIX time at which the event's row was last updated in the
+    /// database or 0 if unknown.  Data cached alongside the catalog that is
+    /// older than this is stale.
+    double mLastUpdate{0};
     std::chrono::milliseconds mCreationTime
     {
         std::chrono::duration_cast<std::chrono::milliseconds>
@@ -17,95 +230,607 @@ struct Event
         )
     };
 };
+/// @brief Serializes the selected subtrees of the event's full document.
+/// @param[in] fullData   The event's parsed mw_data document.
+/// @param[in] selectors  Maps each output key to a JSON Pointer into the
+///                       event's mw_data document.
+/// @param[in] station    If not empty then arrays of spectra measurements
+///                       are reduced to this station's measurements,
+///                       e.g., UU.CTU.
+/// @result A JSON object mapping each key to its subtree or null if the
+///         subtree does not exist.
+/// @throws std::invalid_argument if a pointer is malformed.
+[[nodiscard]] inline std::string
+    fullDataToString(const nlohmann::json &fullData,
+                     const std::map<std::string, std::string> &selectors,
+                     const std::string &station,
+                     const int indent =-1)
+{
+    std::string result{"{"};
+    bool first{true};
+    for (const auto &selector : selectors)
+    {
+        nlohmann::json::json_pointer pointer;
+        try
+        {
+            pointer = nlohmann::json::json_pointer {selector.second};
+        }
+        catch (const std::exception &e)
+        {
+            throw std::invalid_argument("Invalid JSON pointer: "
+                                      + selector.second);
+        }
+        if (!first){result += ",";}
+        first = false;
+        result += nlohmann::json(selector.first).dump() + ":";
+        if (!fullData.contains(pointer))
+        {
+            result += "null";
+            continue;
+        }
+        const auto &subtree = fullData.at(pointer);
+        if (!station.empty() && subtree.is_array() &&
+            !subtree.empty() && subtree[0].contains("waveform"))
+        {
+            auto measurements = nlohmann::json::array();
+            for (const auto &measurement : subtree)
+            {
+                if (isMeasurementAtStation(measurement, station))
+                {
+                    measurements.push_back(measurement);
+                }
+            }
+            result += measurements.dump(indent);
+        }
+        else
+        {
+            result += subtree.dump(indent);
+        }
+    }
+    result += "}";
+    return result;
+}
+
+/// @brief Serializes the selected subtrees of the event's full document.
+/// @param[in] fullDataText  The event's mw_data document as text.  This is
+///                          parsed so callers reading the same document
+///                          repeatedly should keep the parsed document.
+/// @throws std::invalid_argument if a pointer is malformed.
+[[nodiscard]] inline std::string
+    fullDataToString(const std::string &fullDataText,
+                     const std::map<std::string, std::string> &selectors,
+                     const std::string &station,
+                     const int indent =-1)
+{
+    return fullDataToString(nlohmann::json::parse(fullDataText),
+                            selectors, station, indent);
+}
+
+/// @class Events "events.hpp" "events.hpp"
+/// @brief The cached events of a schema.  The events are stored contiguously
+///        and are found by their integer identifier through an open-addressing
+///        hash index.  Events are immutable once added and the storage,
+///        indices, and journal are chunked so a copy of the catalog shares
+///        everything but the chunks it modifies.  Building the next snapshot
+///        to change one event is therefore proportional to the number of
+///        chunks rather than the number of events.  This class is not
+///        thread-safe; the service publishes it as an immutable snapshot.
 class Events
 {
 public:
     Events() = default;
-    ~Events() = default;
-    void insert(const std::pair<std::string, Event> &event)
+    /// @brief Creates an empty catalog whose station identifiers are
+    ///        resolved to names with the given station name table.
+    explicit Events(std::shared_ptr<const StationNameTable> stationNames) :
+        mStationNames(std::move(stationNames))
     {
-        auto copy = event;
-        insert(std::move(copy));
     }
-    void insert(std::pair<std::string, Event> &&event)
+    /// @brief Sets the number of changes kept in the journal.  This discards
+    ///        the journal so clients will next receive a full snapshot.
+    /// @throws std::invalid_argument if the capacity is 0.
+    void setJournalCapacity(const size_t capacity)
+    {
+        mJournal = ChangeJournal {capacity};
+        mJournal.reset(mVersion);
+    }
+    ~Events() = default;
+    /// @brief Adds the event.  The event is moved into a shared handle so
+    ///        it is never copied thereafter.
+    /// @throws std::invalid_argument if the event already exists.
+    void insert(std::pair<int64_t, Event> &&event)
     {
         if (contains(event.first))
         {
-            throw std::invalid_argument(event.first + " already exists");
+            throw std::invalid_argument(std::to_string(event.first)
+                                      + " already exists");
+        }
+        if (mEvents.size() >= std::numeric_limits<uint32_t>::max())
+        {
+            throw std::runtime_error("Too many events");
         }
-        mEvents.insert(std::move(event));
+        auto row = static_cast<uint32_t> (mEvents.size());
+        if (event.second.mLightWeightFragment.empty()){derive(event);}
+        mIndex.insertOrAssign(event.first, row);
+        mCatalogIndex.append(event.first, event.second.mSummary);
+        mIdentifiers.push_back(event.first);
+        mHash = mHash + event.second.mDigest;
+        mMemoryUsage = mMemoryUsage + event.second.mMemoryUsage;
+        mVersion = mVersion + 1;
+        mJournal.append(Change {mVersion, event.first, Change::Type::Insert});
+        mEvents.push_back(std::make_shared<const Event> (std::move(event.second)));
     }
-    void update(const std::pair<std::string, Event> &event)
+    /// @brief Sets the event's serialized summary, digest, and memory usage.
+    ///        Insert and update do this for events that were not derived, so
+    ///        this only needs to be called to move the work off the thread
+    ///        building the catalog.  The summary must not change afterwards.
+    static void derive(std::pair<int64_t, Event> &event)
     {
-        auto copy = event;
-        update(std::move(copy));
+        event.second.mLightWeightFragment
+            = toJSONString(event.second.mSummary);
+        event.second.mDigest = computeDigest(event.first, event.second);
+        event.second.mMemoryUsage = computeMemoryUsage(event.second);
     }
-    void update(std::pair<std::string, Event> &&event)
+    /// @brief Replaces the event or adds it if it does not exist.
+    void update(std::pair<int64_t, Event> &&event)
     {
-        if (!contains(event.first))
+        auto row = mIndex.find(event.first);
+        if (!row)
         {
             insert(std::move(event));
             return;
         }
-        mEvents[event.first] = std::move(event.second);
-    }
-    void generateHash()
-    {
-        if (mEvents.empty())
-        {
-            mHash = 0;
-        }
-        else
+        if (event.second.mLightWeightFragment.empty()){derive(event);}
+        if (event.second.mDigest != mEvents[*row]->mDigest)
         {
-            std::string jsonString = lightWeightDataToString(-1);
-            mHash = std::hash<std::string> {}(jsonString);
+            mHash = mHash - mEvents[*row]->mDigest + event.second.mDigest;
+            mVersion = mVersion + 1;
+            auto type = event.second.mSummary.reviewStatus
+                     != mEvents[*row]->mSummary.reviewStatus ?
+                        Change::Type::ReviewStatus : Change::Type::Update;
+            mJournal.append(Change {mVersion, event.first, type});
         }
+        mMemoryUsage = mMemoryUsage - mEvents[*row]->mMemoryUsage
+                     + event.second.mMemoryUsage;
+        mCatalogIndex.update(*row, event.second.mSummary);
+        mEvents.set(*row,
+                    std::make_shared<const Event> (std::move(event.second)));
+    }
+    /// @brief Removes the event.  The last event is moved into its row.
+    /// @result True indicates the event was removed.
+    bool erase(const int64_t identifier)
+    {
+        return erase(identifier, Change::Type::Erase);
     }
     void clear() noexcept
     {
         mEvents.clear();
+        mIdentifiers.clear();
+        mIndex.clear();
+        mCatalogIndex.clear();
+        mHash = 0;
+        mMemoryUsage = 0;
+        mVersion = mVersion + 1;
+        mJournal.reset(mVersion);
+    }
+    /// @brief Evicts the oldest events until the retention policy is
+    ///        satisfied.
+    /// @param[in] policy  The retention policy.
+    /// @param[in] now     The current time.
+    /// @result The identifiers of the evicted events.
+    std::vector<int64_t> enforce(const RetentionPolicy &policy,
+                                 const std::chrono::system_clock::time_point now)
+    {
+        std::vector<int64_t> evicted;
+        if (mEvents.empty()){return evicted;}
+        if (!policy.maximumAge && !policy.maximumCount &&
+            !policy.maximumBytes){return evicted;}
+        // Order the rows oldest first.  Unknown origin times are oldest.
+        auto nowSeconds = std::chrono::duration<double>
+                          (now.time_since_epoch()).count();
+        std::vector<std::pair<double, uint32_t>> ages(mEvents.size());
+        for (size_t row = 0; row < mEvents.size(); ++row)
+        {
+            double time{0};
+            if (policy.ageReference
+                == RetentionPolicy::AgeReference::OriginTime)
+            {
+                time = mCatalogIndex.getOriginTime(row);
+                if (std::isnan(time))
+                {
+                    time = std::numeric_limits<double>::lowest();
+                }
+            }
+            else
+            {
+                time = std::chrono::duration<double>
+                       (mEvents[row]->mCreationTime).count();
+            }
+            ages[row] = std::pair {time, static_cast<uint32_t> (row)};
+        }
+        std::sort(ages.begin(), ages.end());
+        auto count = mEvents.size();
+        auto bytes = mMemoryUsage;
+        for (const auto &[time, row] : ages)
+        {
+            bool tooOld = policy.maximumAge &&
+                          nowSeconds - time > static_cast<double>
+                                              (policy.maximumAge->count());
+            bool tooMany = policy.maximumCount && count > *policy.maximumCount;
+            bool tooBig = policy.maximumBytes && bytes > *policy.maximumBytes;
+            if (!tooOld && !tooMany && !tooBig){break;}
+            evicted.push_back(mIdentifiers[row]);
+            count = count - 1;
+            bytes = bytes - mEvents[row]->mMemoryUsage;
+        }
+        for (const auto &identifier : evicted)
+        {
+            erase(identifier, Change::Type::Evict);
+        }
+        mEvictedCount = mEvictedCount + evicted.size();
+        return evicted;
     }
-    [[nodiscard]] bool contains(const std::string &identifier) const noexcept
+    [[nodiscard]] bool contains(const int64_t identifier) const noexcept
     {
-        return mEvents.contains(identifier);
+        return mIndex.contains(identifier);
     }
     [[nodiscard]] size_t size() const noexcept
     {
         return mEvents.size();
     }
+    /// @result The events' identifiers.
+    [[nodiscard]] std::vector<int64_t> getIdentifiers() const
+    {
+        std::vector<int64_t> result(mIdentifiers.size());
+        for (size_t row = 0; row < mIdentifiers.size(); ++row)
+        {
+            result[row] = mIdentifiers[row];
+        }
+        return result;
+    }
     [[nodiscard]] std::string lightWeightDataToString(const int indent =-1) const
     {
         if (mEvents.empty()){return "";}
-        nlohmann::json events;
-        for (const auto &event : mEvents)
+        return lightWeightDataToString(CatalogQuery {}, indent).events;
+    };
+    /// @result The filtered, sorted, and paged catalog.
+    [[nodiscard]] CatalogPage lightWeightDataToString(const CatalogQuery &query,
+                                                      const int indent =-1) const
+    {
+        CatalogPage page;
+        auto queryResult = mCatalogIndex.query(query);
+        page.totalCount = queryResult.totalCount;
+        if (queryResult.nextCursor)
         {
-            events.push_back(event.second.mLightWeightData);
+            page.nextCursor = toCursorToken(query, *queryResult.nextCursor);
         }
-        return std::move(events.dump(indent));
-    };
-    [[nodiscard]]
-    std::string heavyWeightDataToString(const std::string eventIdentifier,
-                                        const int indent =-1) const
+        if (!query.fields.empty())
+        {
+            // Project the requested fields from the typed summary and
+            // details
+            page.events.push_back('[');
+            for (size_t i = 0; i < queryResult.rows.size(); ++i)
+            {
+                if (i > 0){page.events.push_back(',');}
+                appendProjection(page.events,
+                                 *mEvents[queryResult.rows[i]],
+                                 query.fields);
+            }
+            page.events.push_back(']');
+        }
+        else
+        {
+            // Splice the pre-serialized summaries together
+            size_t length{2};
+            for (const auto &row : queryResult.rows)
+            {
+                length = length + mEvents[row]->mLightWeightFragment.size() + 1;
+            }
+            page.events.reserve(length);
+            page.events.push_back('[');
+            for (size_t i = 0; i < queryResult.rows.size(); ++i)
+            {
+                if (i > 0){page.events.push_back(',');}
+                page.events
+                   += mEvents[queryResult.rows[i]]->mLightWeightFragment;
+            }
+            page.events.push_back(']');
+        }
+        if (indent >= 0)
+        {
+            page.events = nlohmann::json::parse(page.events).dump(indent);
+        }
+        return page;
+    }
+    /// @result Handles to the events satisfying the query in sorted order.
+    [[nodiscard]] std::vector<std::shared_ptr<const Event>>
+        select(const CatalogQuery &query) const
     {
-        if (mEvents.empty()){return "";}
-        auto idx = mEvents.find(eventIdentifier);
-        if (idx != mEvents.end())
+        std::vector<std::shared_ptr<const Event>> result;
+        auto queryResult = mCatalogIndex.query(query);
+        result.reserve(queryResult.rows.size());
+        for (const auto &row : queryResult.rows)
         {
-            return idx->second.mFullData.dump(indent);
+            result.push_back(mEvents[row]);
         }
-        return "";
+        return result;
     }
-    [[nodiscard]] size_t getHash() const noexcept
+    [[nodiscard]]
+    std::string detailDataToString(const int64_t eventIdentifier,
+                                   const int indent =-1) const
+    {
+        auto row = mIndex.find(eventIdentifier);
+        if (!row){return "";}
+        auto details = toJSONString(*mEvents[*row]->mDetails, eventIdentifier,
+                                    mStationNames.get());
+        if (indent < 0){return details;}
+        return nlohmann::json::parse(details).dump(indent);
+    }
+    /// @result The catalog digest.  This is the sum of the events' digests
+    ///         so it does not depend on the storage order and is updated in
+    ///         constant time on insert, update, and erase.  An empty catalog
+    ///         has a digest of 0.
+    [[nodiscard]] uint64_t getHash() const noexcept
     {
         return mHash;
     }
-    [[nodiscard]] Event at(const std::string &eventIdentifier) const
+    /// @result The estimated memory usage in bytes of the events.
+    [[nodiscard]] size_t getMemoryUsage() const noexcept
+    {
+        return mMemoryUsage;
+    }
+    /// @result The memory accounting of the events.
+    [[nodiscard]] CatalogStatistics getStatistics() const noexcept
+    {
+        CatalogStatistics statistics;
+        statistics.eventCount = mEvents.size();
+        statistics.memoryUsage = mMemoryUsage;
+        for (size_t row = 0; row < mEvents.size(); ++row)
+        {
+            statistics.largestEventMemoryUsage
+                = std::max(statistics.largestEventMemoryUsage,
+                           mEvents[row]->mMemoryUsage);
+        }
+        statistics.evictedCount = mEvictedCount;
+        statistics.version = mVersion;
+        return statistics;
+    }
+    /// @result The catalog version.  This increases every time an event is
+    ///         inserted, changed, or removed.
+    [[nodiscard]] uint64_t getVersion() const noexcept
+    {
+        return mVersion;
+    }
+    /// @result Identifies this catalog's history.  Copies of the catalog
+    ///         share the epoch.
+    [[nodiscard]] uint64_t getEpoch() const noexcept
+    {
+        return mEpoch;
+    }
+    /// @brief Adopts another catalog's epoch and version after applying its
+    ///        changes so that clients see the same history regardless of
+    ///        which copy of the catalog serves them.
+    /// @param[in] epoch    The other catalog's epoch.
+    /// @param[in] version  The other catalog's version.
+    /// @param[in] since    This catalog's version before the changes were
+    ///                     applied.
+    void adopt(const uint64_t epoch, const uint64_t version,
+               const uint64_t since) noexcept
+    {
+        if (epoch != mEpoch || version < mVersion || since > mVersion)
+        {
+            mEpoch = epoch;
+            mVersion = version;
+            mJournal.reset(mVersion);
+            return;
+        }
+        mJournal.relabel(since, version);
+        mVersion = version;
+    }
+    /// @result The changes since the given version.  If the epoch differs
+    ///         or the journal has wrapped then this is the full catalog.
+    [[nodiscard]] CatalogDelta delta(const uint64_t epoch,
+                                     const uint64_t version) const
+    {
+        CatalogDelta result;
+        result.epoch = mEpoch;
+        result.version = mVersion;
+        std::optional<std::vector<Change>> changes;
+        if (epoch == mEpoch && version <= mVersion)
+        {
+            changes = mJournal.since(version);
+        }
+        if (!changes)
+        {
+            result.isSnapshot = true;
+            result.events = lightWeightDataToString(CatalogQuery {}).events;
+            return result;
+        }
+        // Only the latest state of each changed event is sent
+        std::vector<int64_t> identifiers;
+        identifiers.reserve(changes->size());
+        for (const auto &change : *changes)
+        {
+            identifiers.push_back(change.identifier);
+        }
+        std::sort(identifiers.begin(), identifiers.end());
+        identifiers.erase(std::unique(identifiers.begin(), identifiers.end()),
+                          identifiers.end());
+        result.events = "[";
+        bool first{true};
+        for (const auto &identifier : identifiers)
+        {
+            auto row = mIndex.find(identifier);
+            if (!row)
+            {
+                result.removed.push_back(identifier);
+                continue;
+            }
+            if (!first){result.events.push_back(',');}
+            first = false;
+            result.events += mEvents[*row]->mLightWeightFragment;
+        }
+        result.events.push_back(']');
+        return result;
+    }
+    [[nodiscard]] NetMagInputs
+        getNetMagInputs(const int64_t eventIdentifier) const
     {
-        return mEvents.at(eventIdentifier);
+        return at(eventIdentifier)->mSummary.netMagInputs;
+    }
+    /// @result A handle to the event or NULL if the event does not exist.
+    [[nodiscard]] std::shared_ptr<const Event>
+        find(const int64_t eventIdentifier) const noexcept
+    {
+        auto row = mIndex.find(eventIdentifier);
+        if (!row){return nullptr;}
+        return mEvents[*row];
+    }
+    /// @result A handle to the event.  The handle keeps the event alive
+    ///         after it is replaced or removed from the catalog.
+    /// @throws std::out_of_range if the event does not exist.
+    [[nodiscard]] std::shared_ptr<const Event>
+        at(const int64_t eventIdentifier) const
+    {
+        auto row = mIndex.find(eventIdentifier);
+        if (!row)
+        {
+            throw std::out_of_range(std::to_string(eventIdentifier)
+                                  + " does not exist");
+        }
+        return mEvents[*row];
     }
 private:
-    std::map<std::string, Event> mEvents;
-    size_t mHash{0};
+    /// Appends the JSON object of the event's requested fields and its
+    /// identifier.  The keys are written in sorted order like
+    /// nlohmann::json would write them and unknown fields are skipped.
+    void appendProjection(std::string &json,
+                          const Event &event,
+                          const std::set<std::string> &fields) const
+    {
+        std::set<std::string_view> keys{fields.begin(), fields.end()};
+        keys.insert("eventIdentifier");
+        json.push_back('{');
+        bool first{true};
+        for (const auto &key : keys)
+        {
+            auto summaryField = findSummaryField(key);
+            if (!summaryField && key != "spectralFit" &&
+                key != "stationMeasurements")
+            {
+                continue;
+            }
+            if (!first){json.push_back(',');}
+            first = false;
+            appendJSONString(json, std::string {key});
+            json.push_back(':');
+            if (summaryField)
+            {
+                summaryField->append(json, event.mSummary);
+            }
+            else if (key == "spectralFit")
+            {
+                appendJSONSpectralFit(json, *event.mDetails);
+            }
+            else
+            {
+                appendJSONStationMeasurements(json, *event.mDetails,
+                                              mStationNames.get());
+            }
+        }
+        json.push_back('}');
+    }
+    [[nodiscard]] static uint64_t createEpoch() noexcept
+    {
+        // Microseconds keep the epoch exactly representable in JavaScript
+        static std::atomic<uint64_t> counter{0};
+        auto now = std::chrono::duration_cast<std::chrono::microseconds>
+                   (std::chrono::system_clock::now().time_since_epoch());
+        return static_cast<uint64_t> (now.count()) + counter.fetch_add(1);
+    }
+    bool erase(const int64_t identifier, const Change::Type type)
+    {
+        auto row = mIndex.find(identifier);
+        if (!row){return false;}
+        auto last = static_cast<uint32_t> (mEvents.size() - 1);
+        mHash = mHash - mEvents[*row]->mDigest;
+        mMemoryUsage = mMemoryUsage - mEvents[*row]->mMemoryUsage;
+        mVersion = mVersion + 1;
+        mJournal.append(Change {mVersion, identifier, type});
+        mIndex.erase(identifier);
+        mCatalogIndex.erase(*row);
+        if (*row != last)
+        {
+            mEvents.set(*row, mEvents[last]);
+            mIdentifiers.set(*row, mIdentifiers[last]);
+            mIndex.insertOrAssign(mIdentifiers[*row], *row);
+        }
+        mEvents.pop_back();
+        mIdentifiers.pop_back();
+        return true;
+    }
+    /// Digests the event's summary and details.  The result is finalized
+    /// with the splitmix64 mixer so that summing the digests of many events
+    /// does not cancel structure in the underlying string hash.
+    [[nodiscard]] static uint64_t computeDigest(const int64_t identifier,
+                                                const Event &event)
+    {
+        auto hashBytes = [](uint64_t digest, const auto &values)
+        {
+            std::string_view bytes{reinterpret_cast<const char *> (values.data()),
+                                   values.size()*sizeof(values[0])};
+            return digest*31 + std::hash<std::string_view> {}(bytes);
+        };
+        uint64_t digest
+            = std::hash<std::string> {}(event.mLightWeightFragment);
+        const auto &spectralFit = event.mDetails->spectralFit;
+        for (const auto &spectrum : {&spectralFit.fit,
+                                     &spectralFit.bruneLowerBound1,
+                                     &spectralFit.bruneUpperBound1,
+                                     &spectralFit.bruneLowerBound2,
+                                     &spectralFit.bruneUpperBound2})
+        {
+            digest = digest*31 + (*spectrum ? 1 : 0);
+            if (*spectrum)
+            {
+                digest = hashBytes(digest, (*spectrum)->frequencies);
+                digest = hashBytes(digest, (*spectrum)->values);
+            }
+        }
+        for (const auto &station : event.mDetails->stationMeasurements)
+        {
+            digest = digest*31 + static_cast<uint64_t> (station.station);
+            digest = hashBytes(digest, station.centerFrequencies);
+            digest = hashBytes(digest, station.values);
+            digest = hashBytes(digest, station.residuals);
+        }
+        digest = digest ^ static_cast<uint64_t> (identifier);
+        digest = (digest ^ (digest >> 30))*0xbf58476d1ce4e5b9ull;
+        digest = (digest ^ (digest >> 27))*0x94d049bb133111ebull;
+        return digest ^ (digest >> 31);
+    }
+    [[nodiscard]] static size_t computeMemoryUsage(const Event &event)
+    {
+        const auto &summary = event.mSummary;
+        return sizeof(Event)
+             + estimateMemoryUsage(summary.originTime)
+             + estimateMemoryUsage(summary.cctMagnitudeType)
+             + estimateMemoryUsage(summary.authoritativeMagnitudeType)
+             + estimateMemoryUsage(summary.reviewStatus)
+             + estimateMemoryUsage(summary.creationMode)
+             + estimateMemoryUsage(*event.mDetails)
+             + estimateMemoryUsage(event.mLightWeightFragment);
+    }
+    std::shared_ptr<const StationNameTable> mStationNames{nullptr};
+    ChunkedArray<std::shared_ptr<const Event>> mEvents;
+    ChunkedArray<int64_t> mIdentifiers;
+    EventIndex mIndex;
+    CatalogIndex mCatalogIndex;
+    size_t mMemoryUsage{0};
+    uint64_t mEvictedCount{0};
+    uint64_t mHash{0};
+    uint64_t mVersion{0};
+    ChangeJournal mJournal;
+    uint64_t mEpoch{createEpoch()};
 };
 }
 #endif
@@ -0,0 +1,205 @@
+#include <vector>
+#include <cmath>
+#include <numbers>
+#include <algorithm>
+#include <stdexcept>
+#include <GeographicLib/Geodesic.hpp>
+#include <GeographicLib/Constants.hpp>
+#include "geometry.hpp"
+
+using namespace CCTService;
+
+namespace
+{
+
+constexpr double toRadians{std::numbers::pi/180};
+constexpr double toDegrees{180/std::numbers::pi};
+constexpr double earthRadius{6371000};
+
+/// Maps an angle in degrees to [0,360).
+[[nodiscard]] double wrap360(const double angle) noexcept
+{
+    auto result = std::fmod(angle, 360.0);
+    if (result < 0){result = result + 360;}
+    if (result >= 360){result = result - 360;}
+    return result;
+}
+
+void checkLatitudes(const double sourceLatitude,
+                    const std::vector<double> &stationLatitudes,
+                    const std::vector<double> &stationLongitudes)
+{
+    if (stationLatitudes.size() != stationLongitudes.size())
+    {
+        throw std::invalid_argument(
+            "Station latitudes and longitudes differ in size");
+    }
+    if (sourceLatitude < -90 || sourceLatitude > 90)
+    {
+        throw std::invalid_argument("Source latitude must be in [-90,90]");
+    }
+    for (const auto &latitude : stationLatitudes)
+    {
+        if (latitude < -90 || latitude > 90)
+        {
+            throw std::invalid_argument(
+                "Station latitude must be in [-90,90]");
+        }
+    }
+}
+
+/// Karney's solution which is what we had been doing for each station.
+void geodesic(const double sourceLatitude,
+              const double sourceLongitude,
+              const std::vector<double> &stationLatitudes,
+              const std::vector<double> &stationLongitudes,
+              SourceStationGeometry &result)
+{
+    const auto &geodesic = GeographicLib::Geodesic::WGS84();
+    auto nStations = stationLatitudes.size();
+    for (size_t i = 0; i < nStations; ++i)
+    {
+        double distance, azimuth, azimuthAtStation;
+        geodesic.Inverse(sourceLatitude, sourceLongitude,
+                         stationLatitudes[i], stationLongitudes[i],
+                         distance, azimuth, azimuthAtStation);
+        result.distances[i] = distance;
+        // Translate azimuth from [-180,180] to [0,360].
+        result.azimuths[i] = wrap360(azimuth);
+        // The azimuth at the station points away from the source so
+        // add 180 to make it a back-azimuth.
+        result.backAzimuths[i] = wrap360(azimuthAtStation + 180);
+    }
+}
+
+/// Great circle solutions.  The flattening, f, is 0 for a sphere.  Otherwise,
+/// the great circle is computed on the reduced latitudes and the distance
+/// is corrected to first order in f (Andoyer-Lambert).  The stations are
+/// processed in a batch so the source's terms are computed once.
+void greatCircle(const double sourceLatitude,
+                 const double sourceLongitude,
+                 const std::vector<double> &stationLatitudes,
+                 const std::vector<double> &stationLongitudes,
+                 const double radius,
+                 const double f,
+                 SourceStationGeometry &result)
+{
+    auto nStations = stationLatitudes.size();
+    auto toReducedLatitude = [f](const double latitude)
+    {
+        if (f == 0){return latitude*toRadians;}
+        return std::atan((1 - f)*std::tan(latitude*toRadians));
+    };
+    const double beta1 = toReducedLatitude(sourceLatitude);
+    const double sinBeta1 = std::sin(beta1);
+    const double cosBeta1 = std::cos(beta1);
+    const double lambda1 = sourceLongitude*toRadians;
+    const double *__restrict__ latitudes = stationLatitudes.data();
+    const double *__restrict__ longitudes = stationLongitudes.data();
+    double *__restrict__ distances = result.distances.data();
+    double *__restrict__ azimuths = result.azimuths.data();
+    double *__restrict__ backAzimuths = result.backAzimuths.data();
+    for (size_t i = 0; i < nStations; ++i)
+    {
+        double beta2 = (f == 0) ?
+                       latitudes[i]*toRadians :
+                       std::atan((1 - f)*std::tan(latitudes[i]*toRadians));
+        double sinBeta2 = std::sin(beta2);
+        double cosBeta2 = std::cos(beta2);
+        double dLambda = longitudes[i]*toRadians - lambda1;
+        double sinDLambda = std::sin(dLambda);
+        double cosDLambda = std::cos(dLambda);
+        // Central angle from the numerically stable Vincenty form
+        double y1 = cosBeta2*sinDLambda;
+        double y2 = cosBeta1*sinBeta2 - sinBeta1*cosBeta2*cosDLambda;
+        double x = sinBeta1*sinBeta2 + cosBeta1*cosBeta2*cosDLambda;
+        double sigma = std::atan2(std::hypot(y1, y2), x);
+        // Azimuth from the source and from the station back to the source
+        azimuths[i] = std::atan2(y1, y2)*toDegrees;
+        backAzimuths[i]
+            = std::atan2(-cosBeta1*sinDLambda,
+                         cosBeta2*sinBeta1 - sinBeta2*cosBeta1*cosDLambda)
+             *toDegrees;
+        // Andoyer-Lambert correction
+        double correction{0};
+        if (f > 0 && sigma > 0 && sigma < std::numbers::pi)
+        {
+            double p = 0.5*(beta1 + beta2);
+            double q = 0.5*(beta2 - beta1);
+            double sinP = std::sin(p);
+            double cosP = std::cos(p);
+            double sinQ = std::sin(q);
+            double cosQ = std::cos(q);
+            double sinSigma = std::sin(sigma);
+            double cosHalfSigma = std::cos(0.5*sigma);
+            double sinHalfSigma = std::sin(0.5*sigma);
+            double xAL = (sigma - sinSigma)*(sinP*sinP)*(cosQ*cosQ)
+                        /(cosHalfSigma*cosHalfSigma);
+            double yAL = (sigma + sinSigma)*(cosP*cosP)*(sinQ*sinQ)
+                        /(sinHalfSigma*sinHalfSigma);
+            correction = 0.5*f*(xAL + yAL);
+        }
+        distances[i] = radius*(sigma - correction);
+    }
+    for (size_t i = 0; i < nStations; ++i)
+    {
+        azimuths[i] = wrap360(azimuths[i]);
+        backAzimuths[i] = wrap360(backAzimuths[i]);
+    }
+}
+
+}
+
+/// Computes the source-station geometry
+SourceStationGeometry CCTService::computeSourceStationGeometry(
+    const double sourceLatitude,
+    const double sourceLongitude,
+    const std::vector<double> &stationLatitudes,
+    const std::vector<double> &stationLongitudes,
+    const GeometryAccuracy accuracy)
+{
+    ::checkLatitudes(sourceLatitude, stationLatitudes, stationLongitudes);
+    SourceStationGeometry result;
+    auto nStations = stationLatitudes.size();
+    result.distances.resize(nStations);
+    result.azimuths.resize(nStations);
+    result.backAzimuths.resize(nStations);
+    if (nStations == 0){return result;}
+    if (accuracy == GeometryAccuracy::Geodesic)
+    {
+        ::geodesic(sourceLatitude, sourceLongitude,
+                   stationLatitudes, stationLongitudes,
+                   result);
+    }
+    else if (accuracy == GeometryAccuracy::AndoyerLambert)
+    {
+        ::greatCircle(sourceLatitude, sourceLongitude,
+                      stationLatitudes, stationLongitudes,
+                      GeographicLib::Constants::WGS84_a(),
+                      GeographicLib::Constants::WGS84_f(),
+                      result);
+    }
+    else
+    {
+        ::greatCircle(sourceLatitude, sourceLongitude,
+                      stationLatitudes, stationLongitudes,
+                      ::earthRadius, 0,
+                      result);
+    }
+    return result;
+}
+
+/// Azimuthal gap
+double CCTService::computeAzimuthalGap(std::vector<double> azimuths)
+{
+    if (azimuths.empty()){return -1;}
+    if (azimuths.size() == 1){return 360;}
+    double gap{0};
+    std::sort(azimuths.begin(), azimuths.end());
+    azimuths.push_back(azimuths[0] + 360);
+    for (size_t i = 0; i < azimuths.size() - 1; ++i)
+    {
+        gap = std::max(gap, azimuths[i + 1] - azimuths[i]);
+    }
+    return gap;
+}
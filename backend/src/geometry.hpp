@@ -0,0 +1,53 @@
+#ifndef CCT_BACKEND_SERVICE_GEOMETRY_HPP
+#define CCT_BACKEND_SERVICE_GEOMETRY_HPP
+#include <vector>
+namespace CCTService
+{
+/// @brief Defines how accurately source-station distances and azimuths
+///        are computed.
+enum class GeometryAccuracy
+{
+    Geodesic,       /*!< Karney's geodesic on the WGS84 ellipsoid.  This is
+                         accurate to nanometers but is the most expensive. */
+    AndoyerLambert, /*!< Spherical solution on the reduced latitudes with
+                         Andoyer-Lambert's first-order flattening correction
+                         to the distance.  This is accurate to meters which is
+                         sufficient for closest distances and gaps. */
+    Spherical       /*!< Great circle on a sphere of radius 6371 km.  This is
+                         the cheapest but distances can be off by ~0.5%. */
+};
+
+/// @brief The distances and azimuths from a source to a batch of stations
+///        stored as a structure of arrays.  The i'th entry of each array
+///        corresponds to the i'th station.
+struct SourceStationGeometry
+{
+    /// Source-station distance in meters.
+    std::vector<double> distances;
+    /// Azimuth from the source to the station in degrees measured
+    /// positive east of north in [0,360).
+    std::vector<double> azimuths;
+    /// Azimuth from the station to the source in degrees measured
+    /// positive east of north in [0,360).
+    std::vector<double> backAzimuths;
+};
+
+/// @brief Computes the distances and azimuths from the source to each station.
+/// @param[in] sourceLatitude     The source latitude in degrees.
+/// @param[in] sourceLongitude    The source longitude in degrees.
+/// @param[in] stationLatitudes   The station latitudes in degrees.
+/// @param[in] stationLongitudes  The station longitudes in degrees.
+/// @param[in] accuracy           Defines the accuracy of the calculation.
+/// @throws std::invalid_argument if the latitudes are not in [-90,90] or
+///         the station latitude and longitude sizes differ.
+[[nodiscard]] SourceStationGeometry
+    computeSourceStationGeometry(double sourceLatitude,
+                                 double sourceLongitude,
+                                 const std::vector<double> &stationLatitudes,
+                                 const std::vector<double> &stationLongitudes,
+                                 GeometryAccuracy accuracy = GeometryAccuracy::Geodesic);
+/// @result The largest azimuthal gap in degrees.  This is 360 for one
+///         azimuth and -1 if there are no azimuths.
+[[nodiscard]] double computeAzimuthalGap(std::vector<double> azimuths);
+}
+#endif
@@ -0,0 +1,169 @@
+#ifndef CCT_BACKEND_SERVICE_LRU_CACHE_HPP
+#define CCT_BACKEND_SERVICE_LRU_CACHE_HPP
+#include <list>
+#include <mutex>
+#include <optional>
+#include <functional>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <cstdint>
+namespace CCTService
+{
+/// @brief The hit, miss, and eviction counts and occupancy of a cache.
+struct CacheStatistics
+{
+    /// The number of entries in the cache.
+    size_t entries{0};
+    /// The number of bytes held by the cache.
+    size_t bytes{0};
+    /// The byte budget of the cache.
+    size_t capacity{0};
+    uint64_t hits{0};
+    uint64_t misses{0};
+    uint64_t evictions{0};
+};
+
+/// @class LRUCache "lruCache.hpp" "lruCache.hpp"
+/// @brief A least-recently-used cache whose capacity is a byte budget rather
+///        than an entry count.  The size of each value is measured once when
+///        it is inserted.  This class is thread-safe.
+/// @copyright Ben Baker (University of Utah) distributed under the MIT license.
+template<typename Key, typename Value>
+class LRUCache
+{
+public:
+    /// @brief Constructor.
+    /// @param[in] capacity  The byte budget of the cache.
+    /// @param[in] sizeOf    Measures the bytes used by a value.
+    LRUCache(const size_t capacity,
+             std::function<size_t (const Value &)> sizeOf) :
+        mSizeOf(std::move(sizeOf)),
+        mCapacity(capacity)
+    {
+    }
+    /// @result The value if it is in the cache.  The value becomes the most
+    ///         recently used.
+    [[nodiscard]] std::optional<Value> get(const Key &key)
+    {
+        std::scoped_lock lock(mMutex);
+        auto idx = mMap.find(key);
+        if (idx == mMap.end())
+        {
+            mMisses = mMisses + 1;
+            return std::nullopt;
+        }
+        mHits = mHits + 1;
+        mList.splice(mList.begin(), mList, idx->second);
+        return idx->second->value;
+    }
+    /// @result True indicates the key is in the cache.  This does not
+    ///         change the recency of the entry.
+    [[nodiscard]] bool contains(const Key &key) const
+    {
+        std::scoped_lock lock(mMutex);
+        return mMap.contains(key);
+    }
+    /// @brief Adds or replaces the value and makes it the most recently
+    ///        used.  Least recently used values are evicted until the cache
+    ///        is within its budget.  A value larger than the budget is
+    ///        not cached.
+    /// @result The evicted entries from least to most recently used.
+    std::vector<std::pair<Key, Value>> insert(const Key &key, Value value)
+    {
+        auto bytes = mSizeOf(value);
+        std::scoped_lock lock(mMutex);
+        eraseLocked(key);
+        if (bytes > mCapacity){return {};}
+        mList.push_front(Entry {key, std::move(value), bytes});
+        mMap.insert(std::pair {key, mList.begin()});
+        mBytes = mBytes + bytes;
+        return evictLocked();
+    }
+    /// @brief Removes the key from the cache.
+    void erase(const Key &key)
+    {
+        std::scoped_lock lock(mMutex);
+        eraseLocked(key);
+    }
+    /// @brief Removes the key from the cache.
+    /// @result The value if it was in the cache.
+    [[nodiscard]] std::optional<Value> extract(const Key &key)
+    {
+        std::scoped_lock lock(mMutex);
+        auto idx = mMap.find(key);
+        if (idx == mMap.end()){return std::nullopt;}
+        auto value = std::move(idx->second->value);
+        eraseLocked(key);
+        return value;
+    }
+    /// @brief Changes the byte budget and evicts as necessary.
+    /// @result The evicted entries from least to most recently used.
+    std::vector<std::pair<Key, Value>> setCapacity(const size_t capacity)
+    {
+        std::scoped_lock lock(mMutex);
+        mCapacity = capacity;
+        return evictLocked();
+    }
+    /// @brief Removes all values.
+    void clear()
+    {
+        std::scoped_lock lock(mMutex);
+        mList.clear();
+        mMap.clear();
+        mBytes = 0;
+    }
+    /// @result The cache statistics.
+    [[nodiscard]] CacheStatistics getStatistics() const
+    {
+        std::scoped_lock lock(mMutex);
+        CacheStatistics statistics;
+        statistics.entries = mMap.size();
+        statistics.bytes = mBytes;
+        statistics.capacity = mCapacity;
+        statistics.hits = mHits;
+        statistics.misses = mMisses;
+        statistics.evictions = mEvictions;
+        return statistics;
+    }
+private:
+    struct Entry
+    {
+        Key key;
+        Value value;
+        size_t bytes{0};
+    };
+    void eraseLocked(const Key &key)
+    {
+        auto idx = mMap.find(key);
+        if (idx == mMap.end()){return;}
+        mBytes = mBytes - idx->second->bytes;
+        mList.erase(idx->second);
+        mMap.erase(idx);
+    }
+    std::vector<std::pair<Key, Value>> evictLocked()
+    {
+        std::vector<std::pair<Key, Value>> evicted;
+        while (mBytes > mCapacity && !mList.empty())
+        {
+            auto &last = mList.back();
+            mBytes = mBytes - last.bytes;
+            mMap.erase(last.key);
+            evicted.push_back(std::pair {last.key, std::move(last.value)});
+            mList.pop_back();
+            mEvictions = mEvictions + 1;
+        }
+        return evicted;
+    }
+    mutable std::mutex mMutex;
+    std::function<size_t (const Value &)> mSizeOf;
+    std::list<Entry> mList;
+    std::unordered_map<Key, typename std::list<Entry>::iterator> mMap;
+    size_t mCapacity{0};
+    size_t mBytes{0};
+    uint64_t mHits{0};
+    uint64_t mMisses{0};
+    uint64_t mEvictions{0};
+};
+}
+#endif
@@ -2,6 +2,8 @@
 #include <set>
 #include <map>
 #include <cstdint>
+#include <vector>
+#include <chrono>
 #include <spdlog/spdlog.h>
 #include <boost/asio.hpp>
 #include <boost/program_options.hpp>
@@ -19,6 +21,26 @@ struct ProgramOptions
 {
     boost::asio::ip::address address{boost::asio::ip::make_address("0.0.0.0")};
     std::filesystem::path documentRoot{"./"}; 
+    CCTService::RetentionPolicy retentionPolicy;
+    size_t eventDataCacheCapacity{256*1024*1024};
+    size_t compressedEventDataCacheCapacity{256*1024*1024};
+    size_t envelopeDataCacheCapacity{64*1024*1024};
+    size_t nPrefetchedEvents{10};
+    size_t ingestBatchSize{100};
+    bool projectedIngest{false};
+    size_t nIngestThreads{0};
+    size_t journalCapacity{4096};
+    std::filesystem::path snapshotDirectory;
+    std::chrono::seconds snapshotInterval{5*60};
+    std::string sharedCatalogName{"cctCatalog"};
+    CCTService::SharedCatalogMode sharedCatalogMode{CCTService::SharedCatalogMode::Disabled};
+    size_t sharedCatalogCapacity{256*1024*1024};
+    size_t nPooledConnections{4};
+    std::chrono::milliseconds connectionCheckoutTimeout{5000};
+    std::chrono::seconds connectionHealthCheckInterval{60};
+    std::chrono::seconds queryInterval{60};
+    std::chrono::seconds minimumQueryInterval{1};
+    bool listenForChanges{false};
     int nThreads{1};
     unsigned short port{80};
     bool helpOnly{false};
@@ -43,7 +65,51 @@ Allowed options)""");
         ("document_root", boost::program_options::value<std::string> ()->default_value("./"),
                     "The document root in case files are served")
         ("n_threads", boost::program_options::value<int> ()->default_value(1),
-                     "The number of threads");
+                     "The number of threads")
+        ("retention_max_age_days", boost::program_options::value<int> ()->default_value(0),
+                     "Events with origin times older than this many days are evicted from memory.  If 0 then events are not evicted by age.")
+        ("retention_max_events", boost::program_options::value<int> ()->default_value(5000),
+                     "The maximum number of events per schema kept in memory.  If 0 then the number of events is not limited.")
+        ("retention_max_megabytes", boost::program_options::value<int> ()->default_value(1024),
+                     "The maximum estimated memory in MB of the events per schema kept in memory.  If 0 then the memory is not limited.")
+        ("event_data_cache_megabytes", boost::program_options::value<int> ()->default_value(256),
+                     "The memory in MB per schema of the cache of recently viewed mw_data documents.")
+        ("envelope_data_cache_megabytes", boost::program_options::value<int> ()->default_value(64),
+                     "The memory in MB per schema of the cache of envelope data.")
+        ("compressed_event_data_cache_megabytes", boost::program_options::value<int> ()->default_value(256),
+                     "The memory in MB per schema of the compressed mw_data documents evicted from the event data cache.  If 0 then evicted documents are discarded.")
+        ("prefetch_events", boost::program_options::value<int> ()->default_value(10),
+                     "The number of the newest unreviewed events per schema whose mw_data documents are prefetched.")
+        ("ingest_batch_size", boost::program_options::value<int> ()->default_value(100),
+                     "The number of events fetched per round trip when the catalogs are loaded and updated.")
+        ("projected_ingest", boost::program_options::value<bool> ()->default_value(false),
+                     "If true then only the parts of the mw_data documents needed for the event table and details are transferred when the catalogs are loaded and updated.  The full documents are fetched when they are viewed.")
+        ("ingest_threads", boost::program_options::value<int> ()->default_value(0),
+                     "The number of threads that parse and unpack the fetched events.  If 0 then all of the hardware threads are used.")
+        ("journal_capacity", boost::program_options::value<int> ()->default_value(4096),
+                     "The number of catalog changes per schema kept for delta synchronization.  Clients further behind receive the full catalog.")
+        ("snapshot_directory", boost::program_options::value<std::string> ()->default_value(""),
+                     "The directory to which the catalogs are periodically written so that a restart can serve them immediately.  If empty then snapshots are disabled.")
+        ("snapshot_interval", boost::program_options::value<int> ()->default_value(300),
+                     "The interval in seconds at which changed catalogs are written to the snapshot directory.")
+        ("shared_catalog_mode", boost::program_options::value<std::string> ()->default_value("none"),
+                     "none, publish, or subscribe.  A publisher polls the database and shares its catalogs through shared memory.  A subscriber serves the publisher's catalogs and does not poll the database for them.")
+        ("shared_catalog_name", boost::program_options::value<std::string> ()->default_value("cctCatalog"),
+                     "The name prefix of the shared memory regions.")
+        ("shared_catalog_megabytes", boost::program_options::value<int> ()->default_value(256),
+                     "The largest catalog in MB per schema a publisher can share.")
+        ("cct_connections", boost::program_options::value<int> ()->default_value(4),
+                     "The number of CCT database connections used to serve requests.  The poller has its own connection.")
+        ("cct_checkout_timeout_ms", boost::program_options::value<int> ()->default_value(5000),
+                     "The longest time in milliseconds a request waits for a CCT database connection.")
+        ("cct_health_check_interval", boost::program_options::value<int> ()->default_value(60),
+                     "CCT database connections idle longer than this many seconds are checked before they are used.")
+        ("listen_for_changes", boost::program_options::value<bool> ()->default_value(false),
+                     "If true then changed events are fetched when the database raises a cct_<schema>_event notification.  This requires the notification trigger in database/notifyEventChange.sql on each schema's event table.")
+        ("query_interval", boost::program_options::value<int> (),
+                     "The longest interval in seconds at which the database is polled for changed events.  The poller backs off to this while a catalog is idle.  This defaults to 60 or, when listening for changes, to 600.")
+        ("minimum_query_interval", boost::program_options::value<int> ()->default_value(1),
+                     "The interval in seconds at which the database is polled for changed events while a catalog's events are changing.");
     boost::program_options::variables_map vm; 
     boost::program_options::store(
         boost::program_options::parse_command_line(argc, argv, desc), vm); 
@@ -82,14 +148,171 @@ Allowed options)""");
         if (nThreads < 1){throw std::invalid_argument("Number of threads must be positive");}
         result.nThreads = nThreads;
     }
+    if (vm.count("retention_max_age_days"))
+    {
+        auto days = vm["retention_max_age_days"].as<int> ();
+        if (days < 0){throw std::invalid_argument("Retention age must be non-negative");}
+        if (days > 0)
+        {
+            result.retentionPolicy.maximumAge
+                = std::chrono::duration_cast<std::chrono::seconds>
+                  (std::chrono::days {days});
+        }
+    }
+    if (vm.count("retention_max_events"))
+    {
+        auto nEvents = vm["retention_max_events"].as<int> ();
+        if (nEvents < 0){throw std::invalid_argument("Retention events must be non-negative");}
+        if (nEvents > 0)
+        {
+            result.retentionPolicy.maximumCount
+                = static_cast<size_t> (nEvents);
+        }
+    }
+    if (vm.count("retention_max_megabytes"))
+    {
+        auto megabytes = vm["retention_max_megabytes"].as<int> ();
+        if (megabytes < 0){throw std::invalid_argument("Retention megabytes must be non-negative");}
+        if (megabytes > 0)
+        {
+            result.retentionPolicy.maximumBytes
+                = static_cast<size_t> (megabytes)*1024*1024;
+        }
+    }
+    if (vm.count("event_data_cache_megabytes"))
+    {
+        auto megabytes = vm["event_data_cache_megabytes"].as<int> ();
+        if (megabytes < 0){throw std::invalid_argument("Event data cache megabytes must be non-negative");}
+        result.eventDataCacheCapacity
+            = static_cast<size_t> (megabytes)*1024*1024;
+    }
+    if (vm.count("envelope_data_cache_megabytes"))
+    {
+        auto megabytes = vm["envelope_data_cache_megabytes"].as<int> ();
+        if (megabytes < 0){throw std::invalid_argument("Envelope data cache megabytes must be non-negative");}
+        result.envelopeDataCacheCapacity
+            = static_cast<size_t> (megabytes)*1024*1024;
+    }
+    if (vm.count("compressed_event_data_cache_megabytes"))
+    {
+        auto megabytes = vm["compressed_event_data_cache_megabytes"].as<int> ();
+        if (megabytes < 0){throw std::invalid_argument("Compressed event data cache megabytes must be non-negative");}
+        result.compressedEventDataCacheCapacity
+            = static_cast<size_t> (megabytes)*1024*1024;
+    }
+    if (vm.count("prefetch_events"))
+    {
+        auto nEvents = vm["prefetch_events"].as<int> ();
+        if (nEvents < 0){throw std::invalid_argument("Number of prefetched events must be non-negative");}
+        result.nPrefetchedEvents = static_cast<size_t> (nEvents);
+    }
+    if (vm.count("ingest_batch_size"))
+    {
+        auto batchSize = vm["ingest_batch_size"].as<int> ();
+        if (batchSize <= 0){throw std::invalid_argument("Ingest batch size must be positive");}
+        result.ingestBatchSize = static_cast<size_t> (batchSize);
+    }
+    if (vm.count("projected_ingest"))
+    {
+        result.projectedIngest = vm["projected_ingest"].as<bool> ();
+    }
+    if (vm.count("ingest_threads"))
+    {
+        auto nThreads = vm["ingest_threads"].as<int> ();
+        if (nThreads < 0){throw std::invalid_argument("Number of ingest threads must be non-negative");}
+        result.nIngestThreads = static_cast<size_t> (nThreads);
+    }
+    if (vm.count("journal_capacity"))
+    {
+        auto nChanges = vm["journal_capacity"].as<int> ();
+        if (nChanges <= 0){throw std::invalid_argument("Journal capacity must be positive");}
+        result.journalCapacity = static_cast<size_t> (nChanges);
+    }
+    if (vm.count("snapshot_directory"))
+    {
+        result.snapshotDirectory = vm["snapshot_directory"].as<std::string> ();
+    }
+    if (vm.count("snapshot_interval"))
+    {
+        auto interval = vm["snapshot_interval"].as<int> ();
+        if (interval <= 0){throw std::invalid_argument("Snapshot interval must be positive");}
+        result.snapshotInterval = std::chrono::seconds {interval};
+    }
+    if (vm.count("shared_catalog_mode"))
+    {
+        auto mode = vm["shared_catalog_mode"].as<std::string> ();
+        if (mode == "none")
+        {
+            result.sharedCatalogMode = CCTService::SharedCatalogMode::Disabled;
+        }
+        else if (mode == "publish")
+        {
+            result.sharedCatalogMode = CCTService::SharedCatalogMode::Publish;
+        }
+        else if (mode == "subscribe")
+        {
+            result.sharedCatalogMode = CCTService::SharedCatalogMode::Subscribe;
+        }
+        else
+        {
+            throw std::invalid_argument("Unhandled shared catalog mode: " + mode);
+        }
+    }
+    if (vm.count("shared_catalog_name"))
+    {
+        result.sharedCatalogName = vm["shared_catalog_name"].as<std::string> ();
+    }
+    if (vm.count("shared_catalog_megabytes"))
+    {
+        auto megabytes = vm["shared_catalog_megabytes"].as<int> ();
+        if (megabytes <= 0){throw std::invalid_argument("Shared catalog megabytes must be positive");}
+        result.sharedCatalogCapacity
+            = static_cast<size_t> (megabytes)*1024*1024;
+    }
+    if (vm.count("cct_connections"))
+    {
+        auto nConnections = vm["cct_connections"].as<int> ();
+        if (nConnections <= 0){throw std::invalid_argument("Number of CCT connections must be positive");}
+        result.nPooledConnections = static_cast<size_t> (nConnections);
+    }
+    if (vm.count("cct_checkout_timeout_ms"))
+    {
+        auto timeout = vm["cct_checkout_timeout_ms"].as<int> ();
+        if (timeout < 0){throw std::invalid_argument("Checkout timeout must be non-negative");}
+        result.connectionCheckoutTimeout = std::chrono::milliseconds {timeout};
+    }
+    if (vm.count("cct_health_check_interval"))
+    {
+        auto interval = vm["cct_health_check_interval"].as<int> ();
+        if (interval < 0){throw std::invalid_argument("Health check interval must be non-negative");}
+        result.connectionHealthCheckInterval = std::chrono::seconds {interval};
+    }
+    if (vm.count("listen_for_changes"))
+    {
+        result.listenForChanges = vm["listen_for_changes"].as<bool> ();
+        // Polling is only a safety net for missed notifications
+        if (result.listenForChanges)
+        {
+            result.queryInterval = std::chrono::seconds {10*60};
+        }
+    }
+    if (vm.count("query_interval"))
+    {
+        auto interval = vm["query_interval"].as<int> ();
+        if (interval <= 0){throw std::invalid_argument("Query interval must be positive");}
+        result.queryInterval = std::chrono::seconds {interval};
+    }
+    if (vm.count("minimum_query_interval"))
+    {
+        auto interval = vm["minimum_query_interval"].as<int> ();
+        if (interval <= 0){throw std::invalid_argument("Minimum query interval must be positive");}
+        result.minimumQueryInterval = std::chrono::seconds {interval};
+    }
     return result;
 }
 
-std::shared_ptr<CCTService::CCTPostgresService> createCCTPostgresService(
-    const std::set<std::string> &schemas)
+std::unique_ptr<CCTService::PostgreSQL> createCCTConnection()
 {
-    if (schemas.empty()){throw std::runtime_error("No schemas!");}
-    // Create pg connection
     auto connection = std::make_unique<CCTService::PostgreSQL> ();
     connection->setUser(std::getenv("CCT_READ_WRITE_USER"));
     connection->setPassword(std::getenv("CCT_READ_WRITE_PASSWORD"));
@@ -101,10 +324,57 @@ std::shared_ptr<CCTService::CCTPostgresService> createCCTPostgresService(
     {   
         throw std::runtime_error("Could not create CCT connection");
     } 
+    return connection;
+}
+
+std::shared_ptr<CCTService::CCTPostgresService> createCCTPostgresService(
+    const std::set<std::string> &schemas,
+    const ::ProgramOptions &options)
+{
+    if (schemas.empty()){throw std::runtime_error("No schemas!");}
+    // Create the poller's pg connection
+    auto connection = ::createCCTConnection();
+    // Create the pg connections for the requests
+    std::vector<std::unique_ptr<CCTService::PostgreSQL>> connections;
+    for (size_t i = 0; i < options.nPooledConnections; ++i)
+    {
+        connections.push_back(::createCCTConnection());
+    }
+    auto connectionPool
+        = std::make_unique<CCTService::ConnectionPool> (std::move(connections));
+    connectionPool->setCheckoutTimeout(options.connectionCheckoutTimeout);
+    connectionPool->setHealthCheckInterval(
+        options.connectionHealthCheckInterval);
     // Create the service
     auto service
         = std::make_shared<CCTService::CCTPostgresService>
-          (std::move(connection), schemas);
+          (std::move(connection), std::move(connectionPool), schemas);
+    for (const auto &schema : schemas)
+    {
+        service->setRetentionPolicy(schema, options.retentionPolicy);
+    }
+    service->setEventDataCacheCapacity(options.eventDataCacheCapacity);
+    service->setEnvelopeDataCacheCapacity(options.envelopeDataCacheCapacity);
+    service->setCompressedEventDataCacheCapacity(
+        options.compressedEventDataCacheCapacity);
+    service->setNumberOfPrefetchedEvents(options.nPrefetchedEvents);
+    service->setJournalCapacity(options.journalCapacity);
+    service->setIngestBatchSize(options.ingestBatchSize);
+    service->setProjectedIngest(options.projectedIngest);
+    service->setNumberOfIngestThreads(options.nIngestThreads);
+    service->setSnapshotDirectory(options.snapshotDirectory);
+    service->setSnapshotInterval(options.snapshotInterval);
+    service->setSharedCatalog(options.sharedCatalogName,
+                              options.sharedCatalogMode,
+                              options.sharedCatalogCapacity);
+    service->setQueryInterval(options.queryInterval);
+    service->setMinimumQueryInterval(options.minimumQueryInterval);
+    // Subscribers receive their catalogs from the publisher
+    if (options.listenForChanges &&
+        options.sharedCatalogMode != CCTService::SharedCatalogMode::Subscribe)
+    {
+        service->setChangeListener(::createCCTConnection());
+    }
     service->start();
     if (!service->isRunning())
     {
@@ -207,7 +477,8 @@ int main(int argc, char* argv[])
     std::shared_ptr<CCTService::CCTPostgresService> cctPostgresService{nullptr};
     try
     {
-        cctPostgresService = ::createCCTPostgresService(schemas);
+        cctPostgresService
+            = ::createCCTPostgresService(schemas, programOptions);
     }
     catch (const std::exception &e)
     {
@@ -12,6 +12,7 @@
 #include <nlohmann/json.hpp>
 #include <spdlog/spdlog.h>
 #include "postgresql.hpp"
+#include "statementRegistry.hpp"
 #include "unpackCCTJSON.hpp"
 #include "events.hpp"
 
@@ -25,6 +26,8 @@ public:
         mSessionPtr = &mSession;
     } 
     soci::session mSession;
+    /// Declared after the session so the statements are released first.
+    StatementRegistry mStatements{mSession};
     void *mSessionPtr{nullptr};
     std::string mConnectionString;
     std::string mUser;
@@ -221,6 +224,8 @@ std::string PostgreSQL::getConnectionString() const
 void PostgreSQL::connect()
 {
     auto connectionString = getConnectionString(); // Throws
+    // The statements belong to the old session
+    pImpl->mStatements.clear();
     if (pImpl->mSession.is_connected()){pImpl->mSession.close();}
     try
     {
@@ -241,6 +246,7 @@ bool PostgreSQL::isConnected() const noexcept
 /// Disconnect
 void PostgreSQL::disconnect()
 {
+    pImpl->mStatements.clear();
     if (pImpl->mSession.is_connected()){pImpl->mSession.close();}
 }
 
@@ -249,6 +255,12 @@ std::uintptr_t PostgreSQL::getSession() const
     return reinterpret_cast<std::uintptr_t> (pImpl->mSessionPtr);
 }
 
+/// Prepared statements
+StatementRegistry &PostgreSQL::getStatementRegistry() noexcept
+{
+    return pImpl->mStatements;
+}
+
 /*
 /// Load the connection information
 void PostgreSQL::parseInitializationFile(const std::string &fileName,
@@ -3,6 +3,10 @@
 #include <memory>
 #include "events.hpp"
 namespace CCTService
+{
+ class StatementRegistry;
+}
+namespace CCTService
 {
 /// @name PostgreSQL "postgresql.hpp" "postgresql.hpp"
 /// @brief Defines a PostgreSQL connection.
@@ -126,6 +130,10 @@ public:
     /// @result A shared pointer to the session.
     /// @throws std::runtime_error if \c isConnected() is false.
     [[nodiscard]] std::uintptr_t getSession() const;
+    /// @result The statements prepared on this connection.  These are
+    ///         released when the connection is closed or reestablished so
+    ///         they are prepared again on the new session.
+    [[nodiscard]] StatementRegistry &getStatementRegistry() noexcept;
 
     /// @name Disconnect
     /// @{
@@ -0,0 +1,354 @@
+#include <string>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "sharedCatalog.hpp"
+
+using namespace CCTService;
+
+namespace
+{
+
+constexpr char magic[8]{'C', 'C', 'T', 'S', 'H', 'M', '2', '\0'};
+/// The slots start on a cache line.
+constexpr size_t slotAlignment{64};
+/// The number of times a reader retries when a publication races it.
+constexpr int maximumReadAttempts{32};
+/// The longest a reader backs off between attempts.
+constexpr std::chrono::microseconds maximumReadBackoff{10000};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free,
+              "Shared memory requires lock-free 64 bit atomics");
+
+/// The start of the region.  Everything the readers need to locate a
+/// catalog is an offset from the start of the region.
+struct Header
+{
+    char magic[8];
+    /// The bytes available to each slot.
+    uint64_t slotCapacity;
+    /// The offsets of the slots from the start of the region.
+    uint64_t slotOffset[2];
+    /// Odd while a publication is switching the active slot.
+    std::atomic<uint64_t> sequence;
+    /// Odd while the slot is being filled.  A reader that copied a slot
+    /// checks that its generation did not change during the copy.
+    std::atomic<uint64_t> generation[2];
+    /// The slot holding the published catalog.
+    std::atomic<uint64_t> activeSlot;
+    /// The length, epoch, and version of the catalog in each slot.  A
+    /// length of 0 indicates the slot is empty.
+    std::atomic<uint64_t> length[2];
+    std::atomic<uint64_t> epoch[2];
+    std::atomic<uint64_t> version[2];
+};
+
+[[nodiscard]] size_t getHeaderLength() noexcept
+{
+    return ((sizeof(Header) + slotAlignment - 1)/slotAlignment)*slotAlignment;
+}
+
+[[nodiscard]] std::string toRegionName(const std::string &name)
+{
+    if (name.empty()){throw std::invalid_argument("Region name is empty");}
+    if (name.front() == '/'){return name;}
+    return "/" + name;
+}
+
+}
+
+class SharedCatalogPublisher::SharedCatalogPublisherImpl
+{
+public:
+    SharedCatalogPublisherImpl(const std::string &name, const size_t capacity) :
+        mName(toRegionName(name))
+    {
+        if (capacity == 0)
+        {
+            throw std::invalid_argument("Capacity must be positive");
+        }
+        auto slotCapacity
+            = ((capacity + slotAlignment - 1)/slotAlignment)*slotAlignment;
+        mLength = getHeaderLength() + 2*slotCapacity;
+        // Replace a region left behind by a previous publisher
+        ::shm_unlink(mName.c_str());
+        auto descriptor = ::shm_open(mName.c_str(),
+                                     O_CREAT | O_EXCL | O_RDWR, 0644);
+        if (descriptor < 0)
+        {
+            throw std::runtime_error("Could not create " + mName);
+        }
+        if (::ftruncate(descriptor, static_cast<off_t> (mLength)) != 0)
+        {
+            ::close(descriptor);
+            ::shm_unlink(mName.c_str());
+            throw std::runtime_error("Could not size " + mName);
+        }
+        struct stat status;
+        if (::fstat(descriptor, &status) != 0)
+        {
+            ::close(descriptor);
+            ::shm_unlink(mName.c_str());
+            throw std::runtime_error("Could not stat " + mName);
+        }
+        mDevice = status.st_dev;
+        mInode = status.st_ino;
+        mData = ::mmap(nullptr, mLength, PROT_READ | PROT_WRITE, MAP_SHARED,
+                       descriptor, 0);
+        ::close(descriptor);
+        if (mData == MAP_FAILED)
+        {
+            ::shm_unlink(mName.c_str());
+            throw std::runtime_error("Could not map " + mName);
+        }
+        // The region is zero filled so the atomics start at 0
+        mHeader = static_cast<Header *> (mData);
+        mHeader->slotCapacity = slotCapacity;
+        mHeader->slotOffset[0] = getHeaderLength();
+        mHeader->slotOffset[1] = getHeaderLength() + slotCapacity;
+        std::atomic_thread_fence(std::memory_order_release);
+        // Readers check the magic last
+        std::memcpy(mHeader->magic, magic, sizeof(magic));
+    }
+    ~SharedCatalogPublisherImpl()
+    {
+        ::munmap(mData, mLength);
+        // A newer publisher may have replaced the region; leave it alone
+        if (isOwner()){::shm_unlink(mName.c_str());}
+    }
+    /// True indicates the name still refers to this publisher's region.
+    [[nodiscard]] bool isOwner() const
+    {
+        auto descriptor = ::shm_open(mName.c_str(), O_RDONLY, 0);
+        if (descriptor < 0){return false;}
+        struct stat status;
+        auto result = ::fstat(descriptor, &status);
+        ::close(descriptor);
+        if (result != 0){return false;}
+        return status.st_dev == mDevice && status.st_ino == mInode;
+    }
+    void publish(const std::string &packedCatalog,
+                 const uint64_t epoch, const uint64_t version)
+    {
+        if (packedCatalog.empty())
+        {
+            throw std::invalid_argument("Packed catalog is empty");
+        }
+        if (packedCatalog.size() > mHeader->slotCapacity)
+        {
+            throw std::invalid_argument("Catalog of "
+                                      + std::to_string(packedCatalog.size())
+                                      + " bytes exceeds slot capacity of "
+                                      + std::to_string(mHeader->slotCapacity));
+        }
+        // Fill the inactive slot.  Readers of the active slot are unaffected
+        // so the copy is not under the sequence lock.  A reader still
+        // copying this slot from an earlier publication sees its generation
+        // change and retries.
+        auto slot = 1 - mHeader->activeSlot.load(std::memory_order_relaxed);
+        auto generation
+            = mHeader->generation[slot].load(std::memory_order_relaxed);
+        mHeader->generation[slot].store(generation + 1,
+                                        std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        std::memcpy(static_cast<char *> (mData) + mHeader->slotOffset[slot],
+                    packedCatalog.data(), packedCatalog.size());
+        mHeader->generation[slot].store(generation + 2,
+                                        std::memory_order_release);
+        // Switch the active slot
+        auto sequence = mHeader->sequence.load(std::memory_order_relaxed);
+        mHeader->sequence.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        mHeader->length[slot].store(packedCatalog.size(),
+                                    std::memory_order_relaxed);
+        mHeader->epoch[slot].store(epoch, std::memory_order_relaxed);
+        mHeader->version[slot].store(version, std::memory_order_relaxed);
+        mHeader->activeSlot.store(slot, std::memory_order_relaxed);
+        mHeader->sequence.store(sequence + 2, std::memory_order_release);
+    }
+    std::string mName;
+    void *mData{nullptr};
+    Header *mHeader{nullptr};
+    size_t mLength{0};
+    dev_t mDevice{0};
+    ino_t mInode{0};
+};
+
+/// Constructor
+SharedCatalogPublisher::SharedCatalogPublisher(const std::string &name,
+                                               const size_t capacity) :
+    pImpl(std::make_unique<SharedCatalogPublisherImpl> (name, capacity))
+{
+}
+
+/// Publish
+void SharedCatalogPublisher::publish(const std::string &packedCatalog,
+                                     const uint64_t epoch,
+                                     const uint64_t version)
+{
+    pImpl->publish(packedCatalog, epoch, version);
+}
+
+/// Name
+std::string SharedCatalogPublisher::getName() const noexcept
+{
+    return pImpl->mName;
+}
+
+/// Destructor
+SharedCatalogPublisher::~SharedCatalogPublisher() = default;
+
+class SharedCatalogSubscriber::SharedCatalogSubscriberImpl
+{
+public:
+    explicit SharedCatalogSubscriberImpl(const std::string &name) :
+        mName(toRegionName(name))
+    {
+        auto descriptor = ::shm_open(mName.c_str(), O_RDONLY, 0);
+        if (descriptor < 0)
+        {
+            throw std::runtime_error(mName + " does not exist");
+        }
+        struct stat status;
+        if (::fstat(descriptor, &status) != 0 ||
+            static_cast<size_t> (status.st_size) < getHeaderLength())
+        {
+            ::close(descriptor);
+            throw std::runtime_error(mName + " is not a shared catalog");
+        }
+        mLength = static_cast<size_t> (status.st_size);
+        mDevice = status.st_dev;
+        mInode = status.st_ino;
+        mData = ::mmap(nullptr, mLength, PROT_READ, MAP_SHARED,
+                       descriptor, 0);
+        ::close(descriptor);
+        if (mData == MAP_FAILED)
+        {
+            throw std::runtime_error("Could not map " + mName);
+        }
+        mHeader = static_cast<const Header *> (mData);
+        // The magic is written last so check it first
+        bool isCatalog
+            = std::memcmp(mHeader->magic, magic, sizeof(magic)) == 0;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (!isCatalog ||
+            mHeader->slotOffset[1] + mHeader->slotCapacity > mLength)
+        {
+            ::munmap(mData, mLength);
+            throw std::runtime_error(mName + " is not a shared catalog");
+        }
+    }
+    ~SharedCatalogSubscriberImpl()
+    {
+        ::munmap(mData, mLength);
+    }
+    /// The mapping is stale if the name now refers to a different region.
+    [[nodiscard]] bool isStale() const
+    {
+        auto descriptor = ::shm_open(mName.c_str(), O_RDONLY, 0);
+        if (descriptor < 0){return true;}
+        struct stat status;
+        auto result = ::fstat(descriptor, &status);
+        ::close(descriptor);
+        if (result != 0){return true;}
+        return status.st_dev != mDevice || status.st_ino != mInode;
+    }
+    /// Waits a little longer after each failed attempt.
+    static void backoff(const int attempt)
+    {
+        if (attempt < 2)
+        {
+            std::this_thread::yield();
+            return;
+        }
+        std::this_thread::sleep_for(
+            std::min(std::chrono::microseconds {50LL << std::min(attempt, 16)},
+                     maximumReadBackoff));
+    }
+    /// Reads the active slot's metadata under the sequence lock and,
+    /// optionally, copies the slot under its generation.
+    [[nodiscard]] std::optional<SharedCatalogView> read(const bool copy) const
+    {
+        for (int attempt = 0; attempt < maximumReadAttempts; ++attempt)
+        {
+            if (attempt > 0){backoff(attempt);}
+            auto sequence = mHeader->sequence.load(std::memory_order_acquire);
+            if (sequence%2 == 1){continue;}
+            auto slot = mHeader->activeSlot.load(std::memory_order_relaxed);
+            if (slot > 1){continue;}
+            auto length = mHeader->length[slot].load(std::memory_order_relaxed);
+            SharedCatalogView view;
+            view.epoch = mHeader->epoch[slot].load(std::memory_order_relaxed);
+            view.version
+                = mHeader->version[slot].load(std::memory_order_relaxed);
+            auto generation
+                = mHeader->generation[slot].load(std::memory_order_acquire);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (mHeader->sequence.load(std::memory_order_relaxed) != sequence)
+            {
+                continue;
+            }
+            if (length == 0 || length > mHeader->slotCapacity)
+            {
+                return std::nullopt;
+            }
+            if (!copy){return view;}
+            // The slot is being refilled by a later publication
+            if (generation%2 == 1){continue;}
+            view.packedCatalog.assign(
+                static_cast<const char *> (mData)
+              + mHeader->slotOffset[slot], length);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (mHeader->generation[slot].load(std::memory_order_relaxed)
+                == generation)
+            {
+                return view;
+            }
+        }
+        throw std::runtime_error("Could not read a consistent catalog from "
+                               + mName);
+    }
+    std::string mName;
+    void *mData{nullptr};
+    const Header *mHeader{nullptr};
+    size_t mLength{0};
+    dev_t mDevice{0};
+    ino_t mInode{0};
+};
+
+/// Constructor
+SharedCatalogSubscriber::SharedCatalogSubscriber(const std::string &name) :
+    pImpl(std::make_unique<SharedCatalogSubscriberImpl> (name))
+{
+}
+
+/// Version
+std::optional<std::pair<uint64_t, uint64_t>>
+    SharedCatalogSubscriber::getVersion() const
+{
+    auto view = pImpl->read(false);
+    if (!view){return std::nullopt;}
+    return std::pair {view->epoch, view->version};
+}
+
+/// Replaced?
+bool SharedCatalogSubscriber::isStale() const
+{
+    return pImpl->isStale();
+}
+
+/// Read
+std::optional<SharedCatalogView> SharedCatalogSubscriber::read() const
+{
+    return pImpl->read(true);
+}
+
+/// Destructor
+SharedCatalogSubscriber::~SharedCatalogSubscriber() = default;
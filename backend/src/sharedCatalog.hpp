@@ -0,0 +1,89 @@
+#ifndef CCT_BACKEND_SERVICE_SHARED_CATALOG_HPP
+#define CCT_BACKEND_SERVICE_SHARED_CATALOG_HPP
+#include <memory>
+#include <optional>
+#include <string>
+#include <cstdint>
+namespace CCTService
+{
+/// @brief A catalog read from a shared memory region.
+struct SharedCatalogView
+{
+    /// A copy of the packed catalog.  See \c unpackCatalog().
+    std::string packedCatalog;
+    /// The publisher's catalog epoch.
+    uint64_t epoch{0};
+    /// The publisher's catalog version.
+    uint64_t version{0};
+};
+
+/// @name SharedCatalogPublisher "sharedCatalog.hpp" "sharedCatalog.hpp"
+/// @brief Publishes packed catalogs to a POSIX shared memory region.  The
+///        region is double buffered: the catalog is copied into the inactive
+///        slot which is then made active under a sequence lock.  Each slot
+///        has a generation that readers check after copying so that they
+///        never observe a partially written catalog.  The region
+///        only stores offsets and lengths so each process can map it at any
+///        address.  The region is removed when the publisher is destroyed
+///        unless a newer publisher has since replaced it.
+/// @copyright Ben Baker (University of Utah) distributed under the MIT license.
+class SharedCatalogPublisher
+{
+public:
+    /// @brief Creates or replaces the shared memory region.
+    /// @param[in] name      The region name, e.g., /cctCatalog_production.
+    /// @param[in] capacity  The number of bytes available to each of the
+    ///                      two catalog slots.
+    /// @throws std::runtime_error if the region cannot be created.
+    SharedCatalogPublisher(const std::string &name, size_t capacity);
+    /// @brief Publishes the packed catalog.
+    /// @param[in] packedCatalog  The catalog packed with \c packCatalog().
+    /// @param[in] epoch          The catalog's epoch.
+    /// @param[in] version        The catalog's version.
+    /// @throws std::invalid_argument if the catalog exceeds the capacity.
+    void publish(const std::string &packedCatalog,
+                 uint64_t epoch, uint64_t version);
+    /// @result The region name.
+    [[nodiscard]] std::string getName() const noexcept;
+    /// @brief Destructor.
+    ~SharedCatalogPublisher();
+
+    SharedCatalogPublisher(const SharedCatalogPublisher &) = delete;
+    SharedCatalogPublisher& operator=(const SharedCatalogPublisher &) = delete;
+private:
+    class SharedCatalogPublisherImpl;
+    std::unique_ptr<SharedCatalogPublisherImpl> pImpl;
+};
+
+/// @name SharedCatalogSubscriber "sharedCatalog.hpp" "sharedCatalog.hpp"
+/// @brief Maps a region created by \c SharedCatalogPublisher read-only.
+/// @copyright Ben Baker (University of Utah) distributed under the MIT license.
+class SharedCatalogSubscriber
+{
+public:
+    /// @brief Maps the shared memory region.
+    /// @throws std::runtime_error if the region does not exist or is not a
+    ///         shared catalog.
+    explicit SharedCatalogSubscriber(const std::string &name);
+    /// @result The epoch and version of the published catalog.  This is
+    ///         cheap and does not copy the catalog.
+    [[nodiscard]] std::optional<std::pair<uint64_t, uint64_t>> getVersion() const;
+    /// @result True indicates the publisher removed or replaced the region,
+    ///         e.g., because it restarted, so this should be recreated.
+    [[nodiscard]] bool isStale() const;
+    /// @result A consistent copy of the published catalog or nothing if
+    ///         no catalog has been published.
+    /// @throws std::runtime_error if a consistent copy could not be made
+    ///         because the publisher kept overwriting it.
+    [[nodiscard]] std::optional<SharedCatalogView> read() const;
+    /// @brief Destructor.
+    ~SharedCatalogSubscriber();
+
+    SharedCatalogSubscriber(const SharedCatalogSubscriber &) = delete;
+    SharedCatalogSubscriber& operator=(const SharedCatalogSubscriber &) = delete;
+private:
+    class SharedCatalogSubscriberImpl;
+    std::unique_ptr<SharedCatalogSubscriberImpl> pImpl;
+};
+}
+#endif
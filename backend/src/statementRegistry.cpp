@@ -0,0 +1,116 @@
+#include <string>
+#include <map>
+#include <mutex>
+#include <chrono>
+#include <spdlog/spdlog.h>
+#include "statementRegistry.hpp"
+
+using namespace CCTService;
+
+namespace
+{
+
+/// The statement timings of all connections.
+class StatementTimings
+{
+public:
+    void prepared(const std::string &name)
+    {
+        std::scoped_lock lock(mMutex);
+        auto &statistics = mStatistics[name];
+        statistics.preparations = statistics.preparations + 1;
+    }
+    void executed(const std::string &name, const uint64_t microSeconds)
+    {
+        std::scoped_lock lock(mMutex);
+        auto &statistics = mStatistics[name];
+        statistics.executions = statistics.executions + 1;
+        statistics.executionMicroSeconds
+            = statistics.executionMicroSeconds + microSeconds;
+        statistics.maximumExecutionMicroSeconds
+            = std::max(statistics.maximumExecutionMicroSeconds, microSeconds);
+    }
+    [[nodiscard]] std::map<std::string, StatementStatistics> get() const
+    {
+        std::scoped_lock lock(mMutex);
+        return mStatistics;
+    }
+private:
+    mutable std::mutex mMutex;
+    std::map<std::string, StatementStatistics> mStatistics;
+};
+
+StatementTimings &getTimings()
+{
+    static StatementTimings timings;
+    return timings;
+}
+
+}
+
+/// Statistics
+std::map<std::string, StatementStatistics> CCTService::getStatementStatistics()
+{
+    return ::getTimings().get();
+}
+
+/// Execute
+void PreparedStatement::execute()
+{
+    if (!mStatement){throw std::runtime_error("Statement not prepared");}
+    auto startTime = std::chrono::steady_clock::now();
+    mStatement->execute();
+    auto microSeconds
+        = std::chrono::duration_cast<std::chrono::microseconds>
+          (std::chrono::steady_clock::now() - startTime).count();
+    ::getTimings().executed(mName, static_cast<uint64_t> (microSeconds));
+}
+
+/// Fetch
+bool PreparedStatement::fetch()
+{
+    if (!mStatement){throw std::runtime_error("Statement not prepared");}
+    return mStatement->fetch();
+}
+
+/// Name
+const std::string &PreparedStatement::getName() const noexcept
+{
+    return mName;
+}
+
+/// Constructor
+StatementRegistry::StatementRegistry(soci::session &session) :
+    mSession(session)
+{
+}
+
+/// Get
+PreparedStatement &StatementRegistry::get(const std::string &name,
+                                          const Preparer &preparer)
+{
+    auto it = mStatements.find(name);
+    if (it != mStatements.end()){return *it->second;}
+    spdlog::debug("Preparing " + name);
+    auto statement = std::make_unique<PreparedStatement> ();
+    statement->mName = name;
+    statement->mStatement.emplace(preparer(mSession, *statement)); // Throws
+    ::getTimings().prepared(name);
+    return *mStatements.insert(std::pair {name, std::move(statement)})
+           .first->second;
+}
+
+/// Size
+size_t StatementRegistry::size() const noexcept
+{
+    return mStatements.size();
+}
+
+/// Clear
+void StatementRegistry::clear() noexcept
+{
+    mStatements.clear();
+}
+
+/// Destructor
+StatementRegistry::~StatementRegistry() = default;
@@ -0,0 +1,133 @@
+#ifndef CCT_BACKEND_SERVICE_DATABASE_STATEMENT_REGISTRY_HPP
+#define CCT_BACKEND_SERVICE_DATABASE_STATEMENT_REGISTRY_HPP
+#include <memory>
+#include <map>
+#include <string>
+#include <functional>
+#include <optional>
+#include <any>
+#include <cstdint>
+#include <soci/soci.h>
+namespace CCTService
+{
+/// @brief The execution times of a named statement summed over all of the
+///        connections.
+struct StatementStatistics
+{
+    /// The number of times the statement was prepared.
+    uint64_t preparations{0};
+    /// The number of times the statement was executed.
+    uint64_t executions{0};
+    /// The total and largest execution time in microseconds.
+    uint64_t executionMicroSeconds{0};
+    uint64_t maximumExecutionMicroSeconds{0};
+    /// @result The mean execution time in microseconds.
+    [[nodiscard]] double getMeanExecutionMicroSeconds() const noexcept
+    {
+        if (executions == 0){return 0;}
+        return static_cast<double> (executionMicroSeconds)
+              /static_cast<double> (executions);
+    }
+};
+
+/// @brief The execution times of the named statements.  The names are
+///        prefixed by the schema, e.g., production.updateQuery.
+[[nodiscard]] std::map<std::string, StatementStatistics> getStatementStatistics();
+
+/// @name PreparedStatement "statementRegistry.hpp" "statementRegistry.hpp"
+/// @brief A statement prepared once on a connection and executed many times.
+///        The parameters and the result row are bound by reference when the
+///        statement is prepared so the caller sets the parameters then
+///        executes.  This does not move once prepared.
+/// @copyright Ben Baker (University of Utah) distributed under the MIT license.
+class PreparedStatement
+{
+public:
+    /// @name Bound Parameters
+    /// @{
+
+    /// An event identifier.
+    long long identifier{0};
+    /// A UNIX time, e.g., a last_update watermark.
+    double time{0};
+    /// A text value, e.g., a review status or a Postgres array literal.
+    std::string text;
+    /// @}
+
+    /// The current result row.
+    soci::row row;
+    /// @result Buffers of type T, e.g., column vectors for bulk fetches,
+    ///         that are bound by reference when the statement is prepared.
+    ///         These are created on first use.
+    /// @throws std::bad_any_cast if the buffers are not of type T.
+    template<typename T>
+    [[nodiscard]] T &getBuffers()
+    {
+        if (!mBuffers.has_value()){mBuffers.emplace<T> ();}
+        return std::any_cast<T &> (mBuffers);
+    }
+
+    /// @brief Executes the statement with the current parameters.
+    /// @throws soci::soci_error if the statement fails.
+    void execute();
+    /// @brief Moves to the next result row.
+    /// @result False indicates there are no more rows.
+    [[nodiscard]] bool fetch();
+    /// @result The statement's name.
+    [[nodiscard]] const std::string &getName() const noexcept;
+
+    PreparedStatement() = default;
+    PreparedStatement(const PreparedStatement &) = delete;
+    PreparedStatement& operator=(const PreparedStatement &) = delete;
+private:
+    friend class StatementRegistry;
+    std::string mName;
+    std::any mBuffers;
+    std::optional<soci::statement> mStatement;
+};
+
+/// @name StatementRegistry "statementRegistry.hpp" "statementRegistry.hpp"
+/// @brief The statements prepared on a connection.  Postgres parses and plans
+///        a statement when it is prepared so repeated executions skip that
+///        work.  The statements must be cleared before the connection's
+///        session is closed or reopened.  Like the connection this is not
+///        thread-safe.
+/// @copyright Ben Baker (University of Utah) distributed under the MIT license.
+class StatementRegistry
+{
+public:
+    /// @brief Prepares the statement from the session and binds the
+    ///        statement's parameters and row, e.g.,
+    /// @code
+    ///        [](soci::session &session, PreparedStatement &statement)
+    ///        {
+    ///            return soci::statement {
+    ///                (session.prepare << "SELECT ... WHERE identifier = :identifier",
+    ///                 soci::use(statement.identifier),
+    ///                 soci::into(statement.row))};
+    ///        }
+    /// @endcode
+    using Preparer = std::function<soci::statement (soci::session &, PreparedStatement &)>;
+
+    /// @brief Creates the registry for the session.
+    explicit StatementRegistry(soci::session &session);
+    /// @result The named statement.  If the statement was not yet prepared
+    ///         on this connection then it is prepared with the preparer.
+    /// @throws soci::soci_error if the statement cannot be prepared.
+    [[nodiscard]] PreparedStatement &get(const std::string &name,
+                                         const Preparer &preparer);
+    /// @result The number of prepared statements.
+    [[nodiscard]] size_t size() const noexcept;
+    /// @brief Releases the prepared statements.
+    void clear() noexcept;
+    /// @brief Destructor.
+    ~StatementRegistry();
+
+    StatementRegistry(const StatementRegistry &) = delete;
+    StatementRegistry& operator=(const StatementRegistry &) = delete;
+private:
+    soci::session &mSession;
+    std::map<std::string, std::unique_ptr<PreparedStatement>> mStatements;
+};
+}
+#endif
@@ -0,0 +1,69 @@
+#include <string>
+#include <vector>
+#include <map>
+#include <mutex>
+#include <shared_mutex>
+#include <stdexcept>
+#include "stationNameTable.hpp"
+
+using namespace CCTService;
+
+class StationNameTable::StationNameTableImpl
+{
+public:
+    /// Ingest workers mostly look up known stations so they share the lock.
+    mutable std::shared_mutex mMutex;
+    std::map<std::string, int32_t> mIdentifiers;
+    std::vector<std::string> mNames;
+};
+
+/// Constructor
+StationNameTable::StationNameTable() :
+    pImpl(std::make_unique<StationNameTableImpl> ())
+{
+}
+
+/// Destructor
+StationNameTable::~StationNameTable() = default;
+
+/// Add a station name
+int32_t StationNameTable::intern(const std::string &name)
+{
+    if (name.empty()){throw std::invalid_argument("Station name is empty");}
+    {
+    std::shared_lock lock(pImpl->mMutex);
+    auto idx = pImpl->mIdentifiers.find(name);
+    if (idx != pImpl->mIdentifiers.end()){return idx->second;}
+    }
+    std::scoped_lock lock(pImpl->mMutex);
+    auto idx = pImpl->mIdentifiers.find(name);
+    if (idx != pImpl->mIdentifiers.end()){return idx->second;}
+    auto identifier = static_cast<int32_t> (pImpl->mNames.size());
+    pImpl->mIdentifiers.insert(std::pair {name, identifier});
+    pImpl->mNames.push_back(name);
+    return identifier;
+}
+
+/// Station identifier
+std::optional<int32_t>
+StationNameTable::getIdentifier(const std::string &name) const noexcept
+{
+    std::shared_lock lock(pImpl->mMutex);
+    auto idx = pImpl->mIdentifiers.find(name);
+    if (idx != pImpl->mIdentifiers.end()){return idx->second;}
+    return std::nullopt;
+}
+
+/// Station name
+std::string StationNameTable::getName(const int32_t identifier) const
+{
+    std::shared_lock lock(pImpl->mMutex);
+    return pImpl->mNames.at(identifier);
+}
+
+/// Number of stations
+size_t StationNameTable::size() const noexcept
+{
+    std::shared_lock lock(pImpl->mMutex);
+    return pImpl->mNames.size();
+}
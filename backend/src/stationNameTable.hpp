@@ -0,0 +1,43 @@
+#ifndef CCT_BACKEND_SERVICE_STATION_NAME_TABLE_HPP
+#define CCT_BACKEND_SERVICE_STATION_NAME_TABLE_HPP
+#include <memory>
+#include <string>
+#include <optional>
+#include <cstdint>
+namespace CCTService
+{
+/// @class StationNameTable "stationNameTable.hpp" "stationNameTable.hpp"
+/// @brief Interns the station names across events so that events can refer
+///        to stations by a small integer identifier.  Only the names are
+///        kept since different events can carry different coordinates for
+///        the same station.  This class is thread-safe.
+/// @copyright Ben Baker (University of Utah) distributed under the MIT license.
+class StationNameTable
+{
+public:
+    /// @brief Constructor.
+    StationNameTable();
+    /// @brief Adds the station if it does not exist.  A known station is
+    ///        only looked up so concurrent callers do not contend.
+    /// @param[in] name  The station name, e.g., UU.CTU.
+    /// @result The station's identifier in the table.
+    /// @throws std::invalid_argument if the name is empty.
+    int32_t intern(const std::string &name);
+    /// @result The station's identifier in the table if it exists.
+    [[nodiscard]] std::optional<int32_t> getIdentifier(const std::string &name) const noexcept;
+    /// @result The station's name.
+    /// @throws std::out_of_range if the identifier does not exist.
+    [[nodiscard]] std::string getName(int32_t identifier) const;
+    /// @result The number of stations in the table.
+    [[nodiscard]] size_t size() const noexcept;
+    /// @brief Destructor.
+    ~StationNameTable();
+
+    StationNameTable(const StationNameTable &) = delete;
+    StationNameTable& operator=(const StationNameTable &) = delete;
+private:
+    class StationNameTableImpl;
+    std::unique_ptr<StationNameTableImpl> pImpl;
+};
+}
+#endif
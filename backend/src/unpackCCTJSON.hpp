@@ -3,50 +3,68 @@
 #include <nlohmann/json.hpp>
 #include <spdlog/spdlog.h>
 #include <string>
+#include <vector>
+#include <map>
+#include <algorithm>
+#include <limits>
 #include <cmath>
+#include "eventModel.hpp"
+#include "geometry.hpp"
+#include "stationNameTable.hpp"
 namespace 
 {
 
-/// @brief This is a convenience function to unpack the JSON data
-///        stored in the Postgres CCT database and provide what is
-///        necessary to the frontend.
+/// @brief This is a convenience function to unpack the summary of the JSON
+///        data stored in the Postgres CCT database, i.e., the information
+///        required to populate a row of the frontend's event table.
 /// @param[in] json   The JSON data to unpack.
 /// @param[in] eventIdentifier  The event identifier.
-/// @result A light-weight representation of the JSON data that
-///         can be used by the frontned.
+/// @result The origin information of the summary.  The database columns
+///         and network magnitude inputs are set by the caller.
 [[nodiscard]]
-nlohmann::json unpackCCTJSON(const nlohmann::json &json,
-                             const std::string &eventIdentifier)
+CCTService::EventSummary unpackCCTJSONSummary(const nlohmann::json &json,
+                                              const std::string &eventIdentifier)
 {
-    constexpr double tol{1.e-5};
-    nlohmann::json outputObject;
-    nlohmann::json eventObject;
-    // First let's set some basics
-    outputObject.emplace("eventIdentifier", eventIdentifier);
+    CCTService::EventSummary summary;
+    summary.identifier = std::stoll(eventIdentifier);
     const auto &measuredMwDetails = json["measuredMwDetails"][eventIdentifier];
     auto originTime
         = measuredMwDetails["datetime"].template get<std::string> ();
     if (originTime.back() == 'Z'){originTime.pop_back();}
-    auto latitude
+    summary.originTime = std::move(originTime);
+    summary.latitude
         = measuredMwDetails["latitude"].template get<double> (); 
-    auto longitude
+    summary.longitude
         = measuredMwDetails["longitude"].template get<double> ();
-    auto depth
+    summary.depth
         = measuredMwDetails["depth"].template get<double> ();
-    auto likelyPoorlyConstrained
+    summary.likelyPoorlyConstrained
         = measuredMwDetails["likelyPoorlyConstrained"].template get<bool> ();
-    outputObject.emplace("originTime", originTime);
-    outputObject.emplace("latitude", latitude);
-    outputObject.emplace("longitude", longitude);
-    outputObject.emplace("depth", depth);
-    outputObject.emplace("likelyPoorlyConstrained", likelyPoorlyConstrained);
+    return summary;
+}
+
+/// @brief This is a convenience function to unpack the spectral fit and
+///        station measurements from the JSON data stored in the Postgres
+///        CCT database.  This is only required when the frontend plots
+///        an event.
+/// @param[in] json   The JSON data to unpack.
+/// @param[in] eventIdentifier  The event identifier.
+/// @param[in,out] stationNames  The station names are interned in this
+///                              table.
+/// @result The event's spectral fit and station measurements.
+[[nodiscard]]
+CCTService::EventDetails unpackCCTJSONDetails(
+    const nlohmann::json &json,
+    const std::string &eventIdentifier,
+    CCTService::StationNameTable &stationNames)
+{
+    constexpr double tol{1.e-5};
+    CCTService::EventDetails details;
     // Now, we want to get the spectra b/c we can compute residuals from this
     const auto &fitSpectra = json["fitSpectra"][eventIdentifier];
     std::vector<double> fitFrequencies;
     std::vector<double> fitValues;
-    bool haveUQ1{false};
-    bool haveUQ2{false};
-    nlohmann::json spectralObject;
+    auto &spectralFit = details.spectralFit;
     for (const auto &type : fitSpectra)
     {
         if (!type.contains("type")){continue;}
@@ -57,55 +75,57 @@ nlohmann::json unpackCCTJSON(const nlohmann::json &json,
             continue;
         }
         bool isFit = type["type"] == "FIT";
-        auto frequencies = nlohmann::json::array ();
-        auto values = nlohmann::json::array ();
-        for (const auto &item : type["spectraXY"])
+        CCTService::Spectrum spectrum;
+        const auto &spectraXY = type["spectraXY"];
+        spectrum.frequencies.reserve(spectraXY.size());
+        spectrum.values.reserve(spectraXY.size());
+        for (const auto &item : spectraXY)
         {
             auto frequency = std::pow(10, item["x"].template get<double> ());
             auto value = item["y"].template get<double> ();
-            frequencies.push_back(frequency);
-            values.push_back(value);
-            if (isFit)
-            {
-                fitFrequencies.push_back(frequency);
-                fitValues.push_back(value);
-            }
+            spectrum.frequencies.push_back(frequency);
+            spectrum.values.push_back(value);
+        }
+        if (isFit && fitFrequencies.empty())
+        {
+            fitFrequencies = spectrum.frequencies;
+            fitValues = spectrum.values;
         }
-        nlohmann::json spectralXY;
-        spectralXY.emplace("frequencies", std::move(frequencies));
-        spectralXY.emplace("values", std::move(values));
         if (type["type"] == "FIT")
         {
-            spectralObject.emplace("fit", std::move(spectralXY));
+            if (!spectralFit.fit){spectralFit.fit = std::move(spectrum);}
         }
         // I think uq1 is 1 std then we get a lower and upper
         else if (type["type"] == "UQ1")
         {
-            if (haveUQ1)
+            if (spectralFit.bruneUpperBound1)
             {
-                spectralObject.emplace("bruneLowerBound-1", std::move(spectralXY));
+                if (!spectralFit.bruneLowerBound1)
+                {
+                    spectralFit.bruneLowerBound1 = std::move(spectrum);
+                }
             }
             else
             {
-                spectralObject.emplace("bruneUpperBound-1", std::move(spectralXY));
+                spectralFit.bruneUpperBound1 = std::move(spectrum);
             }
-            haveUQ1 = true;
         }
         // I think uq2 is 2 std then we get a lower and upper
         else if (type["type"] == "UQ2")
         {
-            if (haveUQ2)
+            if (spectralFit.bruneUpperBound2)
             {
-                spectralObject.emplace("bruneLowerBound-2", std::move(spectralXY));
+                if (!spectralFit.bruneLowerBound2)
+                {
+                    spectralFit.bruneLowerBound2 = std::move(spectrum);
+                }
             }
             else
             {
-                spectralObject.emplace("bruneUpperBound-2", std::move(spectralXY));
+                spectralFit.bruneUpperBound2 = std::move(spectrum);
             }
-            haveUQ2 = true;
         }
     }
-    outputObject.emplace("spectralFit", std::move(spectralObject) );
     // Finally we get the station measurements which is annoying
     struct MeasurementDetails
     {
@@ -176,32 +196,32 @@ nlohmann::json unpackCCTJSON(const nlohmann::json &json,
     if (identifierToMeasurementMap.size() !=
         identifierToStationMap.size())
     {
-        spdlog::warn("Number of stream identifiers and stations differs");
+        spdlog::debug("Number of stream identifiers and stations differs for "
+                    + eventIdentifier);
     }
-    // Now build an output object for every station / measurements
-    auto stationMeasurements = nlohmann::json::array ();
+    // Now build the measurements for every station
     for (auto &spectraMeasurementsPair : identifierToMeasurementMap)
     {
         auto idx = identifierToStationMap.find(spectraMeasurementsPair.first);
         if (idx != identifierToStationMap.end())
         {
-            auto station = idx->second;
+            const auto &station = idx->second;
             std::sort(spectraMeasurementsPair.second.begin(),
                       spectraMeasurementsPair.second.end(), 
                       [](const auto &lhs, const auto &rhs)
                       {
                          return lhs.centerFrequency < rhs.centerFrequency;
                       });
-            nlohmann::json stationObject;
-            stationObject["station"] = station;
-            auto measurements = nlohmann::json::array ();
+            CCTService::StationMeasurements stationMeasurements;
+            stationMeasurements.station = stationNames.intern(station);
+            auto nMeasurements = spectraMeasurementsPair.second.size();
+            stationMeasurements.centerFrequencies.reserve(nMeasurements);
+            stationMeasurements.values.reserve(nMeasurements);
+            stationMeasurements.residuals.reserve(nMeasurements);
             for (const auto &measurement : spectraMeasurementsPair.second)
             {
-                nlohmann::json observation;
-                observation["centerFrequency"] = measurement.centerFrequency;
-                observation["value"] = measurement.value;
                 // Get a residual
-                double residual{0};
+                double residual{std::numeric_limits<double>::quiet_NaN()};
                 bool found{false};
                 for (int i = 0; i < static_cast<int> (fitFrequencies.size()); ++i)
                 {
@@ -213,25 +233,181 @@ nlohmann::json unpackCCTJSON(const nlohmann::json &json,
                         break;
                     }
                 }
-                if (found)
-                {
-                    observation["residual"] = residual;
-                }
-                else
+                if (!found)
                 {
                     spdlog::warn("Couldn't find residual for " + station
                                + " at frequency "
                                + std::to_string(measurement.centerFrequency));
-                    observation["residual"] = nullptr;
                 } 
-                measurements.push_back( std::move(observation) );
+                stationMeasurements.centerFrequencies.push_back(
+                    measurement.centerFrequency);
+                stationMeasurements.values.push_back(measurement.value);
+                stationMeasurements.residuals.push_back(residual);
+            }
+            details.stationMeasurements.push_back(
+                std::move(stationMeasurements));
+        }
+    }
+    return details;
+}
+
+/// @brief Computes the quantities required to create the network magnitude
+///        when the event is accepted.  This is done once at ingest.  The
+///        source-station geometry is computed from this event's own station
+///        coordinates since events can carry different metadata for the
+///        same station.
+/// @param[in] json   The JSON data stored in the Postgres CCT database.
+/// @param[in] identifier  The event identifier.
+/// @param[in] accuracy  The accuracy of the distance and azimuth calculations.
+///                      By default this is the Andoyer-Lambert approximation
+///                      which agrees with the geodesic to meters.
+/// @result The magnitude, station and observation counts, closest distance,
+///         and azimuthal gap.  Quantities that could not be computed are
+///         negative.
+/// @throws std::runtime_error if the magnitude is not set.
+[[nodiscard]]
+CCTService::NetMagInputs unpackCCTJSONNetMagInputs(
+    const nlohmann::json &json, const std::string &identifier,
+    const CCTService::GeometryAccuracy accuracy
+        = CCTService::GeometryAccuracy::AndoyerLambert)
+{
+    CCTService::NetMagInputs result;
+    std::map<std::string, std::pair<double, double>> stationLocationsForEvent;
+    std::pair<double, double> eventLocation;
+    bool haveEventLocation{false};
+    if (json.contains("measuredMwDetails"))
+    {
+        const auto &measuredMwDetails 
+            = json["measuredMwDetails"]; 
+        if (measuredMwDetails.contains(identifier))
+        {
+            const auto &measuredMwDetailsForEvent
+                = measuredMwDetails[identifier];
+            if (!measuredMwDetailsForEvent.contains("mw"))
+            {
+                throw std::runtime_error("mw not set");
+            }
+            result.magnitude
+                 = measuredMwDetailsForEvent["mw"].template get<double> ();
+            if (measuredMwDetailsForEvent.contains("stationCount"))
+            {
+                result.nStations
+                    = measuredMwDetailsForEvent["stationCount"].template
+                      get<int> (); 
+            }
+            if (measuredMwDetailsForEvent.contains("latitude") &&
+                measuredMwDetailsForEvent.contains("longitude"))
+            {
+                auto latitude = measuredMwDetailsForEvent["latitude"].template get<double> ();
+                auto longitude = measuredMwDetailsForEvent["longitude"].template get<double> ();
+                if (latitude >= -90 && latitude <= 90)
+                {
+                    eventLocation = std::pair {latitude, longitude};
+                    haveEventLocation = true;
+                }
             }
-            stationObject["measurements"] = std::move(measurements);
-            stationMeasurements.push_back(std::move(stationObject));
         }
     }
-    outputObject.emplace("stationMeasurements", std::move(stationMeasurements));
-    return outputObject;
+    int observationCounter{0};
+    if (json.contains("spectraMeasurements"))
+    {
+        const auto &spectraMeasurements
+            = json["spectraMeasurements"];
+        if (spectraMeasurements.contains(identifier))
+        {
+            for (const auto &measurement :
+                 spectraMeasurements[identifier])
+            {
+                if (measurement.contains("pathAndSiteCorrected"))
+                {
+                    if (measurement["pathAndSiteCorrected"].is_number())
+                    {
+                        observationCounter = observationCounter + 1;
+                    }
+                }
+                if (measurement.contains("waveform"))
+                {
+                    const auto &waveform = measurement["waveform"];
+                    if (waveform.contains("stream"))
+                    {
+                        const auto &stream = waveform["stream"];
+                        if (stream.contains("station"))
+                        {
+                            const auto &station = stream["station"];
+                            if (station.contains("latitude") &&
+                                station.contains("longitude") &&
+                                station.contains("networkName") &&
+                                station.contains("stationName"))
+                            {
+                                auto name = station["networkName"].template get<std::string> ()
+                                          + "."
+                                          + station["stationName"].template get<std::string> ();
+                                auto latitude = station["latitude"].template get<double> ();
+                                auto longitude = station["longitude"].template get<double> ();
+                                if (!stationLocationsForEvent.contains(name) &&
+                                    (latitude >=-90 && latitude <= 90))
+                                {
+                                    stationLocationsForEvent.insert(
+                                        std::pair {name,
+                                                   std::pair {latitude,
+                                                              longitude}});
+                                }
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+    if (observationCounter >= 0){result.nObservations = observationCounter;}
+    // Warning - I guess the mwMeasured details are authorative?
+    if (result.nStations != static_cast<int> (stationLocationsForEvent.size()))
+    {
+        spdlog::debug("Number of stations differs from the number of station locations for " + identifier);
+    }
+    // Throws - but these aren't essential things so eat the error
+    if (haveEventLocation && !stationLocationsForEvent.empty())
+    {
+        try
+        {
+            std::vector<double> latitudes;
+            std::vector<double> longitudes;
+            latitudes.reserve(stationLocationsForEvent.size());
+            longitudes.reserve(stationLocationsForEvent.size());
+            for (const auto &stationLocation : stationLocationsForEvent)
+            {
+                latitudes.push_back(stationLocation.second.first);
+                longitudes.push_back(stationLocation.second.second);
+            }
+            auto geometry
+                = CCTService::computeSourceStationGeometry(
+                     eventLocation.first,
+                     eventLocation.second,
+                     latitudes,
+                     longitudes,
+                     accuracy);
+            result.closestDistance
+                = *std::min_element(geometry.distances.begin(),
+                                    geometry.distances.end())*1.e-3;
+            result.azimuthalGap
+                = CCTService::computeAzimuthalGap(
+                     std::move(geometry.backAzimuths));
+        }
+        catch (const std::exception &e)
+        {
+            spdlog::warn("Failed to get distance/azimuth because " 
+                       + std::string {e.what()});
+        }
+    }
+    else if (haveEventLocation)
+    {
+        spdlog::debug("No station locations for " + identifier);
+    }
+    else
+    {
+        spdlog::warn("Could not extract event location from JSON");
+    }
+    return result;
 }
 
 }
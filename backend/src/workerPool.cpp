@@ -0,0 +1,76 @@
+#include <thread>
+#include <vector>
+#include <string>
+#include <stdexcept>
+#include <spdlog/spdlog.h>
+#include "workerPool.hpp"
+#include "boundedQueue.hpp"
+
+using namespace CCTService;
+
+class WorkerPool::WorkerPoolImpl
+{
+public:
+    explicit WorkerPoolImpl(const size_t queueCapacity) :
+        mTasks(queueCapacity)
+    {
+    }
+    void work()
+    {
+        while (auto task = mTasks.pop())
+        {
+            // Packaged tasks capture their exceptions
+            try
+            {
+                (*task)();
+            }
+            catch (const std::exception &e)
+            {
+                spdlog::error("Worker task failed with: "
+                            + std::string {e.what()});
+            }
+        }
+    }
+    BoundedQueue<std::function<void ()>> mTasks;
+    std::vector<std::thread> mThreads;
+};
+
+/// Constructor
+WorkerPool::WorkerPool(size_t nThreads, const size_t queueCapacity) :
+    pImpl(std::make_unique<WorkerPoolImpl> (queueCapacity))
+{
+    if (nThreads == 0)
+    {
+        nThreads = std::max(1U, std::thread::hardware_concurrency());
+    }
+    for (size_t i = 0; i < nThreads; ++i)
+    {
+        pImpl->mThreads.push_back(std::thread(&WorkerPoolImpl::work,
+                                              pImpl.get()));
+    }
+}
+
+/// Enqueue
+void WorkerPool::enqueue(std::function<void ()> &&task)
+{
+    if (!pImpl->mTasks.push(std::move(task)))
+    {
+        throw std::runtime_error("Worker pool is shutting down");
+    }
+}
+
+/// Size
+size_t WorkerPool::size() const noexcept
+{
+    return pImpl->mThreads.size();
+}
+
+/// Destructor
+WorkerPool::~WorkerPool()
+{
+    pImpl->mTasks.close();
+    for (auto &thread : pImpl->mThreads)
+    {
+        if (thread.joinable()){thread.join();}
+    }
+}
@@ -0,0 +1,54 @@
+#ifndef CCT_BACKEND_SERVICE_WORKER_POOL_HPP
+#define CCT_BACKEND_SERVICE_WORKER_POOL_HPP
+#include <memory>
+#include <functional>
+#include <future>
+#include <type_traits>
+namespace CCTService
+{
+/// @name WorkerPool "workerPool.hpp" "workerPool.hpp"
+/// @brief A fixed set of threads running CPU-bound tasks from a bounded
+///        queue.  Submitting blocks while the queue is full.  This class is
+///        thread-safe.
+/// @copyright Ben Baker (University of Utah) distributed under the MIT license.
+class WorkerPool
+{
+public:
+    /// @brief Starts the threads.
+    /// @param[in] nThreads       The number of threads.  If 0 then this is the
+    ///                           number of hardware threads.
+    /// @param[in] queueCapacity  The number of tasks that can wait for a
+    ///                           thread.
+    /// @throws std::invalid_argument if the queue capacity is 0.
+    WorkerPool(size_t nThreads, size_t queueCapacity);
+    /// @brief Runs the task on a worker.
+    /// @result The task's result or exception.
+    /// @throws std::runtime_error if the pool is shutting down.
+    template<typename F>
+    [[nodiscard]] std::future<std::invoke_result_t<F>> submit(F &&task)
+    {
+        using Result = std::invoke_result_t<F>;
+        auto packagedTask
+            = std::make_shared<std::packaged_task<Result ()>>
+              (std::forward<F> (task));
+        auto future = packagedTask->get_future();
+        enqueue([packagedTask]()
+                {
+                    (*packagedTask)();
+                });
+        return future;
+    }
+    /// @result The number of threads.
+    [[nodiscard]] size_t size() const noexcept;
+    /// @brief Finishes the queued tasks and joins the threads.
+    ~WorkerPool();
+
+    WorkerPool(const WorkerPool &) = delete;
+    WorkerPool& operator=(const WorkerPool &) = delete;
+private:
+    void enqueue(std::function<void ()> &&task);
+    class WorkerPoolImpl;
+    std::unique_ptr<WorkerPoolImpl> pImpl;
+};
+}
+#endif
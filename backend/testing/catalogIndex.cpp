@@ -0,0 +1,204 @@
+#include <string>
+#include <vector>
+#include <catch2/catch_test_macros.hpp>
+#include "catalogIndex.hpp"
+
+using namespace CCTService;
+
+namespace
+{
+EventSummary createSummary(const int64_t identifier)
+{
+    EventSummary summary;
+    summary.identifier = identifier;
+    summary.originTime = "2024-01-" + std::string {identifier < 10 ? "0" : ""}
+                       + std::to_string(identifier) + "T00:00:00.000";
+    summary.cctMagnitude = static_cast<double> (identifier%5);
+    summary.authoritativeMagnitude = 0.5*static_cast<double> (identifier);
+    summary.reviewStatus = identifier%3 == 0 ? "A" : "F";
+    summary.creationMode = identifier%2 == 0 ? "automatic" : "manual";
+    summary.likelyPoorlyConstrained = identifier == 7;
+    return summary;
+}
+
+/// The identifiers of the query's page in order.
+std::vector<int64_t> queryIdentifiers(const CatalogIndex &index,
+                                      const std::vector<int64_t> &rowIdentifiers,
+                                      const CatalogQuery &query)
+{
+    std::vector<int64_t> result;
+    for (const auto &row : index.query(query).rows)
+    {
+        result.push_back(rowIdentifiers.at(row));
+    }
+    return result;
+}
+}
+
+TEST_CASE("CCTService::CatalogIndex", "[catalogIndex]")
+{
+    CatalogIndex index;
+    std::vector<int64_t> rowIdentifiers;
+    for (int64_t identifier = 1; identifier <= 12; ++identifier)
+    {
+        index.append(identifier, createSummary(identifier));
+        rowIdentifiers.push_back(identifier);
+    }
+    REQUIRE(index.size() == 12);
+
+    SECTION("Filter")
+    {
+        CatalogQuery query;
+        query.reviewStatuses = {"A"};
+        REQUIRE(queryIdentifiers(index, rowIdentifiers, query)
+             == std::vector<int64_t> {3, 6, 9, 12});
+        query.creationModes = {"automatic"};
+        REQUIRE(queryIdentifiers(index, rowIdentifiers, query)
+             == std::vector<int64_t> {6, 12});
+        query = CatalogQuery {};
+        query.minimumMagnitude = 2;
+        query.maximumMagnitude = 3;
+        REQUIRE(queryIdentifiers(index, rowIdentifiers, query)
+             == std::vector<int64_t> {4, 5, 6});
+        query = CatalogQuery {};
+        query.minimumOriginTime = originTimeToEpoch("2024-01-10T00:00:00");
+        REQUIRE(queryIdentifiers(index, rowIdentifiers, query)
+             == std::vector<int64_t> {10, 11, 12});
+        query = CatalogQuery {};
+        query.likelyPoorlyConstrained = true;
+        REQUIRE(queryIdentifiers(index, rowIdentifiers, query)
+             == std::vector<int64_t> {7});
+        query = CatalogQuery {};
+        query.reviewStatuses = {"R"};
+        auto result = index.query(query);
+        REQUIRE(result.rows.empty());
+        REQUIRE(result.totalCount == 0);
+        REQUIRE(!result.nextCursor);
+    }
+
+    SECTION("Sort")
+    {
+        CatalogQuery query;
+        query.sortKey = CatalogQuery::SortKey::OriginTime;
+        query.descending = true;
+        auto identifiers = queryIdentifiers(index, rowIdentifiers, query);
+        REQUIRE(identifiers.front() == 12);
+        REQUIRE(identifiers.back() == 1);
+        // Ties are broken by the identifier
+        query.sortKey = CatalogQuery::SortKey::CCTMagnitude;
+        query.descending = false;
+        identifiers = queryIdentifiers(index, rowIdentifiers, query);
+        REQUIRE(identifiers
+             == std::vector<int64_t> {5, 10, 1, 6, 11, 2, 7, 12, 3, 8, 4, 9});
+    }
+
+    SECTION("Cursor paging")
+    {
+        CatalogQuery query;
+        query.sortKey = CatalogQuery::SortKey::AuthoritativeMagnitude;
+        query.descending = true;
+        query.pageSize = 5;
+        std::vector<int64_t> identifiers;
+        for (int page = 0; page < 10; ++page)
+        {
+            auto result = index.query(query);
+            REQUIRE(result.totalCount == 12);
+            for (const auto &row : result.rows)
+            {
+                identifiers.push_back(rowIdentifiers.at(row));
+            }
+            if (!result.nextCursor){break;}
+            // The cursor survives the round trip through its token
+            auto token = toCursorToken(query, *result.nextCursor);
+            query.cursor = fromCursorToken(token, query);
+            REQUIRE(*query.cursor == *result.nextCursor);
+        }
+        REQUIRE(identifiers
+             == std::vector<int64_t> {12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1});
+        // A token cannot be used with another sort
+        auto token = toCursorToken(query, *query.cursor);
+        auto otherQuery = query;
+        otherQuery.descending = false;
+        REQUIRE_THROWS_AS(fromCursorToken(token, otherQuery),
+                          std::invalid_argument);
+        REQUIRE_THROWS_AS(fromCursorToken("xyz", query),
+                          std::invalid_argument);
+        REQUIRE_THROWS_AS(fromCursorToken("", query), std::invalid_argument);
+    }
+
+    SECTION("Cursor paging while the catalog changes")
+    {
+        CatalogQuery query;
+        query.sortKey = CatalogQuery::SortKey::ReviewStatus;
+        query.pageSize = 4;
+        auto result = index.query(query);
+        std::vector<int64_t> identifiers;
+        for (const auto &row : result.rows)
+        {
+            identifiers.push_back(rowIdentifiers.at(row));
+        }
+        REQUIRE(identifiers == std::vector<int64_t> {3, 6, 9, 12});
+        REQUIRE(result.nextCursor);
+        // An event ahead of the cursor is added and one is removed
+        index.append(0, createSummary(3));
+        rowIdentifiers.push_back(0);
+        index.erase(2);
+        rowIdentifiers[2] = rowIdentifiers.back();
+        rowIdentifiers.pop_back();
+        query.cursor = result.nextCursor;
+        identifiers.clear();
+        for (const auto &row : index.query(query).rows)
+        {
+            identifiers.push_back(rowIdentifiers.at(row));
+        }
+        // The next page neither repeats nor skips the remaining events
+        REQUIRE(identifiers == std::vector<int64_t> {1, 2, 4, 5});
+    }
+
+    SECTION("Cursor paging with unknown values")
+    {
+        auto summary = createSummary(4);
+        summary.originTime = "unknown";
+        index.update(3, summary);
+        CatalogQuery query;
+        query.sortKey = CatalogQuery::SortKey::OriginTime;
+        query.pageSize = 11;
+        auto result = index.query(query);
+        REQUIRE(result.nextCursor);
+        REQUIRE(result.nextCursor->value);
+        query.cursor = result.nextCursor;
+        result = index.query(query);
+        REQUIRE(result.rows.size() == 1);
+        REQUIRE(rowIdentifiers.at(result.rows[0]) == 4);
+        REQUIRE(!result.nextCursor);
+        // Paging past an unknown value only returns later unknown values
+        query.cursor = CatalogCursor {std::nullopt, "", 4};
+        REQUIRE(index.query(query).rows.empty());
+        query.cursor = CatalogCursor {std::nullopt, "", 3};
+        REQUIRE(index.query(query).rows.size() == 1);
+    }
+
+    SECTION("Update and erase")
+    {
+        auto summary = createSummary(1);
+        summary.reviewStatus = "R";
+        index.update(0, summary);
+        CatalogQuery query;
+        query.reviewStatuses = {"R"};
+        REQUIRE(queryIdentifiers(index, rowIdentifiers, query)
+             == std::vector<int64_t> {1});
+        // The last row moves into the erased row
+        index.erase(0);
+        rowIdentifiers[0] = rowIdentifiers.back();
+        rowIdentifiers.pop_back();
+        REQUIRE(index.size() == 11);
+        REQUIRE(index.query(query).rows.empty());
+        query = CatalogQuery {};
+        query.sortKey = CatalogQuery::SortKey::Identifier;
+        auto identifiers = queryIdentifiers(index, rowIdentifiers, query);
+        REQUIRE(identifiers.size() == 11);
+        REQUIRE(identifiers.front() == 2);
+        REQUIRE(identifiers.back() == 12);
+        REQUIRE_THROWS_AS(index.update(11, summary), std::out_of_range);
+    }
+}
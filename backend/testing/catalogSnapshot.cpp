@@ -0,0 +1,237 @@
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <catch2/catch_test_macros.hpp>
+#include "catalogSnapshot.hpp"
+#include "events.hpp"
+#include "stationNameTable.hpp"
+
+using namespace CCTService;
+
+namespace
+{
+
+Spectrum createSpectrum(const double scale)
+{
+    Spectrum spectrum;
+    spectrum.frequencies = {0.5, 1, 2, 4};
+    spectrum.values = {scale, 2*scale, 3*scale, 4*scale};
+    return spectrum;
+}
+
+Event createEvent(const int64_t identifier,
+                  StationNameTable &stationNames)
+{
+    Event event;
+    auto &summary = event.mSummary;
+    summary.identifier = identifier;
+    summary.originTime = "2024-03-0" + std::to_string(identifier%9 + 1)
+                       + "T12:34:56.789";
+    summary.latitude = 40.5 + 0.01*static_cast<double> (identifier);
+    summary.longitude =-111.9;
+    summary.depth = 7.25;
+    summary.likelyPoorlyConstrained = identifier%2 == 0;
+    summary.cctMagnitude = 2.75;
+    summary.cctMagnitudeType = "w";
+    summary.authoritativeMagnitude = 2.5;
+    summary.authoritativeMagnitudeType = "l";
+    summary.reviewStatus = identifier%2 == 0 ? "A" : "F";
+    summary.creationMode = "automatic";
+    summary.netMagInputs.magnitude = 2.8;
+    summary.netMagInputs.closestDistance = 12.5;
+    summary.netMagInputs.azimuthalGap = 95;
+    summary.netMagInputs.nStations = 2;
+    summary.netMagInputs.nObservations = 8;
+    EventDetails details;
+    details.spectralFit.fit = createSpectrum(1);
+    if (identifier%2 == 1)
+    {
+        details.spectralFit.bruneLowerBound1 = createSpectrum(0.5);
+        details.spectralFit.bruneUpperBound2 = createSpectrum(1.5);
+    }
+    for (const auto &name : {"UU.CTU", "WY.YNR"})
+    {
+        StationMeasurements station;
+        station.station = stationNames.intern(name);
+        station.centerFrequencies = {1, 2};
+        station.values = {0.1*static_cast<double> (identifier), 0.2};
+        station.residuals = {-0.05, 0.05};
+        details.stationMeasurements.push_back(std::move(station));
+    }
+    event.mDetails = std::make_shared<const EventDetails> (std::move(details));
+    event.mLastUpdate = 1709000000.25 + static_cast<double> (identifier);
+    return event;
+}
+
+std::string readFile(const std::filesystem::path &fileName)
+{
+    std::ifstream file(fileName, std::ios::binary);
+    return std::string {std::istreambuf_iterator<char> (file),
+                        std::istreambuf_iterator<char> ()};
+}
+
+void writeFile(const std::filesystem::path &fileName,
+               const std::string &contents)
+{
+    std::ofstream file(fileName, std::ios::binary | std::ios::trunc);
+    file.write(contents.data(), static_cast<std::streamsize> (contents.size()));
+}
+
+/// Replaces the trailing FNV-1a checksum so that only the contents are
+/// invalid.
+std::string reseal(std::string contents)
+{
+    auto payloadLength = contents.size() - sizeof(uint64_t);
+    uint64_t checksum{0xcbf29ce484222325ull};
+    for (size_t i = 0; i < payloadLength; ++i)
+    {
+        checksum = (checksum ^ static_cast<unsigned char> (contents[i]))
+                  *0x100000001b3ull;
+    }
+    std::memcpy(contents.data() + payloadLength, &checksum, sizeof(uint64_t));
+    return contents;
+}
+
+void requireEqual(const std::optional<Spectrum> &lhs,
+                  const std::optional<Spectrum> &rhs)
+{
+    REQUIRE(lhs.has_value() == rhs.has_value());
+    if (!lhs){return;}
+    REQUIRE(lhs->frequencies == rhs->frequencies);
+    REQUIRE(lhs->values == rhs->values);
+}
+
+}
+
+TEST_CASE("CCTService::CatalogSnapshot", "[catalogSnapshot]")
+{
+    auto directory = std::filesystem::temp_directory_path()
+                   / ("cctCatalogSnapshotTest"
+                    + std::to_string(std::hash<std::string> {}
+                      (std::filesystem::current_path().string())));
+    std::filesystem::create_directories(directory);
+    auto fileName = directory / "catalog.bin";
+    auto stationNames = std::make_shared<StationNameTable> ();
+    Events events{stationNames};
+    for (int64_t identifier = 60000001; identifier <= 60000005; ++identifier)
+    {
+        events.insert(std::pair {identifier,
+                                 createEvent(identifier, *stationNames)});
+    }
+    constexpr double lastUpdate{1709000010.5};
+    writeCatalogSnapshot(fileName, events, lastUpdate, *stationNames);
+    REQUIRE(std::filesystem::exists(fileName));
+
+    SECTION("Round trip")
+    {
+        // A different cache interns the stations in a different order
+        auto restoredLocations = std::make_shared<StationNameTable> ();
+        restoredLocations->intern("UU.SRU");
+        auto snapshot = readCatalogSnapshot(fileName, restoredLocations);
+        REQUIRE(snapshot.lastUpdate == lastUpdate);
+        REQUIRE(snapshot.events->size() == events.size());
+        REQUIRE(snapshot.events->getHash() != 0);
+        for (const auto &identifier : events.getIdentifiers())
+        {
+            auto expected = events.at(identifier);
+            auto restored = snapshot.events->at(identifier);
+            REQUIRE(restored->mLightWeightFragment
+                 == expected->mLightWeightFragment);
+            REQUIRE(restored->mCreationTime == expected->mCreationTime);
+            REQUIRE(restored->mLastUpdate == expected->mLastUpdate);
+            const auto &restoredFit = restored->mDetails->spectralFit;
+            const auto &expectedFit = expected->mDetails->spectralFit;
+            requireEqual(restoredFit.fit, expectedFit.fit);
+            requireEqual(restoredFit.bruneLowerBound1,
+                         expectedFit.bruneLowerBound1);
+            requireEqual(restoredFit.bruneUpperBound1,
+                         expectedFit.bruneUpperBound1);
+            requireEqual(restoredFit.bruneLowerBound2,
+                         expectedFit.bruneLowerBound2);
+            requireEqual(restoredFit.bruneUpperBound2,
+                         expectedFit.bruneUpperBound2);
+            const auto &restoredStations
+                = restored->mDetails->stationMeasurements;
+            const auto &expectedStations
+                = expected->mDetails->stationMeasurements;
+            REQUIRE(restoredStations.size() == expectedStations.size());
+            for (size_t i = 0; i < restoredStations.size(); ++i)
+            {
+                REQUIRE(restoredLocations->getName(
+                            restoredStations[i].station)
+                     == stationNames->getName(
+                            expectedStations[i].station));
+                REQUIRE(restoredStations[i].centerFrequencies
+                     == expectedStations[i].centerFrequencies);
+                REQUIRE(restoredStations[i].values
+                     == expectedStations[i].values);
+                REQUIRE(restoredStations[i].residuals
+                     == expectedStations[i].residuals);
+            }
+            REQUIRE(snapshot.events->detailDataToString(identifier)
+                 == events.detailDataToString(identifier));
+        }
+        // The packed buffer round trips identically
+        auto packed = packCatalog(events, lastUpdate, *stationNames);
+        auto unpacked = unpackCatalog(packed.data(), packed.size(),
+                                      *restoredLocations);
+        REQUIRE(unpacked.events.size() == events.size());
+        REQUIRE(unpacked.lastUpdate == lastUpdate);
+    }
+
+    SECTION("Truncated")
+    {
+        auto contents = readFile(fileName);
+        writeFile(fileName, contents.substr(0, contents.size()/2));
+        REQUIRE_THROWS_AS(readCatalogSnapshot(fileName, stationNames),
+                          std::runtime_error);
+        // A valid checksum over a short payload fails while reading
+        auto truncated = contents.substr(0, contents.size()/2)
+                       + std::string(sizeof(uint64_t), '\0');
+        writeFile(fileName, reseal(truncated));
+        REQUIRE_THROWS_AS(readCatalogSnapshot(fileName, stationNames),
+                          std::runtime_error);
+        writeFile(fileName, "");
+        REQUIRE_THROWS_AS(readCatalogSnapshot(fileName, stationNames),
+                          std::runtime_error);
+    }
+
+    SECTION("Bad checksum")
+    {
+        auto contents = readFile(fileName);
+        contents[contents.size()/2] = static_cast<char>
+                                      (contents[contents.size()/2] ^ 0x01);
+        writeFile(fileName, contents);
+        REQUIRE_THROWS_AS(readCatalogSnapshot(fileName, stationNames),
+                          std::runtime_error);
+    }
+
+    SECTION("Wrong format version")
+    {
+        // The version follows the 8 byte magic
+        auto contents = readFile(fileName);
+        uint32_t version;
+        std::memcpy(&version, contents.data() + 8, sizeof(uint32_t));
+        version = version + 1;
+        std::memcpy(contents.data() + 8, &version, sizeof(uint32_t));
+        writeFile(fileName, reseal(contents));
+        REQUIRE_THROWS_AS(readCatalogSnapshot(fileName, stationNames),
+                          std::runtime_error);
+    }
+
+    SECTION("Not a snapshot")
+    {
+        writeFile(fileName, "This is not a catalog snapshot file.");
+        REQUIRE_THROWS_AS(readCatalogSnapshot(fileName, stationNames),
+                          std::runtime_error);
+        REQUIRE_THROWS_AS(readCatalogSnapshot(directory / "missing.bin",
+                                              stationNames),
+                          std::runtime_error);
+        REQUIRE_THROWS_AS(readCatalogSnapshot(fileName, nullptr),
+                          std::invalid_argument);
+    }
+    std::filesystem::remove_all(directory);
+}
@@ -0,0 +1,77 @@
+#include <catch2/catch_test_macros.hpp>
+#include "changeJournal.hpp"
+
+using namespace CCTService;
+
+TEST_CASE("CCTService::ChangeJournal", "[changeJournal]")
+{
+    REQUIRE_THROWS_AS(ChangeJournal {0}, std::invalid_argument);
+    ChangeJournal journal{4};
+    REQUIRE(journal.capacity() == 4);
+    REQUIRE(journal.size() == 0);
+    REQUIRE(journal.getLowWatermark() == 0);
+    REQUIRE(journal.since(0)->empty());
+
+    SECTION("Changes since a sequence")
+    {
+        for (uint64_t sequence = 1; sequence <= 3; ++sequence)
+        {
+            journal.append(Change {sequence,
+                                   static_cast<int64_t> (10*sequence),
+                                   Change::Type::Insert});
+        }
+        auto changes = journal.since(1);
+        REQUIRE(changes);
+        REQUIRE(changes->size() == 2);
+        REQUIRE(changes->at(0).sequence == 2);
+        REQUIRE(changes->at(0).identifier == 20);
+        REQUIRE(changes->at(1).sequence == 3);
+        REQUIRE(journal.since(3)->empty());
+    }
+
+    SECTION("Wrap and low watermark")
+    {
+        for (uint64_t sequence = 1; sequence <= 6; ++sequence)
+        {
+            journal.append(Change {sequence,
+                                   static_cast<int64_t> (sequence),
+                                   Change::Type::Update});
+        }
+        REQUIRE(journal.size() == 4);
+        // Changes 1 and 2 were overwritten
+        REQUIRE(journal.getLowWatermark() == 2);
+        REQUIRE(!journal.since(0));
+        REQUIRE(!journal.since(1));
+        auto changes = journal.since(2);
+        REQUIRE(changes);
+        REQUIRE(changes->size() == 4);
+        for (size_t i = 0; i < changes->size(); ++i)
+        {
+            REQUIRE(changes->at(i).sequence == 3 + i);
+        }
+        REQUIRE(journal.since(5)->size() == 1);
+    }
+
+    SECTION("Reset")
+    {
+        journal.append(Change {1, 1, Change::Type::Insert});
+        journal.reset(8);
+        REQUIRE(journal.size() == 0);
+        REQUIRE(journal.getLowWatermark() == 8);
+        REQUIRE(!journal.since(7));
+        REQUIRE(journal.since(8)->empty());
+    }
+
+    SECTION("Relabel")
+    {
+        journal.reset(10);
+        journal.append(Change {11, 1, Change::Type::Insert});
+        journal.append(Change {12, 2, Change::Type::Erase});
+        journal.relabel(11, 20);
+        auto changes = journal.since(10);
+        REQUIRE(changes->size() == 2);
+        REQUIRE(changes->at(0).sequence == 11);
+        REQUIRE(changes->at(1).sequence == 20);
+        REQUIRE(journal.since(19)->size() == 1);
+    }
+}
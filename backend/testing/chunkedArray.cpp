@@ -0,0 +1,61 @@
+#include <memory>
+#include <string>
+#include <catch2/catch_test_macros.hpp>
+#include "chunkedArray.hpp"
+
+using namespace CCTService;
+
+TEST_CASE("CCTService::ChunkedArray", "[chunkedArray]")
+{
+    // Small chunks so a few elements span several chunks
+    using Array = ChunkedArray<int, 2>;
+    Array array;
+    for (int i = 0; i < 10; ++i){array.push_back(i);}
+    REQUIRE(array.size() == 10);
+    for (int i = 0; i < 10; ++i){REQUIRE(array[i] == i);}
+    REQUIRE(array.back() == 9);
+    REQUIRE_THROWS_AS(array.at(10), std::out_of_range);
+
+    SECTION("Copies share chunks until modified")
+    {
+        auto copy = array;
+        REQUIRE(copy.getNumberOfSharedChunks() == 3);
+        copy.set(5, 50);
+        // Only the chunk holding element 5 was copied
+        REQUIRE(copy.getNumberOfSharedChunks() == 2);
+        REQUIRE(copy[5] == 50);
+        REQUIRE(array[5] == 5);
+        // Modifying an unshared chunk does not copy it again
+        copy.set(4, 40);
+        REQUIRE(copy.getNumberOfSharedChunks() == 2);
+        REQUIRE(array[4] == 4);
+    }
+
+    SECTION("Push and pop on a shared tail")
+    {
+        auto copy = array;
+        copy.push_back(10);
+        copy.pop_back();
+        copy.pop_back();
+        REQUIRE(copy.size() == 9);
+        REQUIRE(copy.back() == 8);
+        REQUIRE(array.size() == 10);
+        REQUIRE(array.back() == 9);
+        copy.resize(4);
+        REQUIRE(copy.size() == 4);
+        REQUIRE(array[8] == 8);
+        copy.resize(6, -1);
+        REQUIRE(copy[3] == 3);
+        REQUIRE(copy[4] ==-1);
+        REQUIRE(copy[5] ==-1);
+        REQUIRE(array[4] == 4);
+    }
+
+    SECTION("Clear")
+    {
+        auto copy = array;
+        copy.clear();
+        REQUIRE(copy.empty());
+        REQUIRE(array.size() == 10);
+    }
+}
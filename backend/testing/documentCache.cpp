@@ -0,0 +1,90 @@
+#include <memory>
+#include <string>
+#include <catch2/catch_test_macros.hpp>
+#include "documentCache.hpp"
+
+using namespace CCTService;
+
+namespace
+{
+std::shared_ptr<const std::string> createDocument(const char value)
+{
+    // Repetitive so the document compresses well
+    return std::make_shared<const std::string> (4096, value);
+}
+}
+
+TEST_CASE("CCTService::DocumentCache", "[documentCache]")
+{
+    // The hot tier holds one document
+    DocumentCache<int> cache(6000, 1024*1024);
+    cache.insert(1, createDocument('a'));
+    REQUIRE(cache.contains(1));
+    REQUIRE(cache.getStatistics().hot.entries == 1);
+
+    SECTION("Cold tier promotion")
+    {
+        cache.insert(2, createDocument('b'));
+        auto statistics = cache.getStatistics();
+        REQUIRE(statistics.hot.entries == 1);
+        if (!haveCompression())
+        {
+            REQUIRE(statistics.cold.entries == 0);
+            REQUIRE(!cache.contains(1));
+            REQUIRE(cache.get(1) == nullptr);
+            return;
+        }
+        // The first document was demoted compressed
+        REQUIRE(statistics.cold.entries == 1);
+        REQUIRE(statistics.coldUncompressedBytes == 4096);
+        REQUIRE(statistics.cold.bytes < 4096);
+        REQUIRE(statistics.getCompressionRatio() > 1);
+        REQUIRE(cache.contains(1));
+        // Reading it expands and promotes it which demotes the second
+        auto document = cache.get(1);
+        REQUIRE(document != nullptr);
+        REQUIRE(*document == *createDocument('a'));
+        statistics = cache.getStatistics();
+        REQUIRE(statistics.decompressions == 1);
+        REQUIRE(statistics.cold.hits == 1);
+        REQUIRE(statistics.cold.misses == 0);
+        REQUIRE(statistics.hot.entries == 1);
+        REQUIRE(statistics.cold.entries == 1);
+        REQUIRE(statistics.coldUncompressedBytes == 4096);
+        // A hot hit does not decompress
+        REQUIRE(*cache.get(1) == *createDocument('a'));
+        REQUIRE(cache.getStatistics().decompressions == 1);
+        REQUIRE(*cache.get(2) == *createDocument('b'));
+        REQUIRE(cache.getStatistics().decompressions == 2);
+        // A key in neither tier misses both
+        REQUIRE(cache.get(3) == nullptr);
+        statistics = cache.getStatistics();
+        REQUIRE(statistics.cold.hits == 2);
+        REQUIRE(statistics.cold.misses == 1);
+    }
+
+    SECTION("Replacing and erasing a cold document")
+    {
+        cache.insert(2, createDocument('b'));
+        // Replacing the cold document must not leave the old one behind
+        cache.insert(1, createDocument('c'));
+        REQUIRE(*cache.get(1) == *createDocument('c'));
+        cache.erase(1);
+        cache.erase(2);
+        REQUIRE(!cache.contains(1));
+        REQUIRE(!cache.contains(2));
+        REQUIRE(cache.get(1) == nullptr);
+        auto statistics = cache.getStatistics();
+        REQUIRE(statistics.hot.entries == 0);
+        REQUIRE(statistics.cold.entries == 0);
+        REQUIRE(statistics.coldUncompressedBytes == 0);
+    }
+
+    SECTION("Shrinking the cold tier")
+    {
+        cache.insert(2, createDocument('b'));
+        cache.setColdCapacity(0);
+        REQUIRE(!cache.contains(1));
+        REQUIRE(cache.getStatistics().coldUncompressedBytes == 0);
+    }
+}
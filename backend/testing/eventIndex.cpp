@@ -0,0 +1,117 @@
+#include <map>
+#include <random>
+#include <vector>
+#include <catch2/catch_test_macros.hpp>
+#include "eventIndex.hpp"
+
+using namespace CCTService;
+
+namespace
+{
+/// The home slot of the identifier in a table with 16 slots.  This mirrors
+/// the index's Fibonacci hash so the tests can force collisions.
+size_t getHomeSlot(const int64_t identifier)
+{
+    auto hash = static_cast<uint64_t> (identifier)*11400714819323198485ull;
+    return static_cast<size_t> (hash >> 32) & 15;
+}
+}
+
+TEST_CASE("CCTService::EventIndex", "[eventIndex]")
+{
+    EventIndex index;
+    REQUIRE(index.size() == 0);
+    REQUIRE(!index.find(1));
+    REQUIRE(!index.erase(1));
+
+    SECTION("Insert, assign, and erase")
+    {
+        index.insertOrAssign(10, 0);
+        index.insertOrAssign(20, 1);
+        REQUIRE(index.size() == 2);
+        REQUIRE(*index.find(10) == 0);
+        REQUIRE(*index.find(20) == 1);
+        index.insertOrAssign(10, 5);
+        REQUIRE(index.size() == 2);
+        REQUIRE(*index.find(10) == 5);
+        REQUIRE(index.erase(10));
+        REQUIRE(!index.contains(10));
+        REQUIRE(index.contains(20));
+        REQUIRE(index.size() == 1);
+        REQUIRE_THROWS_AS(index.insertOrAssign(-1, 0), std::invalid_argument);
+    }
+
+    SECTION("Backward-shift delete under collisions")
+    {
+        // Find identifiers that share a home slot.  Seven entries keep the
+        // table at 16 slots.
+        std::vector<int64_t> colliding;
+        for (int64_t identifier = 0; colliding.size() < 4; ++identifier)
+        {
+            if (getHomeSlot(identifier) == 3){colliding.push_back(identifier);}
+        }
+        std::vector<int64_t> neighbors;
+        for (int64_t identifier = 0; neighbors.size() < 3; ++identifier)
+        {
+            if (getHomeSlot(identifier) == 4){neighbors.push_back(identifier);}
+        }
+        uint32_t row{0};
+        for (const auto &identifier : colliding)
+        {
+            index.insertOrAssign(identifier, row++);
+        }
+        for (const auto &identifier : neighbors)
+        {
+            index.insertOrAssign(identifier, row++);
+        }
+        REQUIRE(index.size() == 7);
+        // Removing the head of the probe sequence must shift the others back
+        REQUIRE(index.erase(colliding[0]));
+        REQUIRE(index.erase(colliding[2]));
+        REQUIRE(!index.contains(colliding[0]));
+        REQUIRE(!index.contains(colliding[2]));
+        REQUIRE(*index.find(colliding[1]) == 1);
+        REQUIRE(*index.find(colliding[3]) == 3);
+        for (size_t i = 0; i < neighbors.size(); ++i)
+        {
+            REQUIRE(*index.find(neighbors[i]) == 4 + i);
+        }
+        REQUIRE(index.size() == 5);
+    }
+
+    SECTION("Matches a map")
+    {
+        std::map<int64_t, uint32_t> reference;
+        std::mt19937 generator{86754};
+        std::uniform_int_distribution<int64_t> identifiers{0, 500};
+        std::bernoulli_distribution doErase{0.4};
+        for (uint32_t i = 0; i < 20000; ++i)
+        {
+            auto identifier = identifiers(generator);
+            if (doErase(generator))
+            {
+                REQUIRE(index.erase(identifier) ==
+                        (reference.erase(identifier) == 1));
+            }
+            else
+            {
+                index.insertOrAssign(identifier, i);
+                reference[identifier] = i;
+            }
+        }
+        REQUIRE(index.size() == reference.size());
+        for (int64_t identifier = 0; identifier <= 500; ++identifier)
+        {
+            auto row = index.find(identifier);
+            if (reference.contains(identifier))
+            {
+                REQUIRE(row);
+                REQUIRE(*row == reference[identifier]);
+            }
+            else
+            {
+                REQUIRE(!row);
+            }
+        }
+    }
+}
@@ -0,0 +1,164 @@
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <vector>
+#include <stdexcept>
+#include <nlohmann/json.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/matchers/catch_matchers_floating_point.hpp>
+#include "geometry.hpp"
+#include "unpackCCTJSON.hpp"
+
+using namespace CCTService;
+using Catch::Matchers::WithinAbs;
+
+namespace
+{
+
+nlohmann::json createEventJSON(const std::string &identifier,
+                               const double stationLatitude,
+                               const double stationLongitude)
+{
+    nlohmann::json measuredMwDetails;
+    measuredMwDetails["mw"] = 2.8;
+    measuredMwDetails["stationCount"] = 2;
+    measuredMwDetails["latitude"] = 40.0;
+    measuredMwDetails["longitude"] =-111.0;
+    auto createMeasurement = [](const std::string &network,
+                                const std::string &station,
+                                const double latitude,
+                                const double longitude)
+    {
+        nlohmann::json measurement;
+        measurement["pathAndSiteCorrected"] = 1.5;
+        auto &stationJSON = measurement["waveform"]["stream"]["station"];
+        stationJSON["networkName"] = network;
+        stationJSON["stationName"] = station;
+        stationJSON["latitude"] = latitude;
+        stationJSON["longitude"] = longitude;
+        return measurement;
+    };
+    nlohmann::json spectraMeasurements = nlohmann::json::array();
+    spectraMeasurements.push_back(
+        createMeasurement("UU", "CTU", stationLatitude, stationLongitude));
+    spectraMeasurements.push_back(
+        createMeasurement("UU", "SRU", 39.0, -111.0));
+    nlohmann::json json;
+    json["measuredMwDetails"][identifier] = measuredMwDetails;
+    json["spectraMeasurements"][identifier] = spectraMeasurements;
+    return json;
+}
+
+double expectedClosestDistance(const std::vector<double> &latitudes,
+                               const std::vector<double> &longitudes)
+{
+    auto geometry
+        = computeSourceStationGeometry(40, -111, latitudes, longitudes,
+                                       GeometryAccuracy::Geodesic);
+    double closest{geometry.distances.at(0)};
+    for (const auto &distance : geometry.distances)
+    {
+        closest = std::min(closest, distance);
+    }
+    return closest*1.e-3;
+}
+
+}
+
+TEST_CASE("CCTService::computeSourceStationGeometry", "[geometry]")
+{
+    // A regional network around a Utah source out to about 1000 km
+    constexpr double sourceLatitude{40.5};
+    constexpr double sourceLongitude{-111.9};
+    std::vector<double> latitudes;
+    std::vector<double> longitudes;
+    for (int i =-8; i <= 8; ++i)
+    {
+        for (int j =-10; j <= 10; ++j)
+        {
+            if (i == 0 && j == 0){continue;}
+            latitudes.push_back(sourceLatitude + 0.95*i);
+            longitudes.push_back(sourceLongitude + 0.95*j);
+        }
+    }
+    auto reference
+        = computeSourceStationGeometry(sourceLatitude, sourceLongitude,
+                                       latitudes, longitudes,
+                                       GeometryAccuracy::Geodesic);
+    auto angleDifference = [](const double lhs, const double rhs)
+    {
+        auto difference = std::abs(lhs - rhs);
+        return std::min(difference, 360 - difference);
+    };
+
+    SECTION("Andoyer-Lambert")
+    {
+        // Within 10 m in distance and 0.1 degrees in azimuth of the geodesic
+        auto geometry
+            = computeSourceStationGeometry(sourceLatitude, sourceLongitude,
+                                           latitudes, longitudes,
+                                           GeometryAccuracy::AndoyerLambert);
+        REQUIRE(geometry.distances.size() == latitudes.size());
+        for (size_t i = 0; i < latitudes.size(); ++i)
+        {
+            REQUIRE_THAT(geometry.distances[i],
+                         WithinAbs(reference.distances[i], 10));
+            REQUIRE(angleDifference(geometry.azimuths[i],
+                                    reference.azimuths[i]) < 0.1);
+            REQUIRE(angleDifference(geometry.backAzimuths[i],
+                                    reference.backAzimuths[i]) < 0.1);
+        }
+        REQUIRE_THAT(computeAzimuthalGap(geometry.backAzimuths),
+                     WithinAbs(computeAzimuthalGap(reference.backAzimuths),
+                               0.1));
+    }
+
+    SECTION("Spherical")
+    {
+        // The sphere is only good to about 0.5 percent
+        auto geometry
+            = computeSourceStationGeometry(sourceLatitude, sourceLongitude,
+                                           latitudes, longitudes,
+                                           GeometryAccuracy::Spherical);
+        for (size_t i = 0; i < latitudes.size(); ++i)
+        {
+            REQUIRE(std::abs(geometry.distances[i] - reference.distances[i])
+                  < 0.005*reference.distances[i]);
+        }
+    }
+
+    SECTION("Invalid latitudes")
+    {
+        REQUIRE_THROWS_AS(computeSourceStationGeometry(91, 0, {0}, {0}),
+                          std::invalid_argument);
+        REQUIRE_THROWS_AS(computeSourceStationGeometry(0, 0, {0, 1}, {0}),
+                          std::invalid_argument);
+    }
+}
+
+TEST_CASE("CCTService::unpackCCTJSONNetMagInputs", "[geometry]")
+{
+    // The two events disagree on where UU.CTU is
+    auto json1 = createEventJSON("1", 40.25, -111.0);
+    auto json2 = createEventJSON("2", 40.75, -111.0);
+    auto expected1 = expectedClosestDistance({40.25, 39.0}, {-111, -111});
+    auto expected2 = expectedClosestDistance({40.75, 39.0}, {-111, -111});
+    REQUIRE(expected1 < expected2);
+
+    auto inputs1 = ::unpackCCTJSONNetMagInputs(json1, "1",
+                                               GeometryAccuracy::Geodesic);
+    auto inputs2 = ::unpackCCTJSONNetMagInputs(json2, "2",
+                                               GeometryAccuracy::Geodesic);
+    // Unpacking the first event again must not see the second's metadata
+    auto inputs1Again
+        = ::unpackCCTJSONNetMagInputs(json1, "1",
+                                      GeometryAccuracy::Geodesic);
+    REQUIRE_THAT(inputs1.closestDistance, WithinAbs(expected1, 1.e-9));
+    REQUIRE_THAT(inputs2.closestDistance, WithinAbs(expected2, 1.e-9));
+    REQUIRE_THAT(inputs1Again.closestDistance, WithinAbs(expected1, 1.e-9));
+    // Both stations are due north and south of the source
+    REQUIRE_THAT(inputs1.azimuthalGap, WithinAbs(180, 1.e-6));
+    REQUIRE_THAT(inputs2.azimuthalGap, WithinAbs(180, 1.e-6));
+    REQUIRE(inputs1.nStations == 2);
+    REQUIRE(inputs1.nObservations == 2);
+}
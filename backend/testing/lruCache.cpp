@@ -0,0 +1,66 @@
+#include <string>
+#include <catch2/catch_test_macros.hpp>
+#include "lruCache.hpp"
+
+using namespace CCTService;
+
+TEST_CASE("CCTService::LRUCache", "[lruCache]")
+{
+    LRUCache<int, std::string> cache(100,
+                                     [](const std::string &value)
+                                     {
+                                         return value.size();
+                                     });
+    REQUIRE(cache.insert(1, std::string(40, 'a')).empty());
+    REQUIRE(cache.insert(2, std::string(40, 'b')).empty());
+    REQUIRE(cache.getStatistics().bytes == 80);
+
+    SECTION("Byte budget eviction")
+    {
+        // Touch 1 so 2 is the least recently used
+        REQUIRE(*cache.get(1) == std::string(40, 'a'));
+        auto evicted = cache.insert(3, std::string(40, 'c'));
+        REQUIRE(evicted.size() == 1);
+        REQUIRE(evicted[0].first == 2);
+        REQUIRE(!cache.contains(2));
+        REQUIRE(cache.contains(1));
+        REQUIRE(cache.contains(3));
+        auto statistics = cache.getStatistics();
+        REQUIRE(statistics.entries == 2);
+        REQUIRE(statistics.bytes == 80);
+        REQUIRE(statistics.capacity == 100);
+        REQUIRE(statistics.evictions == 1);
+        REQUIRE(statistics.hits == 1);
+        // Replacing an entry releases its bytes first
+        REQUIRE(cache.insert(3, std::string(60, 'c')).empty());
+        REQUIRE(cache.getStatistics().bytes == 100);
+    }
+
+    SECTION("Values larger than the budget are not cached")
+    {
+        REQUIRE(cache.insert(3, std::string(101, 'c')).empty());
+        REQUIRE(!cache.contains(3));
+        REQUIRE(!cache.get(3));
+        REQUIRE(cache.getStatistics().misses == 1);
+    }
+
+    SECTION("Shrinking the budget")
+    {
+        auto evicted = cache.setCapacity(50);
+        REQUIRE(evicted.size() == 1);
+        REQUIRE(evicted[0].first == 1);
+        REQUIRE(cache.contains(2));
+        REQUIRE(cache.getStatistics().bytes == 40);
+    }
+
+    SECTION("Extract and erase")
+    {
+        auto value = cache.extract(1);
+        REQUIRE(value);
+        REQUIRE(*value == std::string(40, 'a'));
+        REQUIRE(!cache.extract(1));
+        cache.erase(2);
+        REQUIRE(cache.getStatistics().entries == 0);
+        REQUIRE(cache.getStatistics().bytes == 0);
+    }
+}
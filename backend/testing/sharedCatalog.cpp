@@ -0,0 +1,234 @@
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <catch2/catch_test_macros.hpp>
+#include "sharedCatalog.hpp"
+#include "catalogSnapshot.hpp"
+#include "events.hpp"
+#include "stationNameTable.hpp"
+
+using namespace CCTService;
+
+namespace
+{
+
+Event createEvent(const int64_t identifier,
+                  StationNameTable &stationNames)
+{
+    Event event;
+    auto &summary = event.mSummary;
+    summary.identifier = identifier;
+    summary.originTime = "2024-03-01T12:34:56.789";
+    summary.latitude = 40.5 + 0.01*static_cast<double> (identifier%100);
+    summary.longitude =-111.9;
+    summary.depth = 7.25;
+    summary.cctMagnitude = 2.75;
+    summary.cctMagnitudeType = "w";
+    summary.reviewStatus = identifier%2 == 0 ? "A" : "F";
+    summary.creationMode = "automatic";
+    EventDetails details;
+    details.spectralFit.fit = Spectrum {};
+    details.spectralFit.fit->frequencies = {0.5, 1, 2, 4};
+    details.spectralFit.fit->values = {1, 2, 3, 4};
+    StationMeasurements station;
+    station.station = stationNames.intern("UU.CTU");
+    station.centerFrequencies = {1, 2};
+    station.values = {0.1*static_cast<double> (identifier%100), 0.2};
+    station.residuals = {-0.05, 0.05};
+    details.stationMeasurements.push_back(std::move(station));
+    event.mDetails = std::make_shared<const EventDetails> (std::move(details));
+    event.mLastUpdate = 1709000000.25 + static_cast<double> (identifier%100);
+    return event;
+}
+
+/// Packs a catalog of the given number of events.
+std::string createPackedCatalog(const int nEvents, const double lastUpdate)
+{
+    auto stationNames = std::make_shared<StationNameTable> ();
+    Events events{stationNames};
+    for (int i = 0; i < nEvents; ++i)
+    {
+        int64_t identifier = 60000001 + i;
+        events.insert(std::pair {identifier,
+                                 createEvent(identifier, *stationNames)});
+    }
+    return packCatalog(events, lastUpdate, *stationNames);
+}
+
+/// Each test process gets its own region.
+std::string createRegionName(const std::string &suffix)
+{
+    return "/cctSharedCatalogTest" + std::to_string(::getpid()) + suffix;
+}
+
+}
+
+TEST_CASE("CCTService::SharedCatalog", "[sharedCatalog]")
+{
+    auto smallCatalog = createPackedCatalog(5, 1709000010.5);
+    auto largeCatalog = createPackedCatalog(50, 1709000020.5);
+    auto capacity = largeCatalog.size();
+
+    SECTION("Round trip")
+    {
+        auto name = createRegionName("RoundTrip");
+        SharedCatalogPublisher publisher{name, capacity};
+        REQUIRE(publisher.getName() == name);
+        SharedCatalogSubscriber subscriber{name};
+        REQUIRE_FALSE(subscriber.isStale());
+
+        publisher.publish(smallCatalog, 3, 17);
+        auto version = subscriber.getVersion();
+        REQUIRE(version);
+        REQUIRE(version->first == 3);
+        REQUIRE(version->second == 17);
+        auto view = subscriber.read();
+        REQUIRE(view);
+        REQUIRE(view->epoch == 3);
+        REQUIRE(view->version == 17);
+        REQUIRE(view->packedCatalog == smallCatalog);
+
+        // The second publication goes to the other slot
+        publisher.publish(largeCatalog, 3, 18);
+        view = subscriber.read();
+        REQUIRE(view);
+        REQUIRE(view->version == 18);
+        REQUIRE(view->packedCatalog == largeCatalog);
+        StationNameTable stationNames;
+        auto unpacked = unpackCatalog(view->packedCatalog.data(),
+                                      view->packedCatalog.size(),
+                                      stationNames);
+        REQUIRE(unpacked.events.size() == 50);
+        REQUIRE(unpacked.lastUpdate == 1709000020.5);
+
+        // And the third reuses the first
+        publisher.publish(smallCatalog, 4, 1);
+        view = subscriber.read();
+        REQUIRE(view);
+        REQUIRE(view->epoch == 4);
+        REQUIRE(view->version == 1);
+        REQUIRE(view->packedCatalog == smallCatalog);
+    }
+
+    SECTION("Oversize catalog")
+    {
+        auto name = createRegionName("Oversize");
+        SharedCatalogPublisher publisher{name, smallCatalog.size()};
+        SharedCatalogSubscriber subscriber{name};
+        publisher.publish(smallCatalog, 1, 1);
+        REQUIRE_THROWS_AS(publisher.publish(largeCatalog, 1, 2),
+                          std::invalid_argument);
+        REQUIRE_THROWS_AS(publisher.publish("", 1, 2),
+                          std::invalid_argument);
+        // The rejected catalogs do not replace the published one
+        auto view = subscriber.read();
+        REQUIRE(view);
+        REQUIRE(view->version == 1);
+        REQUIRE(view->packedCatalog == smallCatalog);
+    }
+
+    SECTION("Nothing published")
+    {
+        auto name = createRegionName("Empty");
+        SharedCatalogPublisher publisher{name, capacity};
+        SharedCatalogSubscriber subscriber{name};
+        REQUIRE_FALSE(subscriber.getVersion());
+        REQUIRE_FALSE(subscriber.read());
+        REQUIRE_THROWS_AS(SharedCatalogSubscriber {createRegionName("Missing")},
+                          std::runtime_error);
+    }
+
+    SECTION("Publisher restarted")
+    {
+        auto name = createRegionName("Restart");
+        auto publisher
+            = std::make_unique<SharedCatalogPublisher> (name, capacity);
+        publisher->publish(smallCatalog, 1, 5);
+        SharedCatalogSubscriber subscriber{name};
+        REQUIRE_FALSE(subscriber.isStale());
+        // The old mapping stays readable until it is recreated
+        publisher = std::make_unique<SharedCatalogPublisher> (name, capacity);
+        REQUIRE(subscriber.isStale());
+        auto view = subscriber.read();
+        REQUIRE(view);
+        REQUIRE(view->version == 5);
+        publisher->publish(largeCatalog, 2, 1);
+        SharedCatalogSubscriber recreated{name};
+        REQUIRE_FALSE(recreated.isStale());
+        REQUIRE(recreated.getVersion() == std::pair<uint64_t, uint64_t> {2, 1});
+        // Removing the region also makes the subscriber stale
+        publisher.reset();
+        REQUIRE(recreated.isStale());
+    }
+
+    SECTION("Concurrent publisher and reader")
+    {
+        auto name = createRegionName("Concurrent");
+        SharedCatalogPublisher publisher{name, capacity};
+        publisher.publish(smallCatalog, 1, 1);
+        SharedCatalogSubscriber subscriber{name};
+        constexpr uint64_t nPublications{2000};
+        std::atomic<bool> done{false};
+        std::thread publisherThread([&]()
+        {
+            for (uint64_t version = 2; version <= nPublications; ++version)
+            {
+                publisher.publish(version%2 == 0 ?
+                                  largeCatalog : smallCatalog, 1, version);
+                if (version%16 == 0){std::this_thread::yield();}
+            }
+            done = true;
+        });
+        // Catch2 assertions are not thread safe so tally on this thread
+        int nReads{0};
+        int nCorrupt{0};
+        int nMismatched{0};
+        int nRewound{0};
+        uint64_t lastVersion{0};
+        StationNameTable stationNames;
+        while (!done || nReads == 0)
+        {
+            std::optional<SharedCatalogView> view;
+            try
+            {
+                view = subscriber.read();
+            }
+            catch (const std::runtime_error &)
+            {
+                // The publisher kept overwriting the slot; try again
+                continue;
+            }
+            if (!view){continue;}
+            nReads = nReads + 1;
+            if (view->version < lastVersion){nRewound = nRewound + 1;}
+            lastVersion = view->version;
+            try
+            {
+                auto unpacked = unpackCatalog(view->packedCatalog.data(),
+                                              view->packedCatalog.size(),
+                                              stationNames);
+                // The version identifies which catalog was published
+                auto expected = view->version%2 == 0 ? 50U : 5U;
+                if (unpacked.events.size() != expected)
+                {
+                    nMismatched = nMismatched + 1;
+                }
+            }
+            catch (const std::runtime_error &)
+            {
+                nCorrupt = nCorrupt + 1;
+            }
+        }
+        publisherThread.join();
+        REQUIRE(nReads > 0);
+        REQUIRE(nCorrupt == 0);
+        REQUIRE(nMismatched == 0);
+        REQUIRE(nRewound == 0);
+        auto view = subscriber.read();
+        REQUIRE(view);
+        REQUIRE(view->version == nPublications);
+        REQUIRE(view->packedCatalog == largeCatalog);
+    }
+}
@@ -0,0 +1,106 @@
+#include <atomic>
+#include <future>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include <catch2/catch_test_macros.hpp>
+#include "boundedQueue.hpp"
+#include "workerPool.hpp"
+
+using namespace CCTService;
+
+TEST_CASE("CCTService::BoundedQueue", "[boundedQueue]")
+{
+    REQUIRE_THROWS_AS(BoundedQueue<int> {0}, std::invalid_argument);
+    BoundedQueue<int> queue{2};
+    REQUIRE(queue.capacity() == 2);
+
+    SECTION("First-in first-out")
+    {
+        REQUIRE(queue.push(1));
+        REQUIRE(queue.push(2));
+        REQUIRE(queue.size() == 2);
+        REQUIRE(*queue.pop() == 1);
+        REQUIRE(*queue.pop() == 2);
+        REQUIRE(queue.size() == 0);
+    }
+
+    SECTION("Producer blocks while full")
+    {
+        constexpr int nItems{1000};
+        // Catch2 assertions are not thread-safe so the producer only counts
+        std::atomic<int> nPushed{0};
+        std::thread producer([&queue, &nPushed]()
+                             {
+                                 for (int i = 0; i < nItems; ++i)
+                                 {
+                                     if (queue.push(int {i})){nPushed += 1;}
+                                 }
+                                 queue.close();
+                             });
+        int expected{0};
+        while (auto item = queue.pop())
+        {
+            REQUIRE(queue.size() <= 2);
+            REQUIRE(*item == expected);
+            expected = expected + 1;
+        }
+        producer.join();
+        REQUIRE(nPushed.load() == nItems);
+        REQUIRE(expected == nItems);
+    }
+
+    SECTION("Close drains then wakes")
+    {
+        REQUIRE(queue.push(1));
+        queue.close();
+        REQUIRE(!queue.push(2));
+        REQUIRE(*queue.pop() == 1);
+        REQUIRE(!queue.pop());
+    }
+}
+
+TEST_CASE("CCTService::WorkerPool", "[workerPool]")
+{
+    WorkerPool pool{4, 8};
+    REQUIRE(pool.size() == 4);
+
+    SECTION("Results")
+    {
+        std::vector<std::future<int>> futures;
+        for (int i = 0; i < 100; ++i)
+        {
+            futures.push_back(pool.submit([i]() {return i*i;}));
+        }
+        for (int i = 0; i < 100; ++i)
+        {
+            REQUIRE(futures[i].get() == i*i);
+        }
+    }
+
+    SECTION("Exceptions are returned")
+    {
+        auto future = pool.submit([]() -> int
+                                  {
+                                      throw std::runtime_error("Task failed");
+                                  });
+        REQUIRE_THROWS_AS(future.get(), std::runtime_error);
+        REQUIRE(pool.submit([]() {return 1;}).get() == 1);
+    }
+
+    SECTION("Queued tasks finish on destruction")
+    {
+        std::atomic<int> counter{0};
+        {
+            WorkerPool smallPool{1, 4};
+            for (int i = 0; i < 20; ++i)
+            {
+                (void) smallPool.submit([&counter]()
+                                        {
+                                            counter.fetch_add(1);
+                                        });
+            }
+        }
+        REQUIRE(counter.load() == 20);
+    }
+}
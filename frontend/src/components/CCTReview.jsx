@@ -6,6 +6,7 @@ import TableFit from '/src/components/TableFit';
 import Header from '/src/components/Header';
 import Footer from '/src/components/Footer';
 import getLightWeightEventDataFromAPI from '/src/utilities/getLightWeightDataFromAPI';
+import getEventDetailsFromAPI from '/src/utilities/getEventDetailsFromAPI';
 
 /// Don't need a ton of refreshes - every minute is fine
 const catalogRefreshRate = 60;
@@ -20,16 +21,35 @@ function CCTReview( { userCredentials, onLogout } ) {
   var [settings,         setSettings] = React.useState( {schema: 'production'} );
 
   const canSubmit = userCredentials.permissions === 'read-write' ? true : false;
+  // Numbers the details requests so only the latest one is plotted
+  const latestDetailsRequest = React.useRef(0);
+
+  {/* The catalog only has the table's columns so fetch the spectral fit */}
+  {/* and station measurements of the selected event before plotting it. */}
+  {/* Responses can arrive out of order so a response to anything but the */}
+  {/* latest request is ignored. */}
+  const handleGetEventDetails = (row) => {
+    latestDetailsRequest.current += 1;
+    const detailsRequest = latestDetailsRequest.current;
+    getEventDetailsFromAPI( settings.schema, jsonWebToken, row.eventIdentifier, onLogout ).then( (details) => {
+      if (detailsRequest !== latestDetailsRequest.current) {
+        console.debug(`Ignoring stale details of ${row.eventIdentifier}`);
+        return;
+      }
+      if (details !== null) {
+        setGraphData( {...row, ...details} );
+      }
+    })
+    .catch(error => {
+      console.error(`Failed to get event details from API; failed with ${error}`);
+    });
+  }
 
   const handleGetEvents = () => {
-    getLightWeightEventDataFromAPI( settings.schema, jsonWebToken, onLogout ).then( (result) => {
+    // Have the API sort the events - most recent first
+    const query = { sortBy: 'originTime', sortOrder: 'descending' };
+    getLightWeightEventDataFromAPI( settings.schema, jsonWebToken, onLogout, query ).then( (result) => {
     console.debug(`CCT returned ${result.events.length} events from API`);
-    // Sort the events - most recent first
-    result.events.sort(function (a, b) {
-      if (a.originTime < b.originTime){return +1;}
-      if (a.originTime > b.originTime){return -1;}
-      return 0;
-    }); 
     var rowIndex = 0;
     if (eventIdentifier !== "") {
       for (var i = 0; i < result.events.length; ++i) {
@@ -42,7 +62,7 @@ function CCTReview( { userCredentials, onLogout } ) {
     if (result.events.length > 0) {
       setEvents(result.events);
       setEventIdentifier(result.events[rowIndex].eventIdentifier);
-      setGraphData(result.events[rowIndex]);
+      handleGetEventDetails(result.events[rowIndex]);
     }
     else {
       setEvents([]);
@@ -65,7 +85,7 @@ function CCTReview( { userCredentials, onLogout } ) {
     console.debug(`Updated event identifier from ${temporaryIdentifier} to ${eventIdentifier}`);
     const rowIndex = events.findIndex( (row) => row.eventIdentifier === eventIdentifier );
     if (rowIndex >= 0 && rowIndex < events.length) {
-      setGraphData(events[rowIndex]);
+      handleGetEventDetails(events[rowIndex]);
     }   
   }
 
@@ -1,7 +1,7 @@
 import { jwtDecode } from 'jwt-decode';
 import getEndpoint from '/src/utilities/getEndpoint';
 
-function getLightWeightEventDataFromAPI( schema, jsonToken, handleLogout ) {
+function getLightWeightEventDataFromAPI( schema, jsonToken, handleLogout, query = {} ) {
   { /* console.log(schema); */ }
   { /* console.log(typeof(jsonToken)); */ }
   const decodedToken = jwtDecode(jsonToken);
@@ -23,7 +23,9 @@ function getLightWeightEventDataFromAPI( schema, jsonToken, handleLogout ) {
     'Connection': 'close',
   };  
 
+  { /* query can hold filters, sortBy, sortOrder, cursor, and pageSize */ }
   const requestData = { 
+    ...query,
     requestType: 'cctData',
     schema: schema
   }; 